@@ -0,0 +1,50 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `bench_util.h`                                       //
+//======================================================//
+
+#include "bench_util.h"
+
+#include <cstdio>
+#include <sstream>
+
+/**
+ * @program:     Bench::toJson
+ * @description: This function prints the results as JSON, the keys are always in the same
+ *               order and the numbers have fixed precision, so the output is easy to diff
+ */
+std::string Bench::toJson(const std::vector<Bench::Result>& results) {
+    std::stringstream ss;
+    char number[64];
+    auto fixed = [&number](double v) {
+        std::snprintf(number, sizeof(number), "%.3f", v);
+        return std::string(number);
+    };
+
+    ss << "{\n  \"schema\": 1,\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        ss << (i == 0 ? "\n" : ",\n")
+           << "    {\"name\": \"" << r.name_ << "\""
+           << ", \"engine\": \"" << r.engine_ << "\""
+           << ", \"param\": " << r.param_
+           << ", \"ops\": " << r.ops_
+           << ", \"ns_per_op\": " << fixed(r.ns_per_op_)
+           << ", \"steps_per_s\": " << fixed(r.steps_per_s_)
+           << ", \"allocs_per_op\": " << fixed(r.allocs_per_op_)
+           << ", \"bytes_per_op\": " << fixed(r.bytes_per_op_)
+           << ", \"allocs_by_phase\": {";
+        for (int p = 0; p < Core::kAllocPhaseCount; ++p) {
+            ss << (p == 0 ? "" : ", ") << "\"" << Core::kAllocPhaseName[p] << "\": " 
+               << fixed(r.phase_allocs_per_op_[p]);
+        }
+        ss << "}}";
+    }
+    ss << "\n  ]\n}\n";
+    return ss.str();
+}
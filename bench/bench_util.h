@@ -0,0 +1,104 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <core/alloc_stats.h>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+/**
+ * Work is what one call of a benchmark body has done, ops_ is the unit of ns/op
+ * (a step, a load, a message) and steps_ is the count of executed commands
+ *
+ * @author: AshGrey
+ * @date:   2024-12-22
+ */
+class Work {
+  public:
+    unsigned long long ops_ = 0;
+    unsigned long long steps_ = 0;
+    double untimed_ = 0;    // Seconds of setup in the body, they are not counted
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-22
+ */
+class Result {
+  public:
+    std::string name_;
+    std::string engine_;            // Empty when the benchmark is not about an engine
+    long long param_ = 0;           // Program size, input length... depends on the benchmark
+    unsigned long long ops_ = 0;
+    double ns_per_op_ = 0;
+    double steps_per_s_ = 0;
+    double allocs_per_op_ = 0;
+    double bytes_per_op_ = 0;
+    std::array<double, Core::kAllocPhaseCount> phase_allocs_per_op_ = {};
+};
+
+/**
+ * @program:     Bench::measure
+ * @description: This function runs the body with doubling iterations until it runs longer
+ *               than min_seconds, then keeps the fastest of three runs
+ * @body:        Callable as Work(unsigned long long iterations)
+ */
+template <class Body>
+Result measure(
+    const std::string& name, 
+    const std::string& engine, 
+    long long param, 
+    Body&& body, 
+    double min_seconds
+) {
+    using Clock = std::chrono::steady_clock;
+    unsigned long long iterations = 1;
+
+    auto once = [&](Work& w) {
+        auto begin = Clock::now();
+        w = body(iterations);
+        return std::chrono::duration<double>(Clock::now() - begin).count() - w.untimed_;
+    };
+
+    Work w;
+    while (once(w) < min_seconds && iterations < (1ULL << 40)) {
+        iterations *= 2;
+    }
+
+    // Calibrate the iterations, and then take the best of three runs
+
+    double best = 1e300;
+    Core::AllocStats allocs;
+    for (int r = 0; r < 3; ++r) {
+        Core::AllocStats begin = Core::threadAllocStats();
+        double seconds = once(w);
+        allocs = Core::threadAllocStats() - begin;
+        if (seconds < best) best = seconds;
+    }
+
+    Result result;
+    result.name_ = name;
+    result.engine_ = engine;
+    result.param_ = param;
+    result.ops_ = w.ops_;
+    if (w.ops_ != 0) {
+        result.ns_per_op_ = best * 1e9 / w.ops_;
+        result.allocs_per_op_ = static_cast<double>(allocs.totalCount()) / w.ops_;
+        result.bytes_per_op_ = static_cast<double>(allocs.totalBytes()) / w.ops_;
+        for (int p = 0; p < Core::kAllocPhaseCount; ++p) {
+            result.phase_allocs_per_op_[p] = static_cast<double>(allocs.count_[p]) / w.ops_;
+        }
+    }
+    result.steps_per_s_ = w.steps_ / best;
+    return result;
+}
+
+std::string toJson(const std::vector<Result>& results);
+
+}
+
+#endif
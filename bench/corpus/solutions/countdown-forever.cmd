@@ -0,0 +1,11 @@
+# Forgets to copy the decreased box back, so it loops until the step limit
+inbox
+copyto 1
+inbox
+copyto 0
+copyfrom 0
+outbox
+copyfrom 0
+jumpifzero 3
+sub 1
+jump 5
@@ -0,0 +1,12 @@
+# Checks zero before the output, so 0 is never output
+inbox
+copyto 1
+inbox
+copyto 0
+copyfrom 0
+jumpifzero 3
+outbox
+copyfrom 0
+sub 1
+copyto 0
+jump 5
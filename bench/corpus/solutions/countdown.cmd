@@ -0,0 +1,11 @@
+inbox
+copyto 1
+inbox
+copyto 0
+copyfrom 0
+outbox
+copyfrom 0
+jumpifzero 3
+sub 1
+copyto 0
+jump 5
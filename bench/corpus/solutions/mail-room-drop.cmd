@@ -0,0 +1,5 @@
+# Takes two boxes but outputs only one
+inbox
+inbox
+outbox
+jump 1
@@ -0,0 +1,4 @@
+# Outputs before taking any box
+outbox
+inbox
+jump 1
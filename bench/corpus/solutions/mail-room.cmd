@@ -0,0 +1,3 @@
+inbox
+outbox
+jump 1
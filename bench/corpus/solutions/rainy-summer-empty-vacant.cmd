@@ -0,0 +1,5 @@
+# Adds the vacant 0 before anything is copied to it
+inbox
+add 0
+outbox
+jump 1
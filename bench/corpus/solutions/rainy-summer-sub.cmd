@@ -0,0 +1,7 @@
+# Subs instead of adds
+inbox
+copyto 0
+inbox
+sub 0
+outbox
+jump 1
@@ -0,0 +1,6 @@
+inbox
+copyto 0
+inbox
+add 0
+outbox
+jump 1
@@ -0,0 +1,7 @@
+# `add` is not available in this level, the error happens on loading
+inbox
+copyto 0
+inbox
+add 0
+outbox
+jump 1
@@ -0,0 +1,5 @@
+# Jumps out of the end of command list on the first zero
+inbox
+jumpifzero 5
+outbox
+jump 1
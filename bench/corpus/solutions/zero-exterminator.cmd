@@ -0,0 +1,4 @@
+inbox
+jumpifzero 1
+outbox
+jump 1
@@ -0,0 +1,250 @@
+#include "bench_util.h"
+
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/loader.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// robox-bench : the microbenchmarks of Core hot paths, the result is JSON (see Bench::toJson)
+//
+// Usage : robox-bench [--filter SUBSTRING] [--min-time SECONDS] [--out FILE]
+
+namespace {
+
+constexpr int kNull = Core::Command::SingleCommand::kNullVacant;
+constexpr unsigned long long kKernelStepLimit = 1000000;
+
+/**
+ * Kernel is a small loop whose steps are almost all the same command, so ns/step of
+ * the kernel is the dispatch cost of this command
+ */
+struct Kernel {
+    std::string name_;
+    Core::CommandList cmd_;
+    std::vector<std::int64_t> input_;
+};
+
+std::vector<Kernel> dispatchKernels() {
+    auto repeat = [](Core::CommandList head, const std::string& name, int index, int times, int back) {
+        for (int i = 0; i < times; ++i) head.emplace_back(name, index);
+        head.emplace_back("jump", back);
+        return head;
+    };
+
+    std::vector<Kernel> kernels;
+    kernels.push_back({ "inbox", repeat({}, "inbox", kNull, 8, 1), std::vector<std::int64_t>(kKernelStepLimit, 0) });
+    kernels.push_back({ "outbox", {
+        { "inbox", kNull }, { "copyto", 0 },
+        { "copyfrom", 0 }, { "outbox", kNull }, { "copyfrom", 0 }, { "outbox", kNull },
+        { "copyfrom", 0 }, { "outbox", kNull }, { "copyfrom", 0 }, { "outbox", kNull },
+        { "jump", 3 }
+    }, { 0 } });
+    kernels.push_back({ "add", repeat({ { "inbox", kNull }, { "copyto", 0 } }, "add", 0, 8, 3), { 0 } });
+    kernels.push_back({ "sub", repeat({ { "inbox", kNull }, { "copyto", 0 } }, "sub", 0, 8, 3), { 0 } });
+    kernels.push_back({ "copyto", repeat({ { "inbox", kNull } }, "copyto", 0, 8, 2), { 0 } });
+    kernels.push_back({ "copyfrom", repeat({ { "inbox", kNull }, { "copyto", 0 } }, "copyfrom", 0, 8, 3), { 0 } });
+    kernels.push_back({ "jump", { { "jump", 1 } }, {} });
+    kernels.push_back({ "jumpifzero", { { "inbox", kNull }, { "jumpifzero", 2 } }, { 0 } });
+    return kernels;
+}
+
+Core::Level kernelLevel(const std::vector<std::int64_t>& input) {
+    Core::Level level;
+    level.available_cmd_.assign(Core::Command::kAllCmd.begin(), Core::Command::kAllCmd.end());
+    level.provided_seq_ = input;
+    level.vac_size_ = 1;
+    return level;
+}
+
+Core::CommandList echoProgram(int size) {
+    Core::CommandList cmd;
+    for (int i = 0; i < size; ++i) {
+        cmd.emplace_back(i % 2 == 0 ? "inbox" : "outbox", kNull);
+    }
+    return cmd;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string out;
+    double min_time = 0.2;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << (arg.rfind("--", 0) == 0 ? "Missing value of " : "Unknown option ") << arg << std::endl;
+            return 2;
+        }
+        if (arg == "--filter") filter = argv[++i];
+        else if (arg == "--min-time") {
+            if (!Core::parseNumber(argv[++i], min_time) || min_time < 0) {
+                std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+                return 2;
+            }
+        }
+        else if (arg == "--out") out = argv[++i];
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    Core::setLogEnabled(false);
+
+    std::vector<Bench::Result> results;
+    auto enabled = [&filter](const std::string& name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    };
+
+    // Per-command dispatch cost of every engine
+
+    for (const auto& k : dispatchKernels()) {
+        std::string name = "dispatch/" + k.name_;
+        if (!enabled(name)) continue;
+        Core::Level level = kernelLevel(k.input_);
+
+        // The reference is loaded once, Game::restart refills its input which is not the
+        // dispatch, so restart isn't timed. Every run takes the same steps
+
+        const Core::RunResult first = Core::runEngine(Core::EngineKind::kReferenceEngine, level, k.cmd_, kKernelStepLimit);
+        auto available = level.available_cmd_;
+        std::vector<int> provided(level.provided_seq_.begin(), level.provided_seq_.end());
+        std::vector<int> needed;
+        auto commands = k.cmd_;
+        Core::Game game;
+        game.setStepLimit(kKernelStepLimit);
+        game.initialize(available, provided, needed, commands, level.vac_size_);
+        results.push_back(Bench::measure(name, Core::engineName(Core::EngineKind::kReferenceEngine), k.cmd_.size(),
+            [&](unsigned long long iterations) {
+                Bench::Work w;
+                for (unsigned long long i = 0; i < iterations; ++i) {
+                    auto begin = std::chrono::steady_clock::now();
+                    game.restart();
+                    w.untimed_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                    game.runAll();
+                }
+                w.steps_ = iterations * first.state_.steps_;
+                w.ops_ = w.steps_;
+                return w;
+            }, min_time));
+
+        for (auto kind : Core::kAllEngine) {
+            if (kind == Core::EngineKind::kReferenceEngine) continue;
+            results.push_back(Bench::measure(name, Core::engineName(kind), k.cmd_.size(),
+                [&](unsigned long long iterations) {
+                    Bench::Work w;
+                    for (unsigned long long i = 0; i < iterations; ++i) {
+                        auto r = Core::runEngine(kind, level, k.cmd_, kKernelStepLimit);
+                        w.steps_ += r.state_.steps_;
+                    }
+                    w.ops_ = w.steps_;
+                    return w;
+                }, min_time));
+        }
+    }
+
+    // Loading cost versus program size : Game::initialize and decodeProgram
+
+    for (int size : { 16, 256, 4096 }) {
+        Core::Level level = kernelLevel({});
+        Core::CommandList cmd = echoProgram(size);
+
+        if (enabled("initialize")) {
+            results.push_back(Bench::measure("initialize", "reference", size,
+                [&](unsigned long long iterations) {
+                    for (unsigned long long i = 0; i < iterations; ++i) {
+                        auto available = level.available_cmd_;
+                        std::vector<int> provided(level.provided_seq_.begin(), level.provided_seq_.end());
+                        std::vector<int> needed(level.needed_seq_.begin(), level.needed_seq_.end());
+                        auto commands = cmd;
+                        Core::Game game;
+                        game.initialize(available, provided, needed, commands, level.vac_size_);
+                    }
+                    return Bench::Work{ iterations, 0 };
+                }, min_time));
+            results.push_back(Bench::measure("initialize", "decoded", size,
+                [&](unsigned long long iterations) {
+                    for (unsigned long long i = 0; i < iterations; ++i) {
+                        auto p = Core::decodeProgram(cmd, level.available_cmd_);
+                    }
+                    return Bench::Work{ iterations, 0 };
+                }, min_time));
+        }
+    }
+
+    // Restart cost versus input length, check cost versus output length
+
+    for (int length : { 16, 1024, 65536 }) {
+        std::vector<int> input(length, 1);
+        std::vector<std::string> available = { "inbox", "outbox", "jump" };
+        Core::CommandList cmd = { { "inbox", kNull }, { "outbox", kNull }, { "jump", 1 } };
+
+        auto a = available;
+        auto ps = input;
+        auto ns = input;
+        auto c = cmd;
+        Core::Game game;
+        game.initialize(a, ps, ns, c, 0);
+
+        if (enabled("restart")) {
+            results.push_back(Bench::measure("restart", "reference", length,
+                [&](unsigned long long iterations) {
+                    for (unsigned long long i = 0; i < iterations; ++i) game.restart();
+                    return Bench::Work{ iterations, 0 };
+                }, min_time));
+        }
+
+        if (enabled("check")) {
+            game.restart();
+            game.runAll();
+
+            // The game has ended, so every runAll below is one `inbox` on the empty input
+            // and Game::check on the whole output
+
+            results.push_back(Bench::measure("check", "reference", length,
+                [&](unsigned long long iterations) {
+                    for (unsigned long long i = 0; i < iterations; ++i) game.runAll();
+                    return Bench::Work{ iterations, 0 };
+                }, min_time));
+        }
+    }
+
+    // Throughput of Core::logMessage, it writes the log file in `log/`
+
+    if (enabled("logMessage")) {
+        Core::setLogEnabled(true);
+        Core::initLogFile();
+        results.push_back(Bench::measure("logMessage", "", 0,
+            [&](unsigned long long iterations) {
+                for (unsigned long long i = 0; i < iterations; ++i) {
+                    Core::logMessage(
+                        "Command ID 1 : Robot takes the box (value : 0) from the input.",
+                        Core::LogLocation::kCore,
+                        Core::LogType::kInfo
+                    );
+                }
+                return Bench::Work{ iterations, 0 };
+            }, min_time));
+        Core::setLogEnabled(false);
+    }
+
+    std::string json = Bench::toJson(results);
+    if (out.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(out);
+        file << json;
+        if (!file.flush()) {
+            std::cerr << "Fail to write " << out << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,417 @@
+#include <core/analysis.h>
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/loader.h>
+#include <core/metrics.h>
+#include <core/program_cache.h>
+#include <core/trace.h>
+#include <core/verdict_cache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// robox-corpus-bench : the end-to-end benchmark, every submission of the corpus goes
+// through the whole load-run-verify path (parse level, parse commands, load, run, check).
+//
+// Usage : robox-corpus-bench [--corpus FILE] [--engine NAME] [--repeat N] [--step-limit N]
+//                            [--out FILE] [--baseline FILE] [--max-regression FRACTION]
+//                            [--perf] [--static] [--trace FILE] [--metrics FILE]
+//                            [--metrics-socket PATH] [--cache N] [--cache-file FILE]
+//                            [--program-cache DIR]
+//
+// --perf runs the corpus once more with the hardware counters (see `perf_counters.h`) and
+// reports them per submission and per level, it's skipped when no counter is available.
+// --trace runs it once more with the spans of `trace.h` and writes the timeline to FILE.
+// --metrics writes the metrics of `metrics.h` to FILE at the end, and --metrics-socket
+// serves them on a Unix domain socket while the benchmark runs.
+// --static asks the abstract interpreter of `analysis.h` first, the submissions which
+// must fail get their error without running.
+// --cache keeps the verdicts of N programs in the cache of `verdict_cache.h`, so the repeats
+// after the first one are hits, and --cache-file adds the file tier of that cache.
+// --program-cache compiles the submissions with the cache of `program_cache.h` in DIR, a
+// second benchmark with the same DIR loads them instead.
+// bench/corpus/baseline.json is the reference engine in the default build, the test
+// Corpus-Baseline compares with it.
+//
+// Exit code : 0 OK, 1 slower than the baseline, 2 bad usage or file, 3 wrong verdict
+
+namespace {
+
+bool static_first = false;      // --static
+Core::VerdictCache* verdict_cache = nullptr;
+Core::ProgramCache* program_cache = nullptr;
+
+struct Submission {
+    std::string level_path_;
+    std::string solution_path_;
+    std::string expected_;      // success, fail or error
+    std::string level_text_;    // The files are read once, parsing is measured
+    std::string solution_text_;
+    std::vector<double> latency_ns_;
+    Core::PerfSample perf_;
+};
+
+std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+/**
+ * @program:     judge
+ * @description: This function is the load-run-verify path of one submission
+ * @return:      "success", "fail" or "error"
+ */
+std::string judge(
+    Core::EngineKind kind, 
+    const Submission& s, 
+    unsigned long long step_limit, 
+    Core::PerfSample* perf = nullptr
+) {
+    std::stringstream level_stream(s.level_text_);
+    std::stringstream solution_stream(s.solution_text_);
+    auto level = Core::parseLevel(level_stream);
+    auto cmd = Core::parseCommands(solution_stream);
+    if (!level || !cmd) return "error";
+    if (static_first && Core::staticVerdict(*level, *cmd, step_limit)) return "error";
+
+    std::shared_ptr<const Core::CompiledProgram> compiled;
+    if (program_cache != nullptr && kind != Core::EngineKind::kReferenceEngine) {
+        auto c = program_cache->compile(*cmd, level->available_cmd_);
+        if (!c) return "error";
+        compiled = std::move(*c);
+    }
+    if (verdict_cache != nullptr && perf == nullptr) {
+        Core::CachedVerdict v = Core::runCached(*verdict_cache, kind, *level, *cmd, step_limit, compiled.get());
+        if (!v.verdict_) return "error";
+        return *v.verdict_ == Core::Verdict::kSuccess ? "success" : "fail";
+    }
+
+    // The profiling pass always runs, the counters of a hit would be empty
+
+    Core::RunResult r = Core::runEngine(kind, *level, *cmd, step_limit, compiled.get());
+    if (perf != nullptr) *perf += r.perf_;
+    if (!r.verdict_) return "error";
+    return *r.verdict_ == Core::Verdict::kSuccess ? "success" : "fail";
+}
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, static_cast<std::size_t>(p * v.size()))];
+}
+
+/**
+ * @program:     readBaselineNumber
+ * @description: This function reads a number of the top level from the JSON written by
+ *               this tool, it's not a JSON parser, only our own output is expected
+ * @return:      Nothing when the key is missing or its value isn't a positive number
+ */
+std::optional<double> readBaselineNumber(const std::string& json, const std::string& key) {
+    auto pos = json.find("\"" + key + "\":");
+    if (pos == std::string::npos) return std::nullopt;
+    pos = json.find_first_not_of(' ', pos + key.size() + 3);
+    if (pos == std::string::npos) return std::nullopt;
+    double value = 0;
+    if (!Core::parseNumber(std::string_view(json).substr(pos, json.find_first_of(",}\n", pos) - pos), value)) {
+        return std::nullopt;
+    }
+    if (!(value > 0)) return std::nullopt;
+    return value;
+}
+
+/**
+ * @program:     perfJson
+ * @description: This function prints the counters per run, and the instructions per cycle
+ *               and branch misses per thousand instructions which tell dispatch from memory.
+ *               A multiplexed sample is marked, its values are scaled
+ */
+std::string perfJson(const Core::PerfSample& p) {
+    if (!p.anyValid() || p.runs_ == 0) return "null";
+
+    std::stringstream ss;
+    char number[64];
+    auto fixed = [&number](double v) {
+        std::snprintf(number, sizeof(number), "%.3f", v);
+        return std::string(number);
+    };
+    auto per_run = [&p](int e) { return static_cast<double>(p.value_[e]) / p.runs_; };
+
+    ss << "{\"runs\": " << p.runs_;
+    for (int e = 0; e < Core::kPerfEventCount; ++e) {
+        ss << ", \"" << Core::kPerfEventName[e] << "\": " << (p.valid_[e] ? fixed(per_run(e)) : "null");
+    }
+    if (p.valid_[Core::kPerfCycles] && p.valid_[Core::kPerfInstructions] && p.value_[Core::kPerfCycles] != 0) {
+        ss << ", \"ipc\": " << fixed(per_run(Core::kPerfInstructions) / per_run(Core::kPerfCycles));
+    }
+    if (p.valid_[Core::kPerfBranchMisses] && p.valid_[Core::kPerfInstructions] && p.value_[Core::kPerfInstructions] != 0) {
+        ss << ", \"branch_misses_per_kinst\": " 
+           << fixed(1000.0 * p.value_[Core::kPerfBranchMisses] / p.value_[Core::kPerfInstructions]);
+    }
+    if (p.multiplexed_) ss << ", \"multiplexed\": true";
+    ss << "}";
+    return ss.str();
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::filesystem::path corpus = "bench/corpus/corpus.txt";
+    std::string engine = "reference";
+    std::string out;
+    std::string baseline;
+    int repeat = 10;
+    unsigned long long step_limit = 1000000;
+    double max_regression = 0.10;
+    bool perf = false;
+    std::string trace;
+    std::string metrics;
+    std::string metrics_socket;
+    std::size_t cache_capacity = 0;
+    std::string cache_file;
+    std::string program_dir;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--perf") {
+            perf = true;
+            continue;
+        }
+        if (arg == "--static") {
+            static_first = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--corpus") corpus = argv[++i];
+        else if (arg == "--engine") engine = argv[++i];
+        else if (arg == "--repeat") ok = Core::parseNumber(argv[++i], repeat) && repeat > 0;
+        else if (arg == "--step-limit") ok = Core::parseNumber(argv[++i], step_limit);
+        else if (arg == "--out") out = argv[++i];
+        else if (arg == "--baseline") baseline = argv[++i];
+        else if (arg == "--max-regression") ok = Core::parseNumber(argv[++i], max_regression) && max_regression >= 0;
+        else if (arg == "--trace") trace = argv[++i];
+        else if (arg == "--metrics") metrics = argv[++i];
+        else if (arg == "--metrics-socket") metrics_socket = argv[++i];
+        else if (arg == "--cache") ok = Core::parseNumber(argv[++i], cache_capacity);
+        else if (arg == "--cache-file") cache_file = argv[++i];
+        else if (arg == "--program-cache") program_dir = argv[++i];
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    auto kind = std::find_if(Core::kAllEngine.begin(), Core::kAllEngine.end(), [&](auto k) {
+        return Core::engineName(k) == engine;
+    });
+    if (kind == Core::kAllEngine.end()) {
+        std::cerr << "Unknown engine " << engine << std::endl;
+        return 2;
+    }
+
+    std::ifstream manifest(corpus);
+    if (!manifest.is_open()) {
+        std::cerr << "Fail to open corpus " << corpus << std::endl;
+        return 2;
+    }
+
+    std::vector<Submission> submissions;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::stringstream ss(line.substr(0, line.find('#')));
+        Submission s;
+        if (!(ss >> s.level_path_ >> s.solution_path_ >> s.expected_)) continue;
+        s.level_text_ = readFile(corpus.parent_path() / s.level_path_);
+        s.solution_text_ = readFile(corpus.parent_path() / s.solution_path_);
+        submissions.push_back(std::move(s));
+    }
+
+    Core::setLogEnabled(false);
+
+    std::optional<Core::VerdictCache> cache;
+    if (cache_capacity != 0 || !cache_file.empty()) {
+        cache.emplace(std::max<std::size_t>(cache_capacity, 1));
+        if (!cache_file.empty() && !cache->openFile(cache_file)) {
+            std::cerr << "Fail to map cache " << cache_file << std::endl;
+            return 2;
+        }
+        verdict_cache = &*cache;
+    }
+    std::optional<Core::ProgramCache> programs;
+    if (!program_dir.empty()) {
+        programs.emplace(program_dir);
+        program_cache = &*programs;
+    }
+
+    Core::MetricsServer server;
+    if (!metrics_socket.empty() && !server.start(metrics_socket)) {
+        std::cerr << "Fail to listen on " << metrics_socket << std::endl;
+        return 2;
+    }
+
+    // Run every submission once to check the verdicts, a benchmark of wrong answers is useless
+
+    int wrong = 0;
+    for (const auto& s : submissions) {
+        std::string verdict = judge(*kind, s, step_limit);
+        if (verdict != s.expected_) {
+            std::cerr << s.solution_path_ << " : expected " << s.expected_ << " but got " << verdict << std::endl;
+            wrong++;
+        }
+    }
+    if (wrong != 0) return 3;
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> all_ns;
+    double total_seconds = 0;
+
+    for (int r = 0; r < repeat; ++r) {
+        Core::setMetric(Core::MetricGauge::kMetricQueueDepth, submissions.size());
+        for (auto& s : submissions) {
+            Core::addMetric(Core::MetricGauge::kMetricQueueDepth, -1);
+            auto begin = Clock::now();
+            judge(*kind, s, step_limit);
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+            s.latency_ns_.push_back(ns);
+            all_ns.push_back(ns);
+            total_seconds += ns * 1e-9;
+        }
+    }
+
+    // Profile in another pass, so the syscalls of counters don't change the latency
+
+    std::map<std::string, Core::PerfSample> level_perf;
+    if (perf && !Core::threadPerfCounters().available()) {
+        std::cerr << "Hardware counters are not available here, skip --perf" << std::endl;
+        perf = false;
+    }
+    if (perf) {
+        Core::setPerfEnabled(true);
+        for (int r = 0; r < repeat; ++r) {
+            for (auto& s : submissions) judge(*kind, s, step_limit, &s.perf_);
+        }
+        Core::setPerfEnabled(false);
+        for (const auto& s : submissions) level_perf[s.level_path_] += s.perf_;
+    }
+
+    if (!trace.empty()) {
+        Core::startTrace(trace);
+        for (const auto& s : submissions) {
+            Core::TraceSpan span("judge", "judge");
+            judge(*kind, s, step_limit);
+        }
+        if (!Core::stopTrace()) {
+            std::cerr << "Fail to write trace " << trace << std::endl;
+            return 2;
+        }
+    }
+
+    double submissions_per_s = all_ns.size() / total_seconds;
+    double p50 = percentile(all_ns, 0.50);
+    double p99 = percentile(all_ns, 0.99);
+
+    std::stringstream json;
+    char number[64];
+    auto fixed = [&number](double v) {
+        std::snprintf(number, sizeof(number), "%.3f", v);
+        return std::string(number);
+    };
+
+    json << "{\n  \"schema\": 1,\n  \"engine\": \"" << engine << "\""
+         << ",\n  \"submissions\": " << submissions.size()
+         << ",\n  \"repeat\": " << repeat
+         << ",\n  \"submissions_per_s\": " << fixed(submissions_per_s)
+         << ",\n  \"p50_ns\": " << fixed(p50)
+         << ",\n  \"p99_ns\": " << fixed(p99)
+         << ",\n  \"per_submission\": [";
+    for (std::size_t i = 0; i < submissions.size(); ++i) {
+        const auto& s = submissions[i];
+        json << (i == 0 ? "\n" : ",\n")
+             << "    {\"solution\": \"" << s.solution_path_ << "\""
+             << ", \"verdict\": \"" << s.expected_ << "\""
+             << ", \"p50_ns\": " << fixed(percentile(s.latency_ns_, 0.50))
+             << ", \"p99_ns\": " << fixed(percentile(s.latency_ns_, 0.99));
+        if (perf) json << ", \"perf\": " << perfJson(s.perf_);
+        json << "}";
+    }
+    json << "\n  ]";
+    if (perf) {
+        json << ",\n  \"per_level\": [";
+        bool first = true;
+        for (const auto& [level, p] : level_perf) {
+            json << (first ? "\n" : ",\n") 
+                 << "    {\"level\": \"" << level << "\", \"perf\": " << perfJson(p) << "}";
+            first = false;
+        }
+        json << "\n  ]";
+    }
+    json << "\n}\n";
+
+    if (out.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(out);
+        file << json.str();
+        if (!file.flush()) {
+            std::cerr << "Fail to write " << out << std::endl;
+            return 2;
+        }
+    }
+
+    if (!metrics.empty() && !Core::writeMetrics(metrics)) {
+        std::cerr << "Fail to write metrics " << metrics << std::endl;
+        return 2;
+    }
+
+    if (baseline.empty()) return 0;
+
+    std::string base = readFile(baseline);
+    if (base.empty()) {
+        std::cerr << "Fail to read baseline " << baseline << std::endl;
+        return 2;
+    }
+
+    // Compare with the baseline, throughput may not drop and latency may not grow
+    // more than max_regression. A baseline without one of the numbers isn't ours, or is
+    // broken, so it fails instead of passing without a comparison
+
+    bool regressed = false, bad_baseline = false;
+    auto compare = [&](const std::string& key, double now, bool higher_is_better) {
+        std::optional<double> before = readBaselineNumber(base, key);
+        if (!before) {
+            std::cerr << "Baseline " << baseline << " has no valid " << key << std::endl;
+            bad_baseline = true;
+            return;
+        }
+        double change = higher_is_better ? (*before - now) / *before : (now - *before) / *before;
+        std::cerr << key << " : baseline " << fixed(*before) << ", now " << fixed(now)
+                  << ", regression " << fixed(change * 100) << "%" << std::endl;
+        if (change > max_regression) regressed = true;
+    };
+    compare("submissions_per_s", submissions_per_s, true);
+    compare("p50_ns", p50, false);
+    compare("p99_ns", p99, false);
+
+    if (bad_baseline) return 2;
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,375 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `fuzz_case.h`                                        //
+//======================================================//
+
+#include "fuzz_case.h"
+
+#include <core/analysis.h>
+#include <core/expected_output.h>
+#include <core/input_source.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+/**
+ * @program:     Fuzz::FuzzCase::decode
+ * @description: This function reads a fuzz case from bytes, missing bytes are read as 0,
+ *               so every byte string is a valid case
+ */
+Fuzz::FuzzCase Fuzz::FuzzCase::decode(const std::uint8_t* data, std::size_t size) {
+    Fuzz::FuzzCase c;
+    std::size_t pos = 0;
+    auto next = [&]() -> std::uint8_t { return pos < size ? data[pos++] : 0; };
+
+    c.vac_ = next();
+    c.avail_ = next();
+    c.mode_ = next();
+    std::size_t input_len = next() % (kMaxInput + 1);
+    for (std::size_t i = 0; i < input_len && pos < size; ++i) {
+        c.input_.push_back(next());
+    }
+    while (pos + 1 < size) {
+        c.cmd_.push_back(next());
+        c.cmd_.push_back(next());
+    }
+    return c;
+}
+
+/**
+ * @program:     Fuzz::FuzzCase::encode
+ * @description: This function writes the fuzz case to bytes, decode(encode()) is the same case
+ */
+std::vector<std::uint8_t> Fuzz::FuzzCase::encode() const {
+    std::vector<std::uint8_t> data = {
+        vac_, avail_, mode_, static_cast<std::uint8_t>(input_.size())
+    };
+    data.insert(data.end(), input_.begin(), input_.end());
+    data.insert(data.end(), cmd_.begin(), cmd_.end());
+    return data;
+}
+
+/**
+ * @program:     Fuzz::FuzzCase::toLevel
+ * @description: This function builds the level of fuzz case
+ */
+Core::Level Fuzz::FuzzCase::toLevel() const {
+    Core::Level level;
+    level.vac_size_ = vac_ % (kMaxVacant + 1);
+
+    for (std::size_t i = 0; i < Core::Command::kAllCmd.size(); ++i) {
+        if (avail_ < 224 || (avail_ >> i & 1)) {
+            level.available_cmd_.push_back(Core::Command::kAllCmd[i]);
+        }
+    }
+
+    for (auto b : input_) {
+        level.provided_seq_.push_back(static_cast<std::int8_t>(b) % 10);
+    }
+
+    if (mode_ % 3 == 0) {
+        level.needed_seq_ = level.provided_seq_;
+    } else if (mode_ % 3 == 1) {
+        level.needed_seq_.assign(level.provided_seq_.rbegin(), level.provided_seq_.rend());
+    }
+    if (mode_ / 3 % 8 == 1) level.value_kind_ = Core::ValueKind::kValue16;
+    if (mode_ / 3 % 8 == 2) level.value_kind_ = Core::ValueKind::kValue64;
+    return level;
+}
+
+/**
+ * @program:     Fuzz::FuzzCase::toCommands
+ * @description: This function builds the commands of fuzz case. The operands are mostly in
+ *               range, but out of range and negative ones are also generated for the error paths
+ */
+Core::CommandList Fuzz::FuzzCase::toCommands() const {
+    Core::CommandList cmd;
+    const int vs = vac_ % (kMaxVacant + 1);
+    const int n = cmd_.size() / 2;
+
+    for (std::size_t i = 0; i + 1 < cmd_.size(); i += 2) {
+        int op = cmd_[i] % Core::Command::kAllCmd.size();
+        std::uint8_t b = cmd_[i + 1];
+        int operand;
+
+        switch (op) {
+        case Core::Opcode::kInbox :
+        case Core::Opcode::kOutbox :
+            operand = (b < 224) ? Core::Command::SingleCommand::kNullVacant : b % (vs + 1);
+            break;
+        case Core::Opcode::kJump :
+        case Core::Opcode::kJumpifzero :
+            operand = (b < 240) ? b % (n + 2) : static_cast<std::int8_t>(b);
+            break;
+        default :
+            operand = (b < 240) ? b % (vs + 1) : static_cast<std::int8_t>(b);
+        }
+        cmd.emplace_back(Core::Command::kAllCmd[op], operand);
+    }
+    return cmd;
+}
+
+/**
+ * @program:     Fuzz::FuzzCase::dump
+ * @description: This function prints the fuzz case in a readable form for the report
+ */
+std::string Fuzz::FuzzCase::dump() const {
+    Core::Level level = toLevel();
+    std::stringstream ss;
+
+    ss << "vacant " << level.vac_size_ << "\navailable";
+    for (const auto& a : level.available_cmd_) ss << ' ' << a;
+    ss << "\ninput";
+    for (auto e : level.provided_seq_) ss << ' ' << e;
+    ss << "\nneeded";
+    for (auto e : level.needed_seq_) ss << ' ' << e;
+    ss << '\n';
+    if (level.value_kind_ == Core::ValueKind::kValue16) ss << "value int16\n";
+    if (level.value_kind_ == Core::ValueKind::kValue64) ss << "value int64\n";
+
+    int id = 1;
+    for (const auto& [name, index] : toCommands()) {
+        ss << id++ << ": " << name;
+        if (index != Core::Command::SingleCommand::kNullVacant) ss << ' ' << index;
+        ss << '\n';
+    }
+    return ss.str();
+}
+
+/**
+ * @program:     overflowsInt16
+ * @description: This function runs a typed level on int16
+ * @return:      The run when it fails with kValueOverflow, or nothing
+ */
+static std::optional<Core::RunResult> overflowsInt16(
+    const Core::Level& level,
+    const Core::CommandList& cmd,
+    unsigned long long step_limit
+) {
+    if (level.value_kind_ == Core::ValueKind::kValue32) return std::nullopt;
+    Core::Level narrow_level = level;
+    narrow_level.value_kind_ = Core::ValueKind::kValue16;
+    Core::RunResult narrow = Core::runEngine(Core::EngineKind::kDecodedEngine, narrow_level, cmd, step_limit);
+    if (narrow.verdict_ || narrow.verdict_.error().code_ != Core::DiagnosticCode::kValueOverflow) {
+        return std::nullopt;
+    }
+    return narrow;
+}
+
+/**
+ * @program:     checkOverflow
+ * @description: This function checks the overflow of a run on int16 with the run on int64 :
+ *               stopped just before the command which overflows, the int64 run is in the
+ *               same state, and one step later its handbox is out of the range of int16
+ * @narrow:      The run of level on int16, it failed with kValueOverflow
+ * @return:      The description of the mismatch, or nothing when the overflow is real
+ */
+static std::optional<std::string> checkOverflow(
+    const Core::Level& level,
+    const Core::CommandList& cmd,
+    const Core::RunResult& narrow
+) {
+    Core::Level wide = level;
+    wide.value_kind_ = Core::ValueKind::kValue64;
+    const unsigned long long steps = narrow.state_.steps_;
+    const Core::Diagnostic limit{ Core::DiagnosticCode::kStepLimitExceeded, narrow.state_.ref_, 0 };
+
+    Core::RunResult before = Core::runEngine(Core::EngineKind::kDecodedEngine, wide, cmd, steps);
+    if (before.verdict_ != std::unexpected(limit) || before.state_ != narrow.state_) {
+        return "int16 : the state before the overflow disagrees with int64";
+    }
+    Core::RunResult after = Core::runEngine(Core::EngineKind::kDecodedEngine, wide, cmd, steps + 1);
+    const int box = after.state_.handbox_;
+    if (box >= std::numeric_limits<std::int16_t>::min() && box <= std::numeric_limits<std::int16_t>::max()) {
+        return "int16 : overflow of " + std::to_string(box) + ", which fits int16";
+    }
+    return std::nullopt;
+}
+
+/**
+ * @program:     Fuzz::compareEngines
+ * @description: This function runs the fuzz case on every engine and compares them with
+ *               the reference engine
+ * @return:      The description of the first mismatch, or nothing when all engines agree
+ */
+std::optional<std::string> Fuzz::compareEngines(const Fuzz::FuzzCase& c, unsigned long long step_limit) {
+    Core::Level level = c.toLevel();
+    Core::CommandList cmd = c.toCommands();
+    Core::RunResult ref = Core::runEngine(Core::EngineKind::kReferenceEngine, level, cmd, step_limit);
+
+    if (auto fault = Core::staticVerdict(level, cmd, step_limit)) {
+        if (ref.verdict_ || ref.verdict_.error() != *fault) {
+            return "static analysis : says `" + Core::describeDiagnostic(*fault) +
+                   "` but reference disagrees";
+        }
+    }
+
+    // The abstract interpreter only answers when the error is certain
+
+    // Every engine but the reference runs a typed level on its value type. When the level
+    // doesn't overflow int16, no box ever leaves int16, so the reference can't tell the
+    // value types apart and every engine must agree with it. Otherwise the reference may
+    // have wrapped, and only the overflow itself is checked
+
+    if (auto narrow = overflowsInt16(level, cmd, step_limit)) {
+        return checkOverflow(level, cmd, *narrow);
+    }
+
+    for (auto kind : Core::kAllEngine) {
+        if (kind == Core::EngineKind::kReferenceEngine) continue;
+
+        Core::RunResult r = Core::runEngine(kind, level, cmd, step_limit);
+        std::string name = Core::engineName(kind);
+
+        if (r.verdict_.has_value() != ref.verdict_.has_value()) {
+            return name + " : verdict and error disagree with reference";
+        }
+        if (!r.verdict_ && r.verdict_.error() != ref.verdict_.error()) {
+            return name + " : error disagrees with reference, reference says `" +
+                   Core::describeDiagnostic(ref.verdict_.error()) + "` but engine says `" +
+                   Core::describeDiagnostic(r.verdict_.error()) + "`";
+        }
+        if (r.verdict_ && *r.verdict_ != *ref.verdict_) {
+            return name + " : verdict disagrees with reference";
+        }
+        if (r.state_.output_ != ref.state_.output_) {
+            return name + " : output disagrees with reference";
+        }
+        if (r.profile_ != ref.profile_) {
+            return name + " : profile disagrees with reference";
+        }
+        if (r.narrowed_) {
+            return name + " : narrowed the state of a run whose boxes fit int16";
+        }
+        if (r.state_ != ref.state_) {
+            return name + " : final state disagrees with reference (ref " +
+                   std::to_string(ref.state_.ref_) + " / " + std::to_string(r.state_.ref_) +
+                   ", steps " + std::to_string(ref.state_.steps_) + " / " +
+                   std::to_string(r.state_.steps_) + ")";
+        }
+    }
+
+    // A quarter of the levels are widened past kDenseVacant, so the engines run them on the
+    // sparse vacant, and they and the analysis are compared with the reference on the same
+    // level. The reference allocates the whole vacant, so not every case pays for it
+
+    if (c.mode_ >= 192) {
+        Core::Level wide = level;
+        wide.vac_size_ += Core::kDenseVacant + 1;
+        if (auto narrow = overflowsInt16(wide, cmd, step_limit)) {
+            return checkOverflow(wide, cmd, *narrow);
+        }
+        Core::RunResult wide_ref = Core::runEngine(Core::EngineKind::kReferenceEngine, wide, cmd, step_limit);
+        if (auto fault = Core::staticVerdict(wide, cmd, step_limit)) {
+            if (wide_ref.verdict_ || wide_ref.verdict_.error() != *fault) {
+                return "static analysis : says `" + Core::describeDiagnostic(*fault) +
+                       "` on the sparse vacant but reference disagrees";
+            }
+        }
+        for (auto kind : Core::kAllEngine) {
+            if (kind == Core::EngineKind::kReferenceEngine) continue;
+            Core::RunResult r = Core::runEngine(kind, wide, cmd, step_limit);
+            if (r.verdict_ != wide_ref.verdict_ || r.state_ != wide_ref.state_ || r.profile_ != wide_ref.profile_) {
+                return Core::engineName(kind) + " : verdict or final state of the sparse vacant disagrees with reference";
+            }
+        }
+    }
+
+    // The streamed input is checked with tiny chunks, so the prefetched chunks are handed
+    // over many times in a run
+
+    if (auto p = Core::decodeProgram(cmd, level.available_cmd_)) {
+        Core::InputConveyor input(std::make_unique<Core::SequenceInput>(level.provided_seq_), 2);
+        Core::Machine m;
+        m.reset(level.vac_size_);
+        auto verdict = Core::runStreamed(*p, level, input, nullptr, m, step_limit);
+        if (verdict != ref.verdict_ || m != ref.state_) {
+            return "streamed : verdict or final state disagrees with reference";
+        }
+
+        Core::InputConveyor checked_input(std::make_unique<Core::SequenceInput>(level.provided_seq_), 2);
+        Core::ExpectedOutput expected = Core::ExpectedOutput::fromSequence(level.needed_seq_);
+        m.reset(level.vac_size_);
+        if (Core::runStreamed(*p, level, checked_input, &expected, m, step_limit) != ref.verdict_) {
+            return "streamed : verdict of the expected output disagrees with reference";
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @program:     Fuzz::minimizeCase
+ * @description: This function shrinks a failing case greedily : drops commands and boxes,
+ *               shrinks the vacant and simplifies bytes, as long as the engines still disagree
+ * @c:           The failing case
+ * @step_limit:  The same step limit which makes the case fail
+ */
+Fuzz::FuzzCase Fuzz::minimizeCase(const Fuzz::FuzzCase& c, unsigned long long step_limit) {
+    Fuzz::FuzzCase best = c;
+    auto fails = [step_limit](const Fuzz::FuzzCase& t) {
+        return compareEngines(t, step_limit).has_value();
+    };
+    auto tryCase = [&](const Fuzz::FuzzCase& t) {
+        if (t.encode() != best.encode() && fails(t)) {
+            best = t;
+            return true;
+        }
+        return false;
+    };
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+
+        for (int i = static_cast<int>(best.cmd_.size()) / 2 - 1; i >= 0; --i) {
+            Fuzz::FuzzCase t = best;
+            t.cmd_.erase(t.cmd_.begin() + 2 * i, t.cmd_.begin() + 2 * i + 2);
+            progress |= tryCase(t);
+        }
+
+        // Drop commands one by one from the end
+
+        for (int i = static_cast<int>(best.input_.size()) - 1; i >= 0; --i) {
+            Fuzz::FuzzCase t = best;
+            t.input_.erase(t.input_.begin() + i);
+            progress |= tryCase(t);
+        }
+
+        // Drop boxes of input
+
+        for (std::uint8_t v = 0; v < best.vac_ % (Fuzz::FuzzCase::kMaxVacant + 1); ++v) {
+            Fuzz::FuzzCase t = best;
+            t.vac_ = v;
+            if (tryCase(t)) {
+                progress = true;
+                break;
+            }
+        }
+
+        // Shrink the vacant, and then simplify the level and the bytes
+
+        for (auto field : { &Fuzz::FuzzCase::avail_, &Fuzz::FuzzCase::mode_ }) {
+            Fuzz::FuzzCase t = best;
+            t.*field = 0;
+            progress |= tryCase(t);
+        }
+        for (std::size_t i = 0; i < best.input_.size(); ++i) {
+            Fuzz::FuzzCase t = best;
+            t.input_[i] = 0;
+            progress |= tryCase(t);
+        }
+        for (std::size_t i = 0; i < best.cmd_.size(); ++i) {
+            Fuzz::FuzzCase t = best;
+            t.cmd_[i] = (i % 2 == 0) ? best.cmd_[i] % Core::Command::kAllCmd.size() : best.cmd_[i] / 2;
+            progress |= tryCase(t);
+        }
+    }
+    return best;
+}
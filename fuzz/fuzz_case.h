@@ -0,0 +1,51 @@
+#ifndef FUZZ_CASE_H
+#define FUZZ_CASE_H
+
+#include <core/engine.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Fuzz {
+
+// The byte layout of a fuzz case, it's shared by the libFuzzer target and the
+// random driver, so a seed written by one can be replayed by the other:
+//
+// ┌─────┬───────┬──────┬───────────┬──────────────────┬──────────────────────────┐
+// │ vac │ avail │ mode │ input len │ input bytes ...  │ (op, operand) pairs ...  │
+// └─────┴───────┴──────┴───────────┴──────────────────┴──────────────────────────┘
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+class FuzzCase {
+  public:
+    static constexpr int kMaxVacant = 8;
+    static constexpr int kMaxInput = 16;
+
+    std::uint8_t vac_ = 0;                  // Vacant size is vac_ % (kMaxVacant + 1)
+    std::uint8_t avail_ = 0;                // Under 224 all commands are available, otherwise a bit mask
+    std::uint8_t mode_ = 0;                 // Needed sequence is mode_ % 3 : 0 the input, 1 the reversed input,
+                                            // 2 empty. Value type is mode_ / 3 % 8 : 1 int16, 2 int64,
+                                            // otherwise int32. From 192 the vacant is also run sparse
+    std::vector<std::uint8_t> input_;       // Every byte is a box (value in [-9, 9])
+    std::vector<std::uint8_t> cmd_;         // Every two bytes are a command
+
+    static FuzzCase decode(const std::uint8_t* data, std::size_t size);
+    std::vector<std::uint8_t> encode() const;
+
+    Core::Level toLevel() const;
+    Core::CommandList toCommands() const;
+    std::string dump() const;
+};
+
+std::optional<std::string> compareEngines(const FuzzCase& c, unsigned long long step_limit);
+FuzzCase minimizeCase(const FuzzCase& c, unsigned long long step_limit);
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include "fuzz_case.h"
+
+#include <core/core.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// libFuzzer entry, build with -DROBOX_LIBFUZZER=ON (clang only). The crash files it
+// writes use the same bytes as robox-fuzz-driver, so `robox-fuzz-driver --replay` reads them.
+
+static constexpr unsigned long long kFuzzStepLimit = 2000;
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    Core::setLogEnabled(false);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    Fuzz::FuzzCase c = Fuzz::FuzzCase::decode(data, size);
+    if (auto mismatch = Fuzz::compareEngines(c, kFuzzStepLimit)) {
+        std::fprintf(stderr, "%s\n%s", mismatch->c_str(), c.dump().c_str());
+        std::abort();
+    }
+    return 0;
+}
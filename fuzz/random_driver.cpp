@@ -0,0 +1,245 @@
+#include "fuzz_case.h"
+
+#include <core/core.h>
+#include <core/loader.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+
+// robox-fuzz-driver : the standalone random program driver of differential fuzzing.
+// It needs no libFuzzer and no network, every iteration is seeded by (seed, iteration),
+// so a reported case can always be generated again.
+//
+// Usage : robox-fuzz-driver [--seed N] [--iterations N] [--duration SECONDS]
+//                           [--max-commands N] [--step-limit N] [--max-failures N]
+//                           [--out DIR]
+//         robox-fuzz-driver --replay FILE...
+
+namespace {
+
+struct Options {
+    std::uint64_t seed = 0;
+    unsigned long long iterations = 0;      // 0 means no limit
+    unsigned long long duration = 0;        // Seconds, 0 means no limit
+    int max_commands = 24;
+    unsigned long long step_limit = 2000;
+    int max_failures = 10;
+    std::filesystem::path out = "fuzz-failures";
+};
+
+/**
+ * @program:     splitMix
+ * @description: This function mixes (seed, iteration) to the seed of one iteration
+ */
+std::uint64_t splitMix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @program:     generateCase
+ * @description: This function generates a random fuzz case, most levels have all commands
+ *               available so the engines are compared on running programs, not on loading
+ */
+Fuzz::FuzzCase generateCase(std::uint64_t seed, int max_commands) {
+    std::mt19937_64 rng(seed);
+    auto byte = [&rng]() { return static_cast<std::uint8_t>(rng()); };
+
+    Fuzz::FuzzCase c;
+    c.vac_ = byte();
+    c.avail_ = (rng() % 5 == 0) ? (224 | byte()) : byte() % 224;
+    c.mode_ = byte();
+    c.input_.resize(rng() % (Fuzz::FuzzCase::kMaxInput + 1));
+    for (auto& b : c.input_) b = byte();
+    c.cmd_.resize(2 * (1 + rng() % max_commands));
+    for (auto& b : c.cmd_) b = byte();
+    return c;
+}
+
+/**
+ * @program:     generateLoopCase
+ * @description: This function generates a case which fills the vacant from the input and
+ *               then runs a straight loop of outbox, add, sub, copyto and copyfrom with one
+ *               jumpifzero leaving it. Random programs seldom have such counting loops, which
+ *               are the loops that Core::LoopAccelerator skips
+ */
+Fuzz::FuzzCase generateLoopCase(std::uint64_t seed, int max_commands) {
+    std::mt19937_64 rng(seed);
+    auto byte = [&rng]() { return static_cast<std::uint8_t>(rng()); };
+
+    Fuzz::FuzzCase c;
+    const int vs = 1 + rng() % Fuzz::FuzzCase::kMaxVacant;
+    c.vac_ = vs;
+    c.avail_ = 0;
+    c.mode_ = byte();
+    c.input_.resize(vs + rng() % (Fuzz::FuzzCase::kMaxInput + 1 - vs));
+    for (auto& b : c.input_) b = byte();
+
+    auto emit = [&c](int op, int operand) {
+        c.cmd_.push_back(op);
+        c.cmd_.push_back(operand);
+    };
+
+    for (int v = 0; v < vs; ++v) {
+        if (rng() % 4 == 0) continue;
+        emit(Core::Opcode::kInbox, 0);
+        emit(Core::Opcode::kCopyto, v);
+    }
+    emit(Core::Opcode::kInbox, 0);
+
+    // Most of the vacant is filled, so the loop mostly runs
+
+    const int header = c.cmd_.size() / 2 + 1;
+    const int body = 1 + rng() % std::max(1, max_commands / 2);
+    const int exit = rng() % body;
+    const std::array<int, 5> ops = {
+        Core::Opcode::kOutbox, Core::Opcode::kAdd, Core::Opcode::kSub,
+        Core::Opcode::kCopyto, Core::Opcode::kCopyfrom
+    };
+    for (int i = 0; i < body; ++i) {
+        if (i == exit) {
+            emit(Core::Opcode::kJumpifzero, header + body + 1 + rng() % 2);
+        } else {
+            int op = ops[rng() % ops.size()];
+            emit(op, op == Core::Opcode::kOutbox ? 0 : rng() % vs);
+        }
+    }
+    emit(Core::Opcode::kJump, header);
+    emit(Core::Opcode::kOutbox, 0);
+
+    // The exit goes to the outbox after the loop, or to the end of program
+    return c;
+}
+
+/**
+ * @program:     writeFailure
+ * @description: This function writes the minimized case as a seed (bytes) and a readable dump
+ */
+void writeFailure(const Options& opt, const Fuzz::FuzzCase& c, const std::string& name, const std::string& why) {
+    std::filesystem::create_directories(opt.out);
+
+    auto bytes = c.encode();
+    std::ofstream seed_file(opt.out / (name + ".bin"), std::ios::binary);
+    seed_file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+    std::ofstream text_file(opt.out / (name + ".txt"));
+    text_file << why << "\nstep limit " << opt.step_limit << '\n' << c.dump();
+
+    std::cerr << "FAILURE " << name << " : " << why << '\n' << c.dump()
+              << "Seed written to " << (opt.out / (name + ".bin")).string() << std::endl;
+}
+
+/**
+ * @program:     replay
+ * @description: This function runs the seed files again, the exit code is the count of failures
+ */
+int replay(const Options& opt, int argc, char** argv, int first) {
+    int failures = 0;
+    for (int i = first; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::vector<std::uint8_t> bytes(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>()
+        );
+        Fuzz::FuzzCase c = Fuzz::FuzzCase::decode(bytes.data(), bytes.size());
+        if (auto mismatch = Fuzz::compareEngines(c, opt.step_limit)) {
+            std::cout << argv[i] << " : FAIL : " << *mismatch << '\n' << c.dump();
+            failures++;
+        } else {
+            std::cout << argv[i] << " : OK" << std::endl;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+
+    Options opt;
+    opt.seed = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value of " << arg << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        auto number = [&](auto& n) {
+            const std::string v = value();
+            if (!Core::parseNumber(v, n)) {
+                std::cerr << "Bad value of " << arg << " : " << v << std::endl;
+                std::exit(2);
+            }
+        };
+
+        if (arg == "--seed") number(opt.seed);
+        else if (arg == "--iterations") number(opt.iterations);
+        else if (arg == "--duration") number(opt.duration);
+        else if (arg == "--max-commands") number(opt.max_commands);
+        else if (arg == "--step-limit") number(opt.step_limit);
+        else if (arg == "--max-failures") number(opt.max_failures);
+        else if (arg == "--out") opt.out = value();
+        else if (arg == "--replay") return replay(opt, argc, argv, i + 1);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::cout << "seed " << opt.seed << ", engines :";
+    for (auto kind : Core::kAllEngine) std::cout << ' ' << Core::engineName(kind);
+    std::cout << std::endl;
+
+    auto begin = std::chrono::steady_clock::now();
+    auto last_report = begin;
+    int failures = 0;
+    unsigned long long i = 0;
+
+    for (; opt.iterations == 0 || i < opt.iterations; ++i) {
+        auto now = std::chrono::steady_clock::now();
+        if (opt.duration != 0 && now - begin >= std::chrono::seconds(opt.duration)) break;
+        if (now - last_report >= std::chrono::seconds(10)) {
+            double seconds = std::chrono::duration<double>(now - begin).count();
+            std::cout << i << " cases, " << static_cast<long long>(i / seconds) << " cases/s, "
+                      << failures << " failures" << std::endl;
+            last_report = now;
+        }
+
+        Core::setProfileEnabled(i % 2 == 1);
+        const std::uint64_t case_seed = splitMix(opt.seed ^ splitMix(i));
+        Fuzz::FuzzCase c = (i % 4 == 3)
+                         ? generateLoopCase(case_seed, opt.max_commands)
+                         : generateCase(case_seed, opt.max_commands);
+
+        // Every other case is profiled, so both loops of the decoded engine are compared
+        auto mismatch = Fuzz::compareEngines(c, opt.step_limit);
+        if (!mismatch) continue;
+
+        Fuzz::FuzzCase small = Fuzz::minimizeCase(c, opt.step_limit);
+        writeFailure(
+            opt, small,
+            "seed-" + std::to_string(opt.seed) + "-" + std::to_string(i),
+            *Fuzz::compareEngines(small, opt.step_limit)
+        );
+        if (++failures >= opt.max_failures) break;
+    }
+
+    std::cout << i << " cases, " << failures << " failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <core/core.h>
+#include <core/equivalence.h>
+#include <core/loader.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// robox-equiv : the bounded equivalence checker, it runs a submission and the reference
+// solution of a level on every input in the bound and reports an input on which their
+// outputs differ, see `equivalence.h`. The input of the level file is not used.
+//
+// Usage : robox-equiv LEVEL SUBMISSION REFERENCE [--length N] [--min V] [--max V]
+//                     [--step-limit N] [--threads N] [--max-states N]
+//
+// Exit code : 0 equivalent in the bound, 1 counterexample found, 2 bad usage or file,
+//             3 too many states to finish
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+
+    std::string path[3];
+    int paths = 0;
+    Core::EquivalenceBound bound;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            if (paths == 3) {
+                std::cerr << "Too many files" << std::endl;
+                return 2;
+            }
+            path[paths++] = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--length") ok = Core::parseNumber(argv[++i], bound.max_length_);
+        else if (arg == "--min") ok = Core::parseNumber(argv[++i], bound.min_value_);
+        else if (arg == "--max") ok = Core::parseNumber(argv[++i], bound.max_value_);
+        else if (arg == "--step-limit") ok = Core::parseNumber(argv[++i], bound.step_limit_);
+        else if (arg == "--threads") ok = Core::parseNumber(argv[++i], bound.threads_);
+        else if (arg == "--max-states") ok = Core::parseNumber(argv[++i], bound.max_states_);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (paths != 3) {
+        std::cerr << "Usage : robox-equiv LEVEL SUBMISSION REFERENCE [options]" << std::endl;
+        return 2;
+    }
+
+    std::ifstream level_file(path[0]), submission_file(path[1]), reference_file(path[2]);
+    if (!level_file.is_open() || !submission_file.is_open() || !reference_file.is_open()) {
+        std::cerr << "Fail to open the files" << std::endl;
+        return 2;
+    }
+    auto level = Core::parseLevel(level_file);
+    auto submission = Core::parseCommands(submission_file);
+    auto reference = Core::parseCommands(reference_file);
+    if (!level || !submission || !reference) {
+        std::cerr << (!level ? level.error() : !submission ? submission.error() : reference.error()) << std::endl;
+        return 2;
+    }
+
+    auto result = Core::checkEquivalence(*level, *submission, *reference, bound);
+    if (!result) {
+        std::cerr << "Fail to load : " << Core::describeDiagnostic(result.error()) << std::endl;
+        return 2;
+    }
+    if (!result->complete_) {
+        std::cout << "gave up after " << result->states_ << " states" << std::endl;
+        return 3;
+    }
+    if (!result->equivalent_) {
+        std::cout << "differ on input :";
+        for (int v : result->counterexample_) std::cout << ' ' << v;
+        std::cout << " (" << result->states_ << " states)" << std::endl;
+        return 1;
+    }
+    std::cout << "equivalent on " << bound.max_length_ << " boxes in [" << bound.min_value_
+              << ", " << bound.max_value_ << "] (" << result->states_ << " states)" << std::endl;
+    return 0;
+}
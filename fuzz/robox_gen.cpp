@@ -0,0 +1,138 @@
+#include <core/core.h>
+#include <core/generator.h>
+#include <core/loader.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// robox-gen : the generator of stress suites, see `generator.h`. The tests are written to
+// DIR as level files named by the level and the test number, with the manifest
+// DIR/corpus.txt in the format of bench/corpus/corpus.txt, which expects the reference to
+// succeed on every test, so robox-corpus-bench runs the suite as it is.
+//
+// Usage : robox-gen LEVEL REFERENCE SPEC --out DIR [--count N] [--seed N] [--step-limit N]
+//                   [--threads N]
+//
+// Exit code : 0 OK, 1 the reference fails on a test, 2 bad usage or file
+
+namespace {
+
+/**
+ * @program:     writeLevel
+ * @description: This function writes the level in the format of `loader.h`
+ */
+bool writeLevel(const std::filesystem::path& path, const Core::Level& level) {
+    std::ofstream file(path);
+    file << "vacant " << level.vac_size_ << "\navailable";
+    for (const std::string& name : level.available_cmd_) file << ' ' << name;
+    file << "\ninput";
+    for (std::int64_t value : level.provided_seq_) file << ' ' << value;
+    file << "\nneeded";
+    for (std::int64_t value : level.needed_seq_) file << ' ' << value;
+    file << '\n';
+    if (level.value_kind_ == Core::ValueKind::kValue16) file << "value int16\n";
+    if (level.value_kind_ == Core::ValueKind::kValue64) file << "value int64\n";
+    return file.good();
+}
+
+/**
+ * @program:     readFile
+ * @description: This function opens the file and parses it, the error is printed
+ */
+template <class T>
+std::optional<T> readFile(
+    const std::filesystem::path& path,
+    std::expected<T, std::string> (*parse)(std::istream&)
+) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Fail to open " << path << std::endl;
+        return std::nullopt;
+    }
+    auto value = parse(file);
+    if (!value) {
+        std::cerr << path << " : " << value.error() << std::endl;
+        return std::nullopt;
+    }
+    return *value;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+
+    std::vector<std::filesystem::path> paths;
+    std::filesystem::path out;
+    Core::GeneratorOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--out") out = argv[++i];
+        else if (arg == "--count") ok = Core::parseNumber(argv[++i], options.count_);
+        else if (arg == "--seed") ok = Core::parseNumber(argv[++i], options.seed_);
+        else if (arg == "--step-limit") ok = Core::parseNumber(argv[++i], options.step_limit_);
+        else if (arg == "--threads") ok = Core::parseNumber(argv[++i], options.threads_);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (paths.size() != 3 || out.empty()) {
+        std::cerr << "Usage : robox-gen LEVEL REFERENCE SPEC --out DIR [options]" << std::endl;
+        return 2;
+    }
+
+    auto level = readFile(paths[0], Core::parseLevel);
+    auto reference = readFile(paths[1], Core::parseCommands);
+    auto spec = readFile(paths[2], Core::parseGeneratorSpec);
+    if (!level || !reference || !spec) return 2;
+
+    auto tests = Core::generateTests(*level, *reference, *spec, options);
+    if (!tests) {
+        std::cerr << tests.error() << std::endl;
+        return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(out, ec);
+    std::ofstream manifest(out / "corpus.txt");
+    if (ec || !manifest.is_open()) {
+        std::cerr << "Fail to write " << out << std::endl;
+        return 2;
+    }
+
+    // The reference is named relative to the manifest, as the corpus bench reads it
+
+    const std::string solution = std::filesystem::relative(
+        std::filesystem::absolute(paths[1]), std::filesystem::absolute(out)
+    ).string();
+    const std::string stem = paths[0].stem().string();
+    for (std::size_t i = 0; i < tests->size(); ++i) {
+        const std::string name = stem + "-" + std::to_string(i) + ".level";
+        if (!writeLevel(out / name, (*tests)[i])) {
+            std::cerr << "Fail to write " << out / name << std::endl;
+            return 2;
+        }
+        manifest << name << ' ' << solution << " success\n";
+    }
+    std::cout << tests->size() << " tests of seed " << options.seed_ << " written to " << out << std::endl;
+    return manifest.good() ? 0 : 2;
+}
@@ -0,0 +1,101 @@
+#include <core/core.h>
+#include <core/loader.h>
+#include <core/rewrite.h>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// robox-speedup : the optimizer of the speed score, it rewrites a correct submission into
+// an equivalent one which takes fewer steps on average over the levels given, see
+// `rewrite.h`. The levels are the tests of one puzzle, and the rewritten program is printed
+// as a command file.
+//
+// Usage : robox-speedup SUBMISSION LEVEL... [--rounds N] [--inline N] [--step-limit N]
+//                       [--threads N] [--length N] [--min V] [--max V]
+//
+// Exit code : 0 steps reduced, 1 no rewrite helps, 2 bad usage or file
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+
+    std::vector<std::string> paths;
+    Core::RewriteOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--rounds") ok = Core::parseNumber(argv[++i], options.max_rounds_);
+        else if (arg == "--inline") ok = Core::parseNumber(argv[++i], options.max_inline_);
+        else if (arg == "--step-limit") ok = Core::parseNumber(argv[++i], options.step_limit_);
+        else if (arg == "--threads") ok = Core::parseNumber(argv[++i], options.threads_);
+        else if (arg == "--length") ok = Core::parseNumber(argv[++i], options.bound_.max_length_);
+        else if (arg == "--min") ok = Core::parseNumber(argv[++i], options.bound_.min_value_);
+        else if (arg == "--max") ok = Core::parseNumber(argv[++i], options.bound_.max_value_);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (paths.size() < 2) {
+        std::cerr << "Usage : robox-speedup SUBMISSION LEVEL... [options]" << std::endl;
+        return 2;
+    }
+
+    std::ifstream submission_file(paths[0]);
+    if (!submission_file.is_open()) {
+        std::cerr << "Fail to open " << paths[0] << std::endl;
+        return 2;
+    }
+    auto submission = Core::parseCommands(submission_file);
+    if (!submission) {
+        std::cerr << paths[0] << " : " << submission.error() << std::endl;
+        return 2;
+    }
+    std::vector<Core::Level> tests;
+    for (std::size_t i = 1; i < paths.size(); ++i) {
+        std::ifstream file(paths[i]);
+        if (!file.is_open()) {
+            std::cerr << "Fail to open " << paths[i] << std::endl;
+            return 2;
+        }
+        auto level = Core::parseLevel(file);
+        if (!level) {
+            std::cerr << paths[i] << " : " << level.error() << std::endl;
+            return 2;
+        }
+        tests.push_back(std::move(*level));
+    }
+
+    auto result = Core::reduceSteps(tests, *submission, options);
+    if (!result) {
+        std::cerr << result.error() << std::endl;
+        return 2;
+    }
+    const double reduced = result->steps_before_ - result->steps_after_;
+    std::cout << std::fixed << std::setprecision(1)
+              << "# steps " << result->steps_before_ << " -> " << result->steps_after_ << " (-"
+              << (result->steps_before_ == 0 ? 0 : 100 * reduced / result->steps_before_) << "%, "
+              << result->candidates_ << " candidates)" << std::endl;
+    for (const std::string& rewrite : result->applied_) std::cout << "# " << rewrite << std::endl;
+    for (const auto& [name, index] : result->program_) {
+        std::cout << name;
+        if (index != Core::Command::SingleCommand::kNullVacant) std::cout << ' ' << index;
+        std::cout << std::endl;
+    }
+    return result->applied_.empty() ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+#include <core/core.h>
+#include <core/loader.h>
+#include <core/similarity.h>
+#include <core/submission_store.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// robox-store : the archive of submissions, see `submission_store.h`.
+//
+// Usage : robox-store add STORE MANIFEST...   add the submissions of the manifests, which
+//                                             are in the format of bench/corpus/corpus.txt,
+//                                             to STORE (created when missing)
+//         robox-store stats STORE
+//         robox-store level STORE LEVEL        list the submissions of LEVEL
+//         robox-store find STORE SOLUTION      tell whether the program has been submitted
+//         robox-store show STORE NODE          print the program of NODE
+//         robox-store similar STORE SOLUTION [--threshold T] [--index FILE] [--threads N]
+//                                             list the programs whose similarity to the
+//                                             solution is at least T (default 0.8), see
+//                                             `similarity.h`
+//
+// The level of a submission is the stem of its level file, e.g. `mail-room`. The index of
+// `similar` is loaded from FILE when given, the programs not in it yet are added and it's
+// saved again, so only the new submissions are hashed.
+//
+// Exit code : 0 OK, 1 not found, 2 bad usage or file
+
+namespace {
+
+int usage() {
+    std::cerr << "Usage : robox-store add|stats|level|find|show|similar STORE ..." << std::endl;
+    return 2;
+}
+
+std::expected<Core::CommandList, std::string> readCommands(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return std::unexpected("Fail to open " + path.string());
+    return Core::parseCommands(file);
+}
+
+void printProgram(const Core::CommandList& cmd) {
+    for (const auto& [name, index] : cmd) {
+        std::cout << name;
+        if (index != Core::Command::SingleCommand::kNullVacant) std::cout << ' ' << index;
+        std::cout << std::endl;
+    }
+}
+
+/**
+ * @program:     add
+ * @description: This function builds the store again from its old submissions and the
+ *               submissions of the manifests, a solution which can't be parsed is skipped
+ */
+int add(const std::filesystem::path& store, int count, char** manifests) {
+    Core::SubmissionStoreBuilder builder;
+    if (std::filesystem::exists(store)) {
+        auto old = Core::SubmissionStore::open(store);
+        if (!old) {
+            std::cerr << old.error() << std::endl;
+            return 2;
+        }
+        for (const std::string& level : old->levels()) {
+            for (const auto& s : old->byLevel(level)) builder.add(level, old->program(s.node_));
+        }
+    }
+
+    std::size_t added = 0, skipped = 0;
+    for (int i = 0; i < count; ++i) {
+        const std::filesystem::path manifest_path = manifests[i];
+        std::ifstream manifest(manifest_path);
+        if (!manifest.is_open()) {
+            std::cerr << "Fail to open " << manifest_path << std::endl;
+            return 2;
+        }
+        std::string line;
+        while (std::getline(manifest, line)) {
+            std::stringstream ss(line.substr(0, line.find('#')));
+            std::string level, solution;
+            if (!(ss >> level >> solution)) continue;
+            auto cmd = readCommands(manifest_path.parent_path() / solution);
+            if (cmd && builder.add(std::filesystem::path(level).stem().string(), *cmd)) {
+                added++;
+            } else {
+                skipped++;
+            }
+        }
+    }
+    if (!builder.save(store)) {
+        std::cerr << "Fail to write " << store << std::endl;
+        return 2;
+    }
+    std::cout << added << " added, " << skipped << " skipped, " << builder.submissions()
+              << " submissions in " << builder.nodes() << " nodes" << std::endl;
+    return 0;
+}
+
+/**
+ * @program:     similar
+ * @description: This function updates the similarity index of the store and queries it
+ */
+int similar(const Core::SubmissionStore& store, int argc, char** argv) {
+    double threshold = 0.8;
+    std::filesystem::path index_path;
+    unsigned int threads = 0;
+    for (int i = 4; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0 && i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--threshold") {
+            ok = Core::parseNumber(argv[++i], threshold);
+        } else if (arg == "--index") {
+            index_path = argv[++i];
+        } else if (arg == "--threads") {
+            ok = Core::parseNumber(argv[++i], threads);
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    auto cmd = readCommands(argv[3]);
+    if (!cmd) {
+        std::cerr << cmd.error() << std::endl;
+        return 2;
+    }
+
+    Core::SimilarityIndex index;
+    if (!index_path.empty() && std::filesystem::exists(index_path) && !index.load(index_path)) {
+        std::cerr << "Fail to read " << index_path << std::endl;
+        return 2;
+    }
+    std::vector<std::pair<std::uint32_t, Core::CommandList>> programs;
+    for (std::uint32_t node : store.programNodes()) {
+        if (!index.contains(node)) programs.push_back({ node, store.program(node) });
+    }
+    index.addAll(programs, threads);
+    if (!index_path.empty() && !programs.empty() && !index.save(index_path)) {
+        std::cerr << "Fail to write " << index_path << std::endl;
+        return 2;
+    }
+
+    auto result = index.query(*cmd, threshold);
+    for (const auto& [node, similarity] : result) {
+        std::cout << "node " << node << ", similarity " << std::fixed << std::setprecision(3)
+                  << similarity << std::endl;
+    }
+    return result.empty() ? 1 : 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+    if (argc < 3) return usage();
+    const std::string action = argv[1];
+    const std::filesystem::path path = argv[2];
+
+    if (action == "add") return add(path, argc - 3, argv + 3);
+
+    auto store = Core::SubmissionStore::open(path);
+    if (!store) {
+        std::cerr << store.error() << std::endl;
+        return 2;
+    }
+
+    if (action == "stats" && argc == 3) {
+        std::cout << store->submissions() << " submissions, " << store->programs() << " programs, "
+                  << store->nodes() << " nodes, " << store->levels().size() << " levels, "
+                  << store->bytes() << " bytes" << std::endl;
+        return 0;
+    }
+    if (action == "level" && argc == 4) {
+        auto submissions = store->byLevel(argv[3]);
+        for (const auto& s : submissions) {
+            const Core::CommandList cmd = store->program(s.node_);
+            std::cout << "node " << s.node_ << ", " << cmd.size() << " commands, hash "
+                      << std::hex << std::setw(16) << std::setfill('0') << Core::programHash(cmd)
+                      << std::dec << std::endl;
+        }
+        return submissions.empty() ? 1 : 0;
+    }
+    if (action == "find" && argc == 4) {
+        auto cmd = readCommands(argv[3]);
+        if (!cmd) {
+            std::cerr << cmd.error() << std::endl;
+            return 2;
+        }
+        auto nodes = store->find(*cmd);
+        for (std::uint32_t node : nodes) std::cout << "node " << node << std::endl;
+        return nodes.empty() ? 1 : 0;
+    }
+    if (action == "show" && argc == 4) {
+        std::uint32_t node = 0;
+        if (!Core::parseNumber(argv[3], node)) return usage();
+        if (node >= store->nodes()) return 1;
+        printProgram(store->program(node));
+        return 0;
+    }
+    if (action == "similar" && argc >= 4) return similar(*store, argc, argv);
+    return usage();
+}
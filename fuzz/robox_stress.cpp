@@ -0,0 +1,153 @@
+#include <core/core.h>
+#include <core/expected_output.h>
+#include <core/generator.h>
+#include <core/input_source.h>
+#include <core/loader.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+// robox-stress : runs a solution on a streamed input, see `input_source.h`, so the input
+// may be far longer than a level file holds. The input is the boxes of a text file or pipe
+// (`-` is the standard input), N random boxes in [-999, 999], or the input of the level
+// when neither is given. The output is checked against the needed sequence of the level,
+// or against the expected output file (see `expected_output.h`) as it's put, so neither
+// is kept in memory.
+//
+// Usage : robox-stress LEVEL SOLUTION [--input FILE] [--random N] [--seed N] [--chunk N]
+//                      [--expected FILE] [--step-limit N] [--no-prefetch]
+//
+// Exit code : 0 success, 1 fail or error, 2 bad usage or file
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+
+    std::vector<std::string> paths;
+    std::string input_path;
+    std::string expected_path;
+    unsigned long long random = 0;
+    std::uint64_t seed = 0;
+    std::size_t chunk = Core::InputConveyor::kDefaultChunk;
+    unsigned long long step_limit = 0;
+    bool prefetch = true;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+        if (arg == "--no-prefetch") {
+            prefetch = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--input") input_path = argv[++i];
+        else if (arg == "--random") ok = Core::parseNumber(argv[++i], random);
+        else if (arg == "--seed") ok = Core::parseNumber(argv[++i], seed);
+        else if (arg == "--expected") expected_path = argv[++i];
+        else if (arg == "--chunk") ok = Core::parseNumber(argv[++i], chunk);
+        else if (arg == "--step-limit") ok = Core::parseNumber(argv[++i], step_limit);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (paths.size() != 2) {
+        std::cerr << "Usage : robox-stress LEVEL SOLUTION [options]" << std::endl;
+        return 2;
+    }
+
+    std::ifstream level_file(paths[0]), solution_file(paths[1]);
+    if (!level_file.is_open() || !solution_file.is_open()) {
+        std::cerr << "Fail to open " << (!level_file.is_open() ? paths[0] : paths[1]) << std::endl;
+        return 2;
+    }
+    auto level = Core::parseLevel(level_file);
+    auto solution = Core::parseCommands(solution_file);
+    if (!level || !solution) {
+        std::cerr << (!level ? level.error() : solution.error()) << std::endl;
+        return 2;
+    }
+    if (level->value_kind_ != Core::ValueKind::kValue32) {
+        std::cerr << "The streamed engine only runs levels of int32 boxes" << std::endl;
+        return 2;
+    }
+    auto program = Core::decodeProgram(*solution, level->available_cmd_);
+    if (!program) {
+        std::cerr << "Fail to load : " << Core::describeDiagnostic(program.error()) << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<Core::InputSource> source;
+    if (input_path == "-") {
+        source = Core::TextInput::standardInput();
+    } else if (!input_path.empty()) {
+        auto file = Core::TextInput::open(input_path);
+        if (!file) {
+            std::cerr << file.error() << std::endl;
+            return 2;
+        }
+        source = std::move(*file);
+    } else if (random != 0) {
+        source = std::make_unique<Core::GeneratorInput>(
+            [rng = Core::SplitMix(seed), left = random](int& box) mutable {
+                if (left == 0) return false;
+                left--;
+                box = static_cast<int>(rng.uniform(-999, 999));
+                return true;
+            }
+        );
+    } else {
+        source = std::make_unique<Core::SequenceInput>(level->provided_seq_);
+    }
+
+    std::optional<Core::ExpectedOutput> expected;
+    if (!expected_path.empty()) {
+        auto file = Core::ExpectedOutput::open(expected_path);
+        if (!file) {
+            std::cerr << file.error() << std::endl;
+            return 2;
+        }
+        expected = std::move(*file);
+    }
+
+    Core::InputConveyor input(std::move(source), chunk, prefetch);
+    Core::Machine m;
+    m.reset(level->vac_size_);
+    auto begin = std::chrono::steady_clock::now();
+    auto verdict = Core::runStreamed(*program, *level, input, expected ? &*expected : nullptr, m, step_limit);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    if (!input.error().empty()) {
+        std::cerr << "Input : " << input.error() << std::endl;
+        return 2;
+    }
+    if (expected && !expected->error().empty()) {
+        std::cerr << "Expected output : " << expected->error() << std::endl;
+        return 2;
+    }
+    const unsigned long long put = m.output_.size() + (expected ? expected->checked() : 0);
+    std::cout << m.input_pos_ << " boxes taken, " << put << " boxes put, "
+              << m.steps_ << " steps in " << seconds << " s" << std::endl;
+    if (!verdict) {
+        std::cout << "error : " << Core::describeDiagnostic(verdict.error()) << std::endl;
+        return 1;
+    }
+    std::cout << (*verdict == Core::Verdict::kSuccess ? "success" : "fail");
+    if (expected && expected->mismatch()) std::cout << " at box " << *expected->mismatch();
+    std::cout << std::endl;
+    return *verdict == Core::Verdict::kSuccess ? 0 : 1;
+}
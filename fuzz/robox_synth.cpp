@@ -0,0 +1,89 @@
+#include <core/core.h>
+#include <core/loader.h>
+#include <core/synth.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// robox-synth : the superoptimizer, it searches the shortest command list which succeeds on
+// every level given, see `synth.h`. The levels are the tests of one puzzle, so they must
+// have the same available commands and vacant size. The solution is printed as a command
+// file which the loader reads back.
+//
+// Usage : robox-synth LEVEL... [--max-size N] [--step-limit N] [--threads N]
+//                     [--checkpoint FILE] [--checkpoint-seconds N]
+//
+// Exit code : 0 solution found, 1 no solution up to the size, 2 bad usage or file
+
+int main(int argc, char** argv) {
+    Core::setLogEnabled(false);
+
+    std::vector<std::string> paths;
+    Core::SynthOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value of " << arg << std::endl;
+            return 2;
+        }
+        bool ok = true;
+        if (arg == "--max-size") ok = Core::parseNumber(argv[++i], options.max_size_);
+        else if (arg == "--step-limit") ok = Core::parseNumber(argv[++i], options.step_limit_);
+        else if (arg == "--threads") ok = Core::parseNumber(argv[++i], options.threads_);
+        else if (arg == "--checkpoint") options.checkpoint_ = argv[++i];
+        else if (arg == "--checkpoint-seconds") ok = Core::parseNumber(argv[++i], options.checkpoint_seconds_);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "Bad value of " << arg << " : " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage : robox-synth LEVEL... [options]" << std::endl;
+        return 2;
+    }
+
+    std::vector<Core::Level> tests;
+    for (const std::string& path : paths) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Fail to open " << path << std::endl;
+            return 2;
+        }
+        auto level = Core::parseLevel(file);
+        if (!level) {
+            std::cerr << path << " : " << level.error() << std::endl;
+            return 2;
+        }
+        tests.push_back(std::move(*level));
+    }
+
+    auto result = Core::synthesize(tests, options);
+    if (!result) {
+        std::cerr << result.error() << std::endl;
+        return 2;
+    }
+    if (!result->program_) {
+        std::cout << "# no solution of at most " << options.max_size_ << " commands ("
+                  << result->candidates_ << " candidates)" << std::endl;
+        return 1;
+    }
+    std::cout << "# " << result->program_->size() << " commands (" << result->candidates_
+              << " candidates)" << std::endl;
+    for (const auto& [name, index] : *result->program_) {
+        std::cout << name;
+        if (index != Core::Command::SingleCommand::kNullVacant) std::cout << ' ' << index;
+        std::cout << std::endl;
+    }
+    return 0;
+}
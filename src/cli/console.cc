@@ -1,10 +1,12 @@
 #include <core/core.h>
+#include <core/trace.h>
 #include "console.h"
 
 #include <ncurses.h>
 #include <iconv.h>
 
 #include <cmath>
+#include <cstdlib>
 #include <cwchar>
 #include <fstream>
 #include <string>
@@ -92,6 +94,8 @@ std::wstring Cli::GamePanel::getInputLevel() {
  * @description: This function is to put the GameMainTitle and GameInfo to the MainWindow
  */
 void Cli::GamePanel::initScreen() {
+    Core::TraceSpan span("GamePanel::initScreen", "render");
+
     setlocale(LC_ALL, "");
     initscr();
     raw();
@@ -134,6 +138,14 @@ void Cli::GamePanel::initScreen() {
         Core::LogType::kInfo
     );
 
+    heatmap_window_ = newwin(
+        kGameHeatmapWindowHeight,
+        kGameHeatmapWindowWidth,
+        0, kGameMainWindowWidth + 1 + kGameCommandWindowWidth
+    );
+
+    box(heatmap_window_, 0, 0);
+
     status_window_ = newwin(
         kGameStatusWindowHeight,
         kGameStatusWindowWidth,
@@ -189,6 +201,7 @@ void Cli::GamePanel::initScreen() {
     wrefresh(target_window_);
     wrefresh(main_window_);
     wrefresh(command_window_);
+    wrefresh(heatmap_window_);
     wrefresh(status_window_);
 }
 
@@ -197,6 +210,8 @@ void Cli::GamePanel::initScreen() {
  * @description: This function is to show the select level panel
  */
 void Cli::GamePanel::showSelect() {
+    Core::TraceSpan span("GamePanel::showSelect", "render");
+
     Core::logMessage(
         "showSelect function clears the MainWindow content.", 
         Core::LogLocation::kCli,
@@ -357,6 +372,8 @@ void Cli::GamePanel::showMain() {
  * @description: This function is to show the pause tab.
  */
 void Cli::GamePanel::showPaused() {
+    Core::TraceSpan span("GamePanel::showPaused", "render");
+
     Core::logMessage(
         "showPaused function clears the MainWindow content.", 
         Core::LogLocation::kCli,
@@ -389,7 +406,103 @@ void Cli::GamePanel::showPaused() {
     );
 }
 
+/**
+ * @program:     Cli::GamePanel::showDiagnostic
+ * @description: This function is to show the error of game on the status window. Core only
+ *               returns the diagnostic, so rendering it is the job of Cli.
+ */
+void Cli::GamePanel::showDiagnostic() {
+    const Core::Diagnostic& d = game_->getDiagnostic();
+    if (d.code_ == Core::DiagnosticCode::kNoError) return;
+    Core::TraceSpan span("GamePanel::showDiagnostic", "render");
+
+    std::string message = "Error on instruction " + std::to_string(d.instruction_);
+    std::wstring message_wstr(message.begin(), message.end());
+
+    werase(status_window_);
+    box(status_window_, 0, 0);
+    mvwaddwstr(status_window_, 1, 1, message_wstr.data());
+    wrefresh(status_window_);
+
+    Core::logMessage(
+        Core::describeDiagnostic(d), 
+        Core::LogLocation::kCli, 
+        Core::LogType::kError
+    );
+}
+
+/**
+ * @program:     shortCount
+ * @description: This function prints a count in at most 7 characters, a larger count is
+ *               cut to thousands with the suffix k, M, G, T, P or E
+ */
+static std::wstring shortCount(unsigned long long n) {
+    if (n < 10000000) return std::to_wstring(n);
+    int unit = 0;
+    while (n >= 1000000) {
+        n /= 1000;
+        unit++;
+    }
+    return std::to_wstring(n) + L"kMGTPE"[unit - 1];
+}
+
+/**
+ * @program:     Cli::GamePanel::showHeatmap
+ * @description: This function shows the profile of game next to the command window, every
+ *               row is a shade of how hot the command is, its executions and, for jumpifzero,
+ *               how often it jumps. The game should be run with Core::Game::setProfiling(true)
+ */
+void Cli::GamePanel::showHeatmap() {
+    Core::TraceSpan span("GamePanel::showHeatmap", "render");
+
+    const Core::Profile& p = game_->profile();
+    const unsigned long long hottest = p.hottest();
+
+    werase(heatmap_window_);
+    box(heatmap_window_, 0, 0);
+
+    for (std::size_t i = 0; i < p.size_ && i < kGameHeatmapWindowHeight - 2; ++i) {
+        unsigned long long n = p.count_[i];
+        int shade = (n == 0) ? 0 : 1 + static_cast<int>(
+            std::log1p(static_cast<double>(n)) / std::log1p(static_cast<double>(hottest)) * (kHeatShadeCount - 2)
+        );
+
+        // Log scale, the body of a loop is not the only visible row. The count is short, so
+        // the row fits, and a row which swprintf can't write isn't shown
+
+        wchar_t row[kGameHeatmapWindowWidth - 1] = {};
+        const std::wstring count = shortCount(n);
+        unsigned long long branches = p.taken_[i] + p.not_taken_[i];
+        int written;
+        if (branches != 0) {
+            const int taken = static_cast<int>(100.0 * p.taken_[i] / branches);
+            written = std::swprintf(row, kGameHeatmapWindowWidth - 2, L"%lc %7ls %3d%%", 
+                                    kHeatShade[shade], count.c_str(), taken);
+        } else {
+            written = std::swprintf(row, kGameHeatmapWindowWidth - 2, L"%lc %7ls", kHeatShade[shade], count.c_str());
+        }
+        if (written < 0) continue;
+        mvwaddnwstr(heatmap_window_, i + 1, 1, row, kGameHeatmapWindowWidth - 2);
+    }
+
+    std::wstring total = L" " + std::to_wstring(p.steps_) + L" steps ";
+    mvwaddnwstr(heatmap_window_, kGameHeatmapWindowHeight - 1, 1, total.data(), kGameHeatmapWindowWidth - 2);
+    wrefresh(heatmap_window_);
+
+    Core::logMessage(
+        "The heatmap has been shown, " + std::to_string(p.size_) + " commands and " +
+        std::to_string(p.steps_) + " steps.", 
+        Core::LogLocation::kCli, 
+        Core::LogType::kInfo
+    );
+}
+
 void Cli::GamePanel::run() {
+    const char* trace_path = std::getenv("ROBOX_TRACE");
+    if (trace_path != nullptr) Core::startTrace(trace_path);
+
+    // ROBOX_TRACE=FILE writes the timeline of the session to FILE when the player quits
+
     std::filesystem::create_directory(config);
     std::ifstream current_config_file(config / kCurentConfigFile);
 
@@ -410,6 +523,7 @@ void Cli::GamePanel::run() {
     }
 
     initScreen();
+    showDiagnostic();
 
     char ch;
 
@@ -433,6 +547,9 @@ void Cli::GamePanel::run() {
             }
             wrefresh(main_window_);
             break;
+        case 'h' :
+            showHeatmap();
+            break;
         }
     }
 
@@ -443,4 +560,12 @@ void Cli::GamePanel::run() {
     );
 
     endwin();
+
+    if (trace_path != nullptr && !Core::stopTrace()) {
+        Core::logMessage(
+            "Fail to write the trace file " + std::string(trace_path), 
+            Core::LogLocation::kCli, 
+            Core::LogType::kError
+        );
+    }
 }
\ No newline at end of file
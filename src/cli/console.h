@@ -47,8 +47,9 @@ class GamePanel {
 
     // kGamePausedTitle is to show when the game is paused by player
 
-    constexpr static wchar_t kGameInfo[9][53] = {
+    constexpr static wchar_t kGameInfo[10][53] = {
         LR"*( Press `?` to display this info-panel again.        )*",
+        LR"*( Press `h` to show how hot every command is.        )*",
         LR"*( Press `i` to insert the next command.              )*",
         LR"*( Press `o` to open a command file from local.       )*",
         LR"*( Press `p` to pause the game.                       )*",
@@ -59,7 +60,7 @@ class GamePanel {
         LR"*( Press **ANY KEY** to start the game...             )*"
     };
     constexpr static short kGameInfoWidth  = 53;
-    constexpr static short kGameInfoHeight = 9;
+    constexpr static short kGameInfoHeight = 10;
 
     constexpr static unsigned int kTotalLevel = 4;
     constexpr static unsigned int kMaxLevelOneLine = 6;
@@ -89,6 +90,17 @@ class GamePanel {
 
     // kGameCommandWindow* are the properties of command_window_
 
+    constexpr static short kGameHeatmapWindowWidth  = 18;
+    constexpr static short kGameHeatmapWindowHeight = 33;
+
+    // kGameHeatmapWindow* are the properties of heatmap_window_, it's on the right of
+    // command_window_ and every row is the command on the same row
+
+    constexpr static wchar_t kHeatShade[11] = L" .:-=+*#%@";
+    constexpr static short kHeatShadeCount = 10;
+
+    // kHeatShade is from cold to hot, a command which never runs is blank
+
     constexpr static short kGameStatusWindowWidth  = 110;
     constexpr static short kGameStatusWindowHeight = 3;
 
@@ -114,6 +126,7 @@ class GamePanel {
     WINDOW* target_window_;   // show the game target
     WINDOW* main_window_;     // show the game panel
     WINDOW* command_window_;  // show the player command
+    WINDOW* heatmap_window_;  // show the executions of every command
     WINDOW* status_window_;   // show the game status
 
     char input_key_;
@@ -124,6 +137,8 @@ class GamePanel {
     void showMain();
     void showPaused();
     void showHelp();
+    void showDiagnostic();
+    void showHeatmap();
 
   public:
     GamePanel(Core::Game* g) : game_(g) {}
@@ -0,0 +1,309 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file `accel.h`  //
+//======================================================//
+
+#include "accel.h"
+
+#include <algorithm>
+#include <climits>
+
+static constexpr unsigned long long kNever = ~0ULL;
+static constexpr unsigned int kRetryWait = 16;
+
+/**
+ * @program:     Core::LoopAccelerator::LoopAccelerator
+ * @description: This function finds the counting loops of the program, a loop is only
+ *               taken when all its operands are in the vacant, so no round of it can fail
+ *               on the range of operands
+ * @p:           The decoded program
+ * @vac_size:    The size of vacant
+ */
+Core::LoopAccelerator::LoopAccelerator(const Core::Program& p, int vac_size)
+    : at_( p.code_.size(), -1 )
+    , term_( 1 + vac_size )
+    , empty_( 1 + vac_size ) {
+    const auto& code = p.code_;
+    seen_.reserve(2 * code.size());
+    out_.reserve(code.size());
+
+    for (unsigned int e = 0; e < code.size(); ++e) {
+        if (code[e].op_ != Core::Opcode::kJump) continue;
+        const int target = code[e].operand_;
+        if (target < 1 || static_cast<unsigned int>(target) > e) continue;
+
+        // Only a jump backward to an earlier command is a back edge
+
+        Core::CountingLoop loop;
+        loop.header_ = target - 1;
+        loop.back_ = e;
+        loop.written_.assign(1 + vac_size, false);
+        int exits = 0;
+        bool ok = true;
+
+        for (unsigned int l = loop.header_; l < e && ok; ++l) {
+            const int x = code[l].operand_;
+            const bool in_vacant = x >= 0 && x < vac_size;
+
+            switch (code[l].op_) {
+            case Core::Opcode::kAdd :
+            case Core::Opcode::kSub :
+            case Core::Opcode::kCopyfrom :
+                ok = in_vacant;
+                loop.written_[0] = true;
+                break;
+            case Core::Opcode::kCopyto :
+                ok = in_vacant;
+                if (ok) loop.written_[1 + x] = true;
+                break;
+            case Core::Opcode::kOutbox :
+                ok = x == Core::Command::SingleCommand::kNullVacant;
+                loop.written_[0] = true;
+                break;
+            case Core::Opcode::kJumpifzero :
+                exits++;
+                loop.exit_ = l;
+                ok = x <= static_cast<int>(loop.header_) || x > static_cast<int>(e + 1);
+                break;
+            default :
+                ok = false;
+            }
+        }
+
+        // The target of exit is out of the loop, it may be out of the program, then the
+        // round which leaves fails as usual
+
+        if (ok && exits == 1) {
+            at_[e] = loops_.size();
+            loops_.push_back(std::move(loop));
+        }
+    }
+    wait_.assign(loops_.size(), 0);
+}
+
+/**
+ * @program:     Core::LoopAccelerator::accelerate
+ * @description: This function is called when the back edge of loop has just been executed.
+ *               It runs one round symbolically, each value is a value at the begin of round
+ *               plus a constant. When every value which the round depends on grows by the
+ *               same constant each round, the rounds before the last full round are skipped.
+ * @loop:        The index of loop, see loopAt
+ * @m:           The machine, it's at the header of loop
+ * @step_limit:  The step limit of run, 0 means no limit. The rounds skipped never reach it
+ * @profile:     The counts of skipped rounds are added to it when it's not nullptr
+ * @max_output:  The rounds skipped at once put at most so many boxes (at least one round
+ *               is skipped), so a caller which drains the output keeps it small. 0 means
+ *               no limit
+ * @return:      The count of rounds skipped, 0 when nothing is skipped and the caller
+ *               just goes on stepping
+ */
+unsigned long long Core::LoopAccelerator::accelerate(
+    const Core::Program& p,
+    int loop,
+    Core::Machine& m,
+    unsigned long long step_limit,
+    Core::Profile* profile,
+    std::size_t max_output
+) {
+    if (wait_[loop] > 0) {
+        wait_[loop]--;
+        return 0;
+    }
+    const Core::CountingLoop& c = loops_[loop];
+    const int vars = term_.size();
+
+    auto value = [&m](int base) -> long long {
+        return base == 0 ? m.handbox_ : m.vacant_[base - 1];
+    };
+    auto giveUp = [this, loop]() -> unsigned long long {
+        wait_[loop] = kRetryWait;
+        return 0;
+    };
+
+    // A loop which can't be skipped now is tried again after some rounds, so stepping it
+    // doesn't pay for the analysis every round
+
+    for (int v = 0; v < vars; ++v) {
+        term_[v] = c.written_[v] ? Term{ v, 0 } : Term{ Term::kConstant, value(v) };
+    }
+    empty_[0] = m.handbox_empty_;
+    std::copy(m.vacant_empty_.begin(), m.vacant_empty_.end(), empty_.begin() + 1);
+    seen_.clear();
+    out_.clear();
+
+    // Run one round symbolically, a value read from an empty place or a sum of two
+    // changing values is not handled
+
+    for (unsigned int l = c.header_; l < c.back_; ++l) {
+        const int x = p.code_[l].operand_;
+        Term& hand = term_[0];
+
+        switch (p.code_[l].op_) {
+        case Core::Opcode::kCopyfrom :
+            if (empty_[1 + x]) return giveUp();
+            hand = term_[1 + x];
+            empty_[0] = false;
+            break;
+        case Core::Opcode::kCopyto :
+            if (empty_[0]) return giveUp();
+            term_[1 + x] = hand;
+            empty_[1 + x] = false;
+            break;
+        case Core::Opcode::kOutbox :
+            if (empty_[0]) return giveUp();
+            out_.push_back(hand);
+            hand = { Term::kConstant, Core::Robot::kEmptyHandbox };
+            empty_[0] = true;
+            break;
+        case Core::Opcode::kAdd : {
+            if (empty_[0] || empty_[1 + x]) return giveUp();
+            const Term& b = term_[1 + x];
+            if (hand.base_ != Term::kConstant && b.base_ != Term::kConstant) return giveUp();
+            hand = { hand.base_ == Term::kConstant ? b.base_ : hand.base_, hand.off_ + b.off_ };
+            break;
+        }
+        case Core::Opcode::kSub : {
+            if (empty_[0] || empty_[1 + x]) return giveUp();
+            const Term& b = term_[1 + x];
+            if (b.base_ != Term::kConstant) return giveUp();
+            hand = { hand.base_, hand.off_ - b.off_ };
+            break;
+        }
+        case Core::Opcode::kJumpifzero :
+            if (empty_[0]) return giveUp();
+            break;
+        default :
+            return giveUp();
+        }
+        seen_.push_back(term_[0]);
+    }
+
+    // seen_[i] is the handbox after line header_ + i, out_ are the boxes put to the output
+
+    if (empty_[0] && !m.handbox_empty_) return giveUp();
+
+    // Rounds only fail on empty places, and a vacant is never emptied. The handbox is, so
+    // the next round may not start with an empty handbox unless this round did
+
+    auto step = [this](int base, long long& d) {
+        if (base == Term::kConstant) {
+            d = 0;
+            return true;
+        }
+        d = term_[base].off_;
+        return term_[base].base_ == base;
+    };
+
+    // A value changes by a constant every round only when it's its own value of last
+    // round plus the constant
+
+    long long d;
+    for (int v = 0; v < vars; ++v) {
+        if (c.written_[v] && !step(term_[v].base_, d)) return giveUp();
+    }
+    for (const Term& t : seen_) {
+        if (!step(t.base_, d)) return giveUp();
+    }
+    for (const Term& t : out_) {
+        if (!step(t.base_, d)) return giveUp();
+    }
+
+    // Every value read by the round depends on such values only. A value written but not
+    // read before the write is recomputed by the last full round, which is not skipped
+
+    const Term& test = seen_[c.exit_ - c.header_];
+    long long test_step;
+    step(test.base_, test_step);
+    const long long test_value = (test.base_ == Term::kConstant ? 0 : value(test.base_)) + test.off_;
+
+    unsigned long long exit_round = kNever;
+    if (test_value == 0) return 0;
+    if (test_step != 0 && -test_value % test_step == 0 && -test_value / test_step > 0) {
+        exit_round = -test_value / test_step;
+    }
+
+    // The handbox tested in round k is test_value + k * test_step, the loop leaves in the
+    // first round where it's 0
+
+    const unsigned long long length = c.back_ - c.header_ + 1;
+    unsigned long long rounds = exit_round;
+    if (step_limit != 0) {
+        rounds = std::min(rounds, step_limit > m.steps_ ? (step_limit - m.steps_) / length : 0);
+    }
+    if (rounds == kNever) return giveUp();
+    if (rounds < 2) return 0;
+    unsigned long long skip = rounds - 1;
+
+    // Without step limit a loop which never leaves runs forever anyway
+
+    for (int v = 0; v < vars; ++v) {
+        if (c.written_[v] && step(term_[v].base_, d) && d != 0) {
+            skip = std::min(skip, (1ULL << 32) / static_cast<unsigned long long>(d < 0 ? -d : d));
+        }
+    }
+
+    // The values stay in int, so no change is larger than 2^32, and the products below
+    // fit in long long
+
+    if (max_output != 0 && !out_.empty()) {
+        skip = std::min<unsigned long long>(skip, std::max<std::size_t>(max_output / out_.size(), 1));
+    }
+
+    // The rest of the rounds is skipped when the loop comes back to its back edge
+
+    auto fits = [](long long v) { return v >= INT_MIN && v <= INT_MAX; };
+    for (int v = 0; v < vars; ++v) {
+        if (c.written_[v] && term_[v].base_ == v && !fits(value(v) + static_cast<long long>(skip) * term_[v].off_)) {
+            return giveUp();
+        }
+    }
+    for (const Term& t : out_) seen_.push_back(t);
+    for (const Term& t : seen_) {
+        if (t.base_ == Term::kConstant) continue;
+        step(t.base_, d);
+        if (!fits(value(t.base_) + t.off_) ||
+            !fits(value(t.base_) + static_cast<long long>(skip - 1) * d + t.off_)) {
+            return giveUp();
+        }
+    }
+
+    // Skip the rounds : the boxes of every round are put to the output, the values which
+    // change by a constant are moved on, the others are left to the next round, and every
+    // vacant written in a round is not empty any more
+
+    if (!out_.empty()) m.output_.reserve(m.output_.size() + skip * out_.size());
+    for (unsigned long long k = 0; k < skip; ++k) {
+        for (const Term& t : out_) {
+            if (t.base_ == Term::kConstant) {
+                m.output_.push_back(t.off_);
+            } else {
+                step(t.base_, d);
+                m.output_.push_back(value(t.base_) + static_cast<long long>(k) * d + t.off_);
+            }
+        }
+    }
+
+    for (int v = 0; v < vars; ++v) {
+        if (!c.written_[v] || term_[v].base_ != v) continue;
+        const int moved = value(v) + static_cast<long long>(skip) * term_[v].off_;
+        if (v == 0) {
+            m.handbox_ = moved;
+        } else {
+            m.vacant_[v - 1] = moved;
+        }
+    }
+    m.handbox_empty_ = empty_[0];
+    std::copy(empty_.begin() + 1, empty_.end(), m.vacant_empty_.begin());
+    m.steps_ += skip * length;
+
+    if (profile != nullptr) {
+        for (unsigned int l = c.header_; l <= c.back_; ++l) profile->count_[l] += skip;
+        profile->not_taken_[c.exit_] += skip;
+        profile->steps_ += skip * length;
+    }
+    return skip;
+}
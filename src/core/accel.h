@@ -0,0 +1,83 @@
+#ifndef ACCEL_H
+#define ACCEL_H
+
+#include "engine.h"
+
+#include <vector>
+
+namespace Core {
+
+// Closed-form execution of counting loops. A counting loop is a straight block ended by a
+// `jump` back to its first command, with one `jumpifzero` leaving it and only outbox, add,
+// sub, copyto and copyfrom besides, e.g.
+//
+//     4: copyfrom 0       <- header
+//     5: jumpifzero 9     <- exit
+//     6: sub 1
+//     7: copyto 0
+//     8: jump 4           <- back edge
+//
+// When the block adds the same constant to every value it depends on in every round, the
+// values after k rounds are v + k * c, so the rounds before the last full one are skipped
+// at once, and the boxes which they put to the output are arithmetic sequences. Everything
+// else, including the last full round and the round which leaves, is executed as usual, so
+// the steps and the final state are the same as without skipping.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-26
+ */
+class CountingLoop {
+  public:
+    unsigned int header_;                   // Lines count from 0 here, header_ is the first line
+    unsigned int back_;                     // The line of `jump`
+    unsigned int exit_;                     // The line of `jumpifzero`
+    std::vector<unsigned char> written_;    // written_[0] is the handbox, written_[1 + i] is vacant i
+};
+
+/**
+ * LoopAccelerator finds the counting loops of a program once, and skips their rounds
+ * when the run reaches their back edge
+ *
+ * @author: AshGrey
+ * @date:   2024-12-26
+ */
+class LoopAccelerator {
+  public:
+    LoopAccelerator(const Program& p, int vac_size);
+
+    std::size_t size() const { return loops_.size(); }
+    int loopAt(unsigned int line) const { return at_[line]; }  // The loop whose back edge is line, or -1
+
+    unsigned long long accelerate(
+        const Program& p,
+        int loop,
+        Machine& m,
+        unsigned long long step_limit,
+        Profile* profile,
+        std::size_t max_output = 0
+    );
+
+  private:
+    class Term {
+      public:
+        static constexpr int kConstant = -1;
+        int base_;          // kConstant, 0 for the handbox or 1 + i for vacant i, at the begin of round
+        long long off_;
+    };
+
+    std::vector<int> at_;
+    std::vector<CountingLoop> loops_;
+    std::vector<unsigned int> wait_;        // Back edges to pass before trying a loop again
+
+    // Buffers of accelerate, they are allocated with the accelerator, not in the run
+
+    std::vector<Term> term_;
+    std::vector<Term> seen_;
+    std::vector<Term> out_;
+    std::vector<unsigned char> empty_;
+};
+
+}
+
+#endif
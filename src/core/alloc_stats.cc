@@ -0,0 +1,127 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `alloc_stats.h`                                      //
+//======================================================//
+
+#include "alloc_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static thread_local Core::AllocPhase current_phase = Core::AllocPhase::kPhaseOther;
+static thread_local Core::AllocStats thread_stats;
+
+// thread_stats is plain, so reading it in AllocRecorder costs nothing, the process
+// counters are atomics because every thread adds to them
+
+static std::array<std::atomic<unsigned long long>, Core::kAllocPhaseCount> process_count = {};
+static std::array<std::atomic<unsigned long long>, Core::kAllocPhaseCount> process_bytes = {};
+
+#ifdef ROBOX_ALLOC_STATS
+
+/**
+ * @program:     countAllocation
+ * @description: This function counts one allocation into the phase of the current thread
+ */
+static void countAllocation(std::size_t size) {
+    thread_stats.count_[current_phase]++;
+    thread_stats.bytes_[current_phase] += size;
+    process_count[current_phase].fetch_add(1, std::memory_order_relaxed);
+    process_bytes[current_phase].fetch_add(size, std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    countAllocation(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    countAllocation(size);
+    std::size_t a = static_cast<std::size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif
+
+unsigned long long Core::AllocStats::totalCount() const {
+    unsigned long long total = 0;
+    for (auto c : count_) total += c;
+    return total;
+}
+
+unsigned long long Core::AllocStats::totalBytes() const {
+    unsigned long long total = 0;
+    for (auto b : bytes_) total += b;
+    return total;
+}
+
+Core::AllocStats& Core::AllocStats::operator+=(const Core::AllocStats& s) {
+    for (int i = 0; i < Core::kAllocPhaseCount; ++i) {
+        count_[i] += s.count_[i];
+        bytes_[i] += s.bytes_[i];
+    }
+    return *this;
+}
+
+Core::AllocStats Core::AllocStats::operator-(const Core::AllocStats& s) const {
+    Core::AllocStats d;
+    for (int i = 0; i < Core::kAllocPhaseCount; ++i) {
+        d.count_[i] = count_[i] - s.count_[i];
+        d.bytes_[i] = bytes_[i] - s.bytes_[i];
+    }
+    return d;
+}
+
+Core::AllocStats Core::threadAllocStats() {
+    return thread_stats;
+}
+
+Core::AllocStats Core::processAllocStats() {
+    Core::AllocStats s;
+    for (int i = 0; i < Core::kAllocPhaseCount; ++i) {
+        s.count_[i] = process_count[i].load(std::memory_order_relaxed);
+        s.bytes_[i] = process_bytes[i].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+Core::AllocPhaseScope::AllocPhaseScope(Core::AllocPhase phase) : saved_(current_phase) {
+    current_phase = phase;
+}
+
+Core::AllocPhaseScope::~AllocPhaseScope() {
+    current_phase = saved_;
+}
+
+Core::AllocRecorder::AllocRecorder(Core::AllocStats& target, Core::AllocPhase phase)
+    : scope_(phase)
+    , target_(target)
+    , begin_(thread_stats) {}
+
+Core::AllocRecorder::~AllocRecorder() {
+    target_ += thread_stats - begin_;
+}
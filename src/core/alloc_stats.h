@@ -0,0 +1,86 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <array>
+
+namespace Core {
+
+// Allocation accounting is opt-in : configure with -DROBOX_ALLOC_STATS=ON (robox-bench
+// and Test-Alloc-Stats always have it). Then the global operator new in `alloc_stats.cc`
+// counts every allocation into the phase of the current thread, otherwise all counts are 0.
+
+enum AllocPhase {
+    kPhaseOther,
+    kPhaseLoad,     // Game::initialize, decodeProgram
+    kPhaseRun,      // The run loop of every engine
+    kPhaseVerify,   // Game::check
+    kPhaseLog       // Core::logMessage
+};
+
+constexpr static int kAllocPhaseCount = 5;
+constexpr static std::array<const char*, kAllocPhaseCount> kAllocPhaseName = {
+    "other", "load", "run", "verify", "log"
+};
+
+#ifdef ROBOX_ALLOC_STATS
+constexpr static bool kAllocStatsEnabled = true;
+#else
+constexpr static bool kAllocStatsEnabled = false;
+#endif
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-23
+ */
+class AllocStats {
+  public:
+    std::array<unsigned long long, kAllocPhaseCount> count_ = {};
+    std::array<unsigned long long, kAllocPhaseCount> bytes_ = {};
+
+    unsigned long long totalCount() const;
+    unsigned long long totalBytes() const;
+    AllocStats& operator+=(const AllocStats& s);
+    AllocStats operator-(const AllocStats& s) const;
+};
+
+AllocStats threadAllocStats();      // The allocations of the current thread
+AllocStats processAllocStats();     // The allocations of all threads
+
+/**
+ * AllocPhaseScope attributes the allocations of the current thread to a phase until
+ * it's destroyed, then the phase before it comes back
+ *
+ * @author: AshGrey
+ * @date:   2024-12-23
+ */
+class AllocPhaseScope {
+  public:
+    explicit AllocPhaseScope(AllocPhase phase);
+    ~AllocPhaseScope();
+
+  private:
+    AllocPhase saved_;
+};
+
+/**
+ * AllocRecorder is an AllocPhaseScope which also adds the allocations of the current
+ * thread during its life to `target`, Game::stats() is filled in this way. Don't nest
+ * two recorders on the same target, the inner allocations would be counted twice.
+ *
+ * @author: AshGrey
+ * @date:   2024-12-23
+ */
+class AllocRecorder {
+  public:
+    AllocRecorder(AllocStats& target, AllocPhase phase);
+    ~AllocRecorder();
+
+  private:
+    AllocPhaseScope scope_;
+    AllocStats& target_;
+    AllocStats begin_;
+};
+
+}
+
+#endif
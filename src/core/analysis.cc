@@ -0,0 +1,314 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `analysis.h`                                         //
+//======================================================//
+
+#include "analysis.h"
+
+#include <algorithm>
+#include <bit>
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class AbstractStep {
+  public:
+    bool succeeds_ = false;     // Some state gets through all the checks
+    bool next_ = false;         // The run may go on to the next line
+    bool target_ = false;       // The run may jump to the target
+    unsigned int errors_ = 0;   // Bit set of DiagnosticCode which may be raised
+};
+
+/**
+ * @program:     abstractStep
+ * @description: This function executes the command on an abstract state, the checks are
+ *               in the same order as Command::runRefCommand
+ * @tile:        Position of the tile of the operand in the state, when it's in the vacant
+ * @in:          Occupancy of the handbox and then every named tile before the command
+ * @out:         Occupancy after the command when it succeeds, it should be a copy of in
+ */
+static AbstractStep abstractStep(
+    const Core::Instruction& ins,
+    unsigned int size,
+    int vac_size,
+    std::size_t tile,
+    const unsigned char* in,
+    unsigned char* out
+) {
+    AbstractStep s;
+    const int x = ins.operand_;
+    const unsigned char hand = in[0];
+    const bool surplus = x != Core::Command::SingleCommand::kNullVacant;
+    const bool over = x > static_cast<int>(size);
+    bool alive = true;
+
+    auto check = [&](Core::DiagnosticCode c, bool may, bool must) {
+        if (!alive) return;
+        if (may) s.errors_ |= 1U << c;
+        if (must) alive = false;
+    };
+    auto mayEmpty = [](unsigned char o) { return (o & Core::Occupancy::kOccupancyEmpty) != 0; };
+    auto mustEmpty = [](unsigned char o) { return (o & Core::Occupancy::kOccupancyFull) == 0; };
+    auto range = [&]() {
+        check(Core::DiagnosticCode::kOpindexUnderflow, x < 0, x < 0);
+        check(Core::DiagnosticCode::kOpindexOverflow, x >= vac_size, x >= vac_size);
+    };
+
+    // A check which may fail lets the other states go on, one which must fail stops all
+
+    switch (ins.op_) {
+    case Core::Opcode::kInbox :
+        check(Core::DiagnosticCode::kOpindexSurplus, surplus, surplus);
+        if (alive) out[0] = Core::Occupancy::kOccupancyFull;
+        s.next_ = alive;
+        break;
+    case Core::Opcode::kOutbox :
+        check(Core::DiagnosticCode::kOpindexSurplus, surplus, surplus);
+        check(Core::DiagnosticCode::kHandboxEmpty, mayEmpty(hand), mustEmpty(hand));
+        if (alive) out[0] = Core::Occupancy::kOccupancyEmpty;
+        s.next_ = alive;
+        break;
+    case Core::Opcode::kAdd :
+    case Core::Opcode::kSub :
+    case Core::Opcode::kCopyto :
+    case Core::Opcode::kCopyfrom :
+        if (ins.op_ != Core::Opcode::kCopyfrom) {
+            check(Core::DiagnosticCode::kHandboxEmpty, mayEmpty(hand), mustEmpty(hand));
+        }
+        range();
+        if (alive && ins.op_ != Core::Opcode::kCopyto) {
+            check(Core::DiagnosticCode::kVacantEmpty, mayEmpty(in[tile]), mustEmpty(in[tile]));
+        }
+        if (alive) {
+            out[0] = Core::Occupancy::kOccupancyFull;
+            out[tile] = Core::Occupancy::kOccupancyFull;
+        }
+        s.next_ = alive;
+        break;
+    case Core::Opcode::kJump :
+        check(Core::DiagnosticCode::kCmindexUnderflow, x <= 0, x <= 0);
+        check(Core::DiagnosticCode::kCmindexOverflow, over, over);
+        s.target_ = alive;
+        break;
+    case Core::Opcode::kJumpifzero :
+        check(Core::DiagnosticCode::kHandboxEmpty, mayEmpty(hand), mustEmpty(hand));
+        if (!alive) break;
+        out[0] = Core::Occupancy::kOccupancyFull;
+        s.next_ = true;
+        s.target_ = x > 0 && !over;
+        if (x <= 0) s.errors_ |= 1U << Core::DiagnosticCode::kCmindexUnderflow;
+        if (over) s.errors_ |= 1U << Core::DiagnosticCode::kCmindexOverflow;
+        break;
+    }
+
+    // An empty handbox is 0, so jumpifzero always jumps with it. A full one may be 0 or
+    // not, and only the jump checks the target
+
+    s.succeeds_ = alive;
+    return s;
+}
+
+/**
+ * @program:     Core::ProgramAnalysis::faultAt
+ * @description: This function returns the error of line when it always fails with it
+ */
+std::optional<Core::Diagnostic> Core::ProgramAnalysis::faultAt(unsigned int line) const {
+    auto it = std::lower_bound(
+        definite_.begin(), definite_.end(), line + 1,
+        [](const Core::Diagnostic& d, unsigned int id) { return d.instruction_ < id; }
+    );
+    if (it == definite_.end() || it->instruction_ != line + 1) return std::nullopt;
+    return *it;
+}
+
+/**
+ * @program:     Core::namedTiles
+ * @description: This function returns the tiles of vacant which the operands of add, sub,
+ *               copyto and copyfrom name, sorted. The other tiles stay empty in every run
+ * @p:           The decoded program
+ * @vac_size:    The size of vacant
+ */
+std::vector<int> Core::namedTiles(const Core::Program& p, int vac_size) {
+    std::vector<int> tiles;
+    for (const auto& ins : p.code_) {
+        if (ins.op_ < Core::Opcode::kAdd || ins.op_ > Core::Opcode::kCopyfrom) continue;
+        if (ins.operand_ >= 0 && ins.operand_ < vac_size) tiles.push_back(ins.operand_);
+    }
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+    return tiles;
+}
+
+/**
+ * @program:     Core::analyzeProgram
+ * @description: This function finds the occupancy before every line on all paths, and then
+ *               classifies every line, see `analysis.h`. Only the named tiles are kept in
+ *               the state, so it doesn't grow with the vacant of large levels
+ * @p:           The decoded program
+ * @vac_size:    The size of vacant
+ */
+Core::ProgramAnalysis Core::analyzeProgram(const Core::Program& p, int vac_size) {
+    const auto& code = p.code_;
+    const unsigned int size = code.size();
+    vac_size = std::max(vac_size, 0);
+    const std::vector<int> tiles = Core::namedTiles(p, vac_size);
+    const std::size_t width = 1 + tiles.size();
+    Core::ProgramAnalysis a;
+    a.hand_.assign(size, Core::Occupancy::kOccupancyNone);
+    a.fate_.assign(size, Core::LineFate::kFateUnreached);
+    if (size == 0) return a;
+
+    std::vector<unsigned char> state(size * width, Core::Occupancy::kOccupancyNone);
+    std::vector<unsigned char> out(width);
+    std::vector<unsigned int> work;
+    std::vector<unsigned char> queued(size, false);
+
+    // Position of the tile of every line in the state, 0 when the operand isn't in the vacant
+
+    std::vector<std::size_t> tile(size, 0);
+    for (unsigned int line = 0; line < size; ++line) {
+        auto it = std::lower_bound(tiles.begin(), tiles.end(), code[line].operand_);
+        if (it != tiles.end() && *it == code[line].operand_) tile[line] = 1 + (it - tiles.begin());
+    }
+
+    auto flow = [&](unsigned int line) {
+        bool changed = false;
+        for (std::size_t i = 0; i < width; ++i) {
+            unsigned char& o = state[line * width + i];
+            changed |= (o | out[i]) != o;
+            o |= out[i];
+        }
+        if (changed && !queued[line]) {
+            queued[line] = true;
+            work.push_back(line);
+        }
+    };
+
+    std::fill(out.begin(), out.end(), Core::Occupancy::kOccupancyEmpty);
+    flow(0);
+    while (!work.empty()) {
+        const unsigned int line = work.back();
+        work.pop_back();
+        queued[line] = false;
+
+        const unsigned char* in = &state[line * width];
+        std::copy(in, in + width, out.begin());
+        AbstractStep s = abstractStep(code[line], size, vac_size, tile[line], in, out.data());
+        if (s.next_ && line + 1 < size) flow(line + 1);
+        if (s.target_) flow(code[line].operand_ - 1);
+    }
+
+    // The occupancy only grows, so the loop stops after a few rounds of every line
+
+    for (unsigned int line = 0; line < size; ++line) {
+        const unsigned char* in = &state[line * width];
+        a.hand_[line] = in[0];
+        if (in[0] == Core::Occupancy::kOccupancyNone) continue;
+
+        std::copy(in, in + width, out.begin());
+        AbstractStep s = abstractStep(code[line], size, vac_size, tile[line], in, out.data());
+        if (s.succeeds_) {
+            a.fate_[line] = s.errors_ == 0 ? Core::LineFate::kFateSafe : Core::LineFate::kFateMaybe;
+        } else if (std::popcount(s.errors_) == 1) {
+            a.fate_[line] = Core::LineFate::kFateDefinite;
+            a.definite_.push_back(Core::Diagnostic{
+                static_cast<Core::DiagnosticCode>(std::countr_zero(s.errors_)),
+                line + 1,
+                code[line].operand_
+            });
+        } else {
+            a.fate_[line] = Core::LineFate::kFateFails;
+        }
+    }
+    return a;
+}
+
+/**
+ * @program:     Core::staticVerdict
+ * @description: This function returns the error of the run without running it, when it
+ *               can be proven. The lines reached before a failing line must be safe and
+ *               without a cycle, so every run ends at a failing line within as many steps,
+ *               and the input must be long enough for every inbox among them. The error
+ *               is returned when only one failing line can be reached and it's definite.
+ *               Nothing is returned when the state would be larger than kAnalysisStates
+ * @level:       The level
+ * @cmd:         Commands, they are the pair of command name and vacant index
+ * @step_limit:  The step limit of run, 0 means no limit
+ * @return:      The same diagnostic as Core::runEngine, or nothing when it's unknown
+ */
+std::optional<Core::Diagnostic> Core::staticVerdict(
+    const Core::Level& level,
+    const Core::CommandList& cmd,
+    unsigned long long step_limit
+) {
+    auto p = Core::decodeProgram(cmd, level.available_cmd_);
+    if (!p) return p.error();
+
+    const auto& code = p->code_;
+    const unsigned int size = code.size();
+    if (size == 0) return std::nullopt;
+    if (Core::namedTiles(*p, level.vac_size_).size() + 1 > Core::kAnalysisStates / size) return std::nullopt;
+    Core::ProgramAnalysis a = Core::analyzeProgram(*p, level.vac_size_);
+
+    auto failing = [&a](unsigned int line) {
+        return a.fate_[line] == Core::LineFate::kFateFails || a.fate_[line] == Core::LineFate::kFateDefinite;
+    };
+    auto valid = [size](int x) { return x > 0 && x <= static_cast<int>(size); };
+
+    // Lines before the failing lines, found in depth first order. color is 0 before the
+    // visit, 1 in the current path and 2 after, a line met with 1 closes a cycle
+
+    std::vector<unsigned char> color(size, 0);
+    std::vector<std::pair<unsigned int, int>> stack;
+    std::optional<unsigned int> fault;
+    unsigned long long lines = 0, inboxes = 0;
+
+    auto enter = [&](unsigned int line) {
+        if (failing(line)) {
+            if (fault && *fault != line) return false;
+            fault = line;
+            return true;
+        }
+        if (color[line] == 1) return false;
+        if (color[line] == 2) return true;
+        if (a.fate_[line] != Core::LineFate::kFateSafe) return false;
+        color[line] = 1;
+        stack.push_back({ line, 0 });
+        lines++;
+        inboxes += code[line].op_ == Core::Opcode::kInbox;
+        return true;
+    };
+
+    if (!enter(0)) return std::nullopt;
+    while (!stack.empty()) {
+        const unsigned int line = stack.back().first;
+        int& edge = stack.back().second;
+        const Core::Instruction& ins = code[line];
+        const bool jumps = ins.op_ >= Core::Opcode::kJump;
+
+        if (edge == 0 && ins.op_ != Core::Opcode::kJump) {
+            edge = 1;
+            if (line + 1 == size) return std::nullopt;
+            if (!enter(line + 1)) return std::nullopt;
+        } else if (edge <= 1 && jumps) {
+            edge = 2;
+            if (!valid(ins.operand_) || !enter(ins.operand_ - 1)) return std::nullopt;
+        } else {
+            color[line] = 2;
+            stack.pop_back();
+        }
+    }
+
+    // A safe jumpifzero only reaches here with a full handbox and a valid target
+
+    if (!fault || a.fate_[*fault] != Core::LineFate::kFateDefinite) return std::nullopt;
+    if (inboxes > level.provided_seq_.size()) return std::nullopt;
+    if (step_limit != 0 && lines >= step_limit) return std::nullopt;
+    return a.faultAt(*fault);
+}
@@ -0,0 +1,70 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "engine.h"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace Core {
+
+// Abstract interpretation of decoded programs. Whether the handbox and every vacant hold a
+// box doesn't depend on the values of boxes, so it's tracked along every path as one of
+// empty, full or either, and every command is classified by what it can do when reached:
+//
+//  - safe: it never fails
+//  - maybe: it may fail, e.g. copyfrom of a vacant written on one path only
+//  - fails: it always fails, but the error depends on the path
+//  - definite: it always fails with the same diagnostic
+//
+// When every run must reach a definite error (see staticVerdict), the judge returns it
+// without running the program. The state only keeps the tiles which the operands name
+// (see namedTiles), every other tile is empty in every run, so the analysis costs the
+// size of the program however large the vacant is.
+
+enum Occupancy {
+    kOccupancyNone = 0,     // Not reached
+    kOccupancyEmpty = 1,
+    kOccupancyFull = 2,
+    kOccupancyAny = 3
+};
+
+enum LineFate {
+    kFateUnreached,
+    kFateSafe,
+    kFateMaybe,
+    kFateFails,
+    kFateDefinite
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class ProgramAnalysis {
+  public:
+    std::vector<unsigned char> hand_;       // Occupancy of the handbox before every line
+    std::vector<LineFate> fate_;
+    std::vector<Diagnostic> definite_;      // The errors of kFateDefinite lines, in line order
+
+    std::optional<Diagnostic> faultAt(unsigned int line) const;
+};
+
+// Bound of the lines times the tracked tiles, staticVerdict gives up on larger programs
+
+constexpr static std::size_t kAnalysisStates = 1 << 24;
+
+std::vector<int> namedTiles(const Program& p, int vac_size);
+
+ProgramAnalysis analyzeProgram(const Program& p, int vac_size);
+
+std::optional<Diagnostic> staticVerdict(
+    const Level& level,
+    const CommandList& cmd,
+    unsigned long long step_limit
+);
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+// ContentHash is two independent 64-bit hashes of the same words, the keys of the caches
+// (see `verdict_cache.h` and `program_cache.h`) are both of them, so a collision of the
+// 128 bits is not a concern for the count of programs a judge sees
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class ContentHash {
+  public:
+    std::uint64_t h_[2] = { 0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL };
+
+    /**
+     * @program:     Core::ContentHash::mix
+     * @description: This function is the finalizer of splitmix64, every bit of the input
+     *               changes half of the output
+     */
+    static std::uint64_t mix(std::uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    void add(std::uint64_t word) {
+        h_[0] = mix(h_[0] ^ word);
+        h_[1] = mix(h_[1] + word * 0x9e3779b97f4a7c15ULL);
+    }
+
+    void add(const std::string& s) {
+        add(s.size());
+        for (unsigned char c : s) add(c);
+    }
+
+    void add(const std::vector<int>& v) {
+        add(v.size());
+        for (int x : v) add(static_cast<std::uint32_t>(x));
+    }
+
+    // A box which fits int is the same word as in a vector of int, so the keys of levels
+    // don't change with the width of their boxes, the others have the top bit flipped and
+    // are never below 2^32
+
+    void add(const std::vector<std::int64_t>& v) {
+        add(v.size());
+        for (std::int64_t x : v) {
+            const bool fits = x >= INT32_MIN && x <= INT32_MAX;
+            add(fits ? static_cast<std::uint32_t>(x) : static_cast<std::uint64_t>(x) ^ (1ULL << 63));
+        }
+    }
+};
+
+}
+
+#endif
@@ -8,6 +8,9 @@
 //======================================================//
 
 #include "core.h"
+#include "engine.h"
+#include "metrics.h"
+#include "trace.h"
 
 #include <algorithm>
 #include <chrono>
@@ -20,11 +23,30 @@
 #include <thread>
 
 
+static bool log_enabled = true;
+
+/**
+ * @program:     Core::setLogEnabled
+ * @description: This function turns the log file on or off. When it's off, initLogFile and 
+ *               logMessage return at once, so batch runs don't open the log file every step,
+ *               and the commands don't even build their messages (see isLogEnabled)
+ * @enabled:     TRUE means writing the log file, FALSE when not
+ */
+void Core::setLogEnabled(bool enabled) {
+    log_enabled = enabled;
+}
+
+bool Core::isLogEnabled() {
+    return log_enabled;
+}
+
 /**
  * @program:     Core::initLogFile
  * @description: This function is to create `log` directory and the log file
  */
 void Core::initLogFile() {
+    if (!log_enabled) return;
+
     std::filesystem::create_directory(log);
 
     auto now = std::chrono::system_clock::now();
@@ -46,6 +68,10 @@ void Core::initLogFile() {
  * @type:        The type (or level) of message, there are two types : Info < Error
  */
 void Core::logMessage(const std::string& message, Core::LogLocation loc, Core::LogType type) {
+    if (!log_enabled) return;
+    Core::AllocPhaseScope scope(Core::AllocPhase::kPhaseLog);
+    Core::TraceSpan span("logMessage", "log");
+
     auto now = std::chrono::system_clock::now();
     auto time_t_now = std::chrono::system_clock::to_time_t(now);
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
@@ -85,6 +111,15 @@ void Core::logMessage(const std::string& message, Core::LogLocation loc, Core::L
                  << std::endl;
     }
 
+    if (log_file.good()) {
+        Core::addMetric(
+            Core::MetricCounter::kMetricLogBytes,
+            ss.str().size() + loc_str.size() + message.size() + 14
+        );
+    }
+
+    // Every line is "Xxxxx [" + time + "] #(" + location + ") " + message + '\n'
+
     log_file.close();
 }
 
@@ -129,6 +164,50 @@ void Core::Robot::initCommandList(const std::string& name, int index) {
         Core::LogType::kInfo
     );
 }
+/**
+ * @program:     Core::describeDiagnostic
+ * @description: This function renders the diagnostic to a readable message, it doesn't print
+ *               anything, Cli and Gui decide where the message goes
+ * @d:           The diagnostic returned by Core::Game
+ */
+std::string Core::describeDiagnostic(const Core::Diagnostic& d) {
+    std::string prefix = (d.instruction_ == 0) 
+                       ? std::string("Level : ")
+                       : "Command ID " + std::to_string(d.instruction_) + " : ";
+
+    switch (d.code_) {
+    case Core::DiagnosticCode::kNoError :
+        return "No error.";
+    case Core::DiagnosticCode::kUnknownCommand :
+        return prefix + "Unknown command (available command " + std::to_string(d.operand_ + 1) + "), "
+               "please check the entire supported command list by typing key `?`.";
+    case Core::DiagnosticCode::kUnavailableCommand :
+        return prefix + "Unknown command, please check the available command list by typing key `?`.";
+    case Core::DiagnosticCode::kOpindexSurplus :
+        return prefix + "Surplus operated vacant index, the command doesn't need an operated vacant index.";
+    case Core::DiagnosticCode::kOpindexOverflow :
+        return prefix + "Invalid operated vacant index, index (" + std::to_string(d.operand_) + 
+               ") is greater than or equal to vacant size.";
+    case Core::DiagnosticCode::kOpindexUnderflow :
+        return prefix + "Invalid operated vacant index, index (" + std::to_string(d.operand_) + 
+               ") is less than 0.";
+    case Core::DiagnosticCode::kVacantEmpty :
+        return prefix + "The operated vacant (" + std::to_string(d.operand_) + ") doesn't store any box.";
+    case Core::DiagnosticCode::kHandboxEmpty :
+        return prefix + "Robot doesn't take any box, but the command needs the handbox.";
+    case Core::DiagnosticCode::kCmindexOverflow :
+        return prefix + "This command jumps out of the end of command list.";
+    case Core::DiagnosticCode::kCmindexUnderflow :
+        return prefix + "This command jumps out of the begin of command list.";
+    case Core::DiagnosticCode::kStepLimitExceeded :
+        return prefix + "The game runs over the step limit.";
+    case Core::DiagnosticCode::kValueOverflow :
+        return d.instruction_ == 0
+             ? prefix + "Input box " + std::to_string(d.operand_ + 1) + " doesn't fit the value type of level."
+             : prefix + "The result overflows the value type of level.";
+    }
+    return prefix + "Unknown error.";
+}
 
 /**
  * @program:     Core::Game::initialize
@@ -139,49 +218,46 @@ void Core::Robot::initCommandList(const std::string& name, int index) {
  * @ns:          Needed sequence
  * @cmd:         Commands, they are the pair of command name and vacant index (default kNullVacant)
  * @vs:          The size of vacant
+ * @return:      The diagnostic when the level or the commands are illegal
  */
-void Core::Game::initialize(
+std::expected<void, Core::Diagnostic> Core::Game::initialize(
     std::vector<std::string>& a,
     std::vector<int>& ps,
     std::vector<int>& ns,
     std::vector<std::pair<std::string, int>>& cmd,
     int vs
 ) {
+    Core::AllocRecorder recorder(stats_, Core::AllocPhase::kPhaseLoad);
+    Core::TraceSpan span("Game::initialize", "load");
+
     vac_size_ = vs;                                 // pass the size of vacant
-    for (int i = 1; i <= vs; ++i) {
-        game_vacant_.seq_.push_back(0);             // Default num is 0
-        game_vacant_.seq_empty_.push_back(true);    // Default is empty
-    }
-    game_vacant_.seq_.resize(vs);                   // The vacant resizes to the given size
+    game_vacant_.seq_.assign(vs, 0);                // Default num is 0
+    game_vacant_.seq_empty_.assign(vs, true);       // Default is empty
     available_cmd_ = std::move(a);                  // Pass the available command to the private member
     provided_seq_ = std::move(ps);                  // Pass the provided sequence to the private member
     needed_seq_ = std::move(ns);                    // Pass the needed sequence to the private member
 
-    for (const auto& str : available_cmd_) {
+    for (const auto& e : provided_seq_) {
+        game_input_.seq_.push_back(e);
+    }
+
+    for (auto it = available_cmd_.begin(); it < available_cmd_.end(); ++it) {
         if (std::find(
                 Core::Command::kAllCmd.begin(), 
-                Core::Command::kAllCmd.end(), str
+                Core::Command::kAllCmd.end(), *it
             ) == Core::Command::kAllCmd.end()
         ) {
 
             // This condition means the str is illegal, so we need error here and return
 
-            Core::logMessage(
-                "Unknown command `" + str + "`, please check "
-                "the entire supported command list by typing key `?`.", 
-                Core::LogLocation::kCore, 
-                Core::LogType::kError
-            );
-            game_state_ = false;
-            error_state_ = true;
-            return;
+            return stop({ 
+                Core::DiagnosticCode::kUnknownCommand, 
+                0, 
+                static_cast<int>(it - available_cmd_.begin()) 
+            });
         }
     }
 
-    for (const auto& e : provided_seq_) {
-        game_input_.seq_.push_back(e);
-    }
-
     for (auto it = cmd.begin(); it < cmd.end(); ++it) {
         auto& [name, index] = *it;
         if (std::find(
@@ -193,21 +269,15 @@ void Core::Game::initialize(
             // This condition means the command name is not in the available commands, 
             // so we need error here and return
 
-            std::cout << "Error on instruction " + std::to_string(it - cmd.begin() + 1) << std::endl;
-            Core::logMessage(
-                "Command ID " + std::to_string(it - cmd.begin() + 1) + 
-                " : Unknown command `" + name + "`, please "
-                "check the available command list by typing "
-                "key `?`.", 
-                Core::LogLocation::kCore, 
-                Core::LogType::kError
-            );
-            game_state_ = false;
-            error_state_ = true;
-            return;
+            return stop({ 
+                Core::DiagnosticCode::kUnavailableCommand, 
+                static_cast<unsigned int>(it - cmd.begin() + 1), 
+                index 
+            });
         }
         game_robot_.initCommandList(name, index);
     }
+    profile_.reset(cmd.size());
 
     Core::logMessage(
         "Initialize the following variable : `Core::"
@@ -217,6 +287,16 @@ void Core::Game::initialize(
         Core::LogLocation::kCore, 
         Core::LogType::kInfo
     );
+    return {};
+}
+
+/**
+ * @program:     Core::Command::fail
+ * @description: This function builds the diagnostic of the command that is executed now
+ * @code:        The reason of the error
+ */
+std::unexpected<Core::Diagnostic> Core::Command::fail(Core::DiagnosticCode code) {
+    return std::unexpected(Core::Diagnostic{ code, ref_, list_[ref_ - 1].target_index_ });
 }
 
 /**
@@ -224,27 +304,15 @@ void Core::Game::initialize(
  * @description: This function is to check if the operated index (the operated 
                  vacant index of the command that is executed now) is surplus
  */
-bool Core::Command::checkOpindexSurplus() {
+std::expected<void, Core::Diagnostic> Core::Command::checkOpindexSurplus() {
     if (list_[ref_ - 1].target_index_ != Core::Command::SingleCommand::kNullVacant) {
 
         // Notice reference begins from **1** !!!, only use this function in no-parameter
         // command. If the no-parameter command has target index, then we need to error here
 
-        game_->setGameState(false);
-        game_->setErrorState(true);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Surplus operated vacant index, the "
-            "command `" + list_[ref_ - 1].cmd_name_ + "` doesn't need an operated "
-            "vacant index.", 
-            Core::LogLocation::kCore,
-            Core::LogType::kError
-        );
-        return true;
-    } else {
-        return false;
+        return fail(Core::DiagnosticCode::kOpindexSurplus);
     }
+    return {};
 }
 
 /**
@@ -252,168 +320,100 @@ bool Core::Command::checkOpindexSurplus() {
  * @description: This function is to check if the operated index (the operated
                  vacant index of the command that is executed now) is invalid
  */
-bool Core::Command::checkOpindexInvalid() {
-    if (list_[ref_ - 1].target_index_ >= vacant_->seq_.size()) {
+std::expected<void, Core::Diagnostic> Core::Command::checkOpindexInvalid() {
+    int index = list_[ref_ - 1].target_index_;
+    if (index < 0) {
 
-        // vacant index is greater than or equal to the size of vacant
-        // notice that the sequence of vacant counts from 0 !!!
+        // vacant index is less than 0, check it first because the comparison with
+        // the unsigned size of vacant treats negative index as a huge one
 
-        game_->setGameState(false);
-        game_->setErrorState(true);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Invalid operated vacant index, index (" +
-            std::to_string(list_[ref_ - 1].target_index_) + 
-            ") is greater than or equal to vacant size (" +
-            std::to_string(vacant_->seq_.size()) + ".", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kError);
-        return true;
-    } else if (list_[ref_ - 1].target_index_ < 0) {
+        return fail(Core::DiagnosticCode::kOpindexUnderflow);
+    } else if (static_cast<std::size_t>(index) >= vacant_->seq_.size()) {
 
-        // vacant index is less than 0
+        // vacant index is greater than or equal to the size of vacant
+        // notice that the sequence of vacant counts from 0 !!!
 
-        game_->setGameState(false);
-        game_->setErrorState(true);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Invalid operated vacant index, index (" +
-            std::to_string(list_[ref_ - 1].target_index_) + 
-            ") is less than 0.",
-            Core::LogLocation::kCore, 
-            Core::LogType::kError
-        );
-        return true;
+        return fail(Core::DiagnosticCode::kOpindexOverflow);
     } else if ((list_[ref_ - 1].cmd_name_ == "add"
              || list_[ref_ - 1].cmd_name_ == "sub"
              || list_[ref_ - 1].cmd_name_ == "copyfrom")
-             && vacant_->seq_empty_[list_[ref_ - 1].target_index_ - 1]) {
+             && vacant_->seq_empty_[index]) {
         
         // The target vacant is empty
         // for command "add", "sub" and "copyfrom", the target vacant cannot be empty!
 
-        game_->setGameState(false);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : The operated vacant doesn't store any box.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kError
-        );
-        return true;
-    } else {
-        return false;
+        return fail(Core::DiagnosticCode::kVacantEmpty);
     }
+    return {};
 }
 
 /**
  * @program:     Core::Command::checkHandboxEmpty
  * @description: This function is to check if there is a box in robot's hand.
-                 If there is, this function will return TRUE, otherwise FALSE
+                 If there isn't, this function will return the diagnostic
  */
-bool Core::Command::checkHandboxEmpty() {
+std::expected<void, Core::Diagnostic> Core::Command::checkHandboxEmpty() {
     if (owner_->isEmpty()) {
-        game_->setGameState(false);
-        game_->setErrorState(true);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot doesn't take any box, but the command "
-            "`" + list_[ref_ - 1].cmd_name_ + "` means put the handbox down.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kError
-        );
-        return true;
-    } else {
-        return false;
+        return fail(Core::DiagnosticCode::kHandboxEmpty);
     }
+    return {};
 }
 
-bool Core::Command::checkCmindexInvalid() {
-    if (ref_ > list_.size()) {
-        game_->setGameState(false);
-        game_->setErrorState(true);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : This command jumps out of the end of command list.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kError
-        );
-        return true;
-    } else if (ref_ <= 0) {
-        game_->setGameState(false);
-        game_->setErrorState(true);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : This command jumps out of the begin of command list.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kError
-        );
-        return true;
-    } else {
-        return false;
+/**
+ * @program:     Core::Command::checkCmindexInvalid
+ * @description: This function is to check if the jump target of the command that is
+                 executed now is in the command list
+ */
+std::expected<void, Core::Diagnostic> Core::Command::checkCmindexInvalid() {
+    int target = list_[ref_ - 1].target_index_;
+    if (target <= 0) {
+        return fail(Core::DiagnosticCode::kCmindexUnderflow);
+    } else if (static_cast<std::size_t>(target) > list_.size()) {
+        return fail(Core::DiagnosticCode::kCmindexOverflow);
     }
+    return {};
 }
 
 /**
  * @program:     Core::Command::checkInputEmpty
- * @description: This function is to check if the input is empty.
+ * @description: This function is to check if the input is empty. It's not an error,
+                 the game ends normally and checks the output.
  */
 bool Core::Command::checkInputEmpty() {
     if (input_->seq_.size() == 0) {
         game_->setGameState(false);
-        Core::logMessage(
-            "Input has been empty. Now check the game state.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Input has been empty. Now check the game state.", 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         return true;
     } else {
         return false;
     }
 }
 
-/**
- * @program:     Core::Command::checkVacantEmpty
- * @description: This function is to check if the target vacant is empty
- */
-bool Core::Command::checkVacantEmpty() {
-    if (!vacant_->seq_empty_[list_[ref_ - 1].target_index_]) {
-        game_->setErrorState(true);
-        game_->setGameState(false);
-        std::cout << "Error on instruction " + std::to_string(ref_) << std::endl;
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) + 
-            " : This command needs the target vacant not empty.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kError
-        );
-        return true;    // Empty
-    } else {
-        return false;   // Not empty
-    }
-}
-
 /**
  * @program:     Core::Command::runRefCommand
  * @description: This function is to run the reference command
+ * @return:      The diagnostic when the reference command goes wrong
  */
-void Core::Command::runRefCommand() {
+std::expected<void, Core::Diagnostic> Core::Command::runRefCommand() {
     if (ref_ == list_.size() + 1) {
 
         // All the commands have been executed, so we set the game state false
 
         game_->setGameState(false);
-        Core::logMessage(
-            "All command has been executed.",
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
-        return;
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "All command has been executed.",
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
+        return {};
     }
     
     int index = std::find(
@@ -421,59 +421,66 @@ void Core::Command::runRefCommand() {
         kAllCmd.end(), 
         list_[ref_ - 1].cmd_name_
     ) - kAllCmd.begin();
+    const unsigned int line = ref_ - 1;
 
-    // Get the index of this command
+    // Get the index of this command, and the line of it for the profile
+
+    std::expected<void, Core::Diagnostic> result;
 
     switch (index) {
     case 0 : // "inbox"
-        if (checkOpindexSurplus()) return;
+        if (!(result = checkOpindexSurplus())) return result;
         
         // Check if vacant index is given, "inbox" command doesn't need parameter
 
-        if (checkInputEmpty()) return;
+        if (checkInputEmpty()) return {};
         
         // Check if input is empty, if true, then the game ends
 
         owner_->setValue(input_->seq_.front());
         owner_->setState(false);
         input_->seq_.pop_front();
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot takes the box (value : " + 
-            std::to_string(owner_->getValue()) + ") from the input.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot takes the box (value : " + 
+                std::to_string(owner_->getValue()) + ") from the input.", 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_++;
         break;
     case 1 : // "outbox"
-        if (checkOpindexSurplus()) return;
+        if (!(result = checkOpindexSurplus())) return result;
         
         // Check if vacant index is given. "outbox" command doesn't need parameter
 
-        if (checkHandboxEmpty()) return;
+        if (!(result = checkHandboxEmpty())) return result;
         
         // Check if the handbox is empty. "outbox" command needs the robot holds a box
 
         output_->seq_.push_back(owner_->getValue());    // Put the box to output
         owner_->setValue(Core::Robot::kEmptyHandbox);   // Robot doesn't hold this box anymore
         owner_->setState(true);
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot puts the handbox (value : " +
-            std::to_string(output_->seq_.back()) +
-            ") down on the output.", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot puts the handbox (value : " +
+                std::to_string(output_->seq_.back()) +
+                ") down on the output.", 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_++;
         break;
     case 2 : // "add"
-        if (checkHandboxEmpty()) return;
+        if (!(result = checkHandboxEmpty())) return result;
         
         // Check if the handbox is empty. "add" command needs the robot holding a box
 
-        if (checkOpindexInvalid()) return;
+        if (!(result = checkOpindexInvalid())) return result;
         
         // Check if vacant index is invalid.
 
@@ -483,25 +490,27 @@ void Core::Command::runRefCommand() {
         //                                    Notice command reference begins from **1**
         //                                    Vacant index begins from **0**
 
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot adds the number (" + 
-            std::to_string(vacant_->seq_[list_[ref_ - 1].target_index_]) +
-            ") of operated vacant index (" + 
-            std::to_string(list_[ref_ - 1].target_index_) +
-            "), and the handbox becomes " +
-            std::to_string(owner_->getValue()), 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot adds the number (" + 
+                std::to_string(vacant_->seq_[list_[ref_ - 1].target_index_]) +
+                ") of operated vacant index (" + 
+                std::to_string(list_[ref_ - 1].target_index_) +
+                "), and the handbox becomes " +
+                std::to_string(owner_->getValue()), 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_++;
         break;
     case 3 : // "sub"
-        if (checkHandboxEmpty()) return;
+        if (!(result = checkHandboxEmpty())) return result;
         
         // Check if the handbox is empty. "sub" command needs the robot holding a box
 
-        if (checkOpindexInvalid()) return;
+        if (!(result = checkOpindexInvalid())) return result;
         
         // Check if vacant index is invalid
 
@@ -511,175 +520,221 @@ void Core::Command::runRefCommand() {
         //                                    Notice command reference begins from **1**
         //                                    Vacant index begins from **0**
 
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot subs the number (" +
-            std::to_string(vacant_->seq_[list_[ref_ - 1].target_index_]) +
-            ") of operated vacant index (" + 
-            std::to_string(list_[ref_ - 1].target_index_) +
-            "), and the handbox becomes " +
-            std::to_string(owner_->getValue()), 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot subs the number (" +
+                std::to_string(vacant_->seq_[list_[ref_ - 1].target_index_]) +
+                ") of operated vacant index (" + 
+                std::to_string(list_[ref_ - 1].target_index_) +
+                "), and the handbox becomes " +
+                std::to_string(owner_->getValue()), 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_++;
         break;
     case 4 : // "copyto"
-        if (checkHandboxEmpty()) return;
+        if (!(result = checkHandboxEmpty())) return result;
         
         // Check if the handbox is empty. "copyto" command needs the robot holding a box
 
-        if (checkOpindexInvalid()) return;
+        if (!(result = checkOpindexInvalid())) return result;
         
         // Check if vacant index is invalid
 
         vacant_->seq_[list_[ref_ - 1].target_index_] = owner_->getValue();  // Put the box to the vacant
         vacant_->seq_empty_[list_[ref_ - 1].target_index_] = false;         // Set the vacant state to not-empty
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot copy its handbox to the number of operated vacant index (" +
-            std::to_string(list_[ref_ - 1].target_index_) + ").", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot copy its handbox to the number of operated vacant index (" +
+                std::to_string(list_[ref_ - 1].target_index_) + ").", 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_++;
         break;
     case 5 : // "copyfrom"
-        if (checkOpindexInvalid()) return;
-        
-        // Check if vacant index is invalid
-
-        if (checkVacantEmpty()) return;
+        if (!(result = checkOpindexInvalid())) return result;
         
-        // Check if the vacant is empty
+        // Check if vacant index is invalid or the vacant is empty
 
-        owner_->setValue(vacant_->seq_[list_[ref_ - 1].target_index_ - 1]);
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot copy from the number of operated vacant index (" +
-            std::to_string(list_[ref_ - 1].target_index_) +
-            ") to its handbox, now the handbox is " +
-            std::to_string(owner_->getValue()), 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        owner_->setValue(vacant_->seq_[list_[ref_ - 1].target_index_]);
+        owner_->setState(false);
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot copy from the number of operated vacant index (" +
+                std::to_string(list_[ref_ - 1].target_index_) +
+                ") to its handbox, now the handbox is " +
+                std::to_string(owner_->getValue()), 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_++;
         break;
     case 6 : // jump
-        if (checkCmindexInvalid()) return;
+        if (!(result = checkCmindexInvalid())) return result;
         
         // Check if there is the target command ID
 
-        Core::logMessage(
-            "Command ID " + std::to_string(ref_) +
-            " : Robot's current command jumps to the index " +
-            std::to_string(list_[ref_ - 1].target_index_) + " command", 
-            Core::LogLocation::kCore, 
-            Core::LogType::kInfo
-        );
+        if (Core::isLogEnabled()) {
+            Core::logMessage(
+                "Command ID " + std::to_string(ref_) +
+                " : Robot's current command jumps to the index " +
+                std::to_string(list_[ref_ - 1].target_index_) + " command", 
+                Core::LogLocation::kCore, 
+                Core::LogType::kInfo
+            );
+        }
         ref_ = list_[ref_ - 1].target_index_; 
         break;
     case 7 : // jumpifzero
         if (owner_->getValue() == 0) {
-            if (checkHandboxEmpty()) return;
+            if (!(result = checkHandboxEmpty())) return result;
             
             // Check if there is any box held by robot
 
-            if (checkCmindexInvalid()) return;
+            if (!(result = checkCmindexInvalid())) return result;
             
             // Check if there is the target command ID
 
             ref_ = list_[ref_ - 1].target_index_;
-            Core::logMessage(
-                "Command ID " + std::to_string(ref_) +
-                " : Robot's current command jumps to the index " +
-                std::to_string(ref_) + " command, because handbox is 0.", 
-                Core::LogLocation::kCore, 
-                Core::LogType::kInfo
-            );
+            if (Core::isLogEnabled()) {
+                Core::logMessage(
+                    "Command ID " + std::to_string(ref_) +
+                    " : Robot's current command jumps to the index " +
+                    std::to_string(ref_) + " command, because handbox is 0.", 
+                    Core::LogLocation::kCore, 
+                    Core::LogType::kInfo
+                );
+            }
+            if (profile_ != nullptr) profile_->taken_[line]++;
         } else {
             ref_++;
+            if (profile_ != nullptr) profile_->not_taken_[line]++;
         }
     }
+    steps_++;
+    if (profile_ != nullptr) {
+        profile_->count_[line]++;
+        profile_->steps_++;
+    }
+    return {};
+}
+
+/**
+ * @program:     Core::Game::stop
+ * @description: This function stops the game with an error and keeps the diagnostic,
+ *               so Cli and Gui can render it later
+ * @d:           The diagnostic of the error
+ */
+std::unexpected<Core::Diagnostic> Core::Game::stop(const Core::Diagnostic& d) {
+    game_state_ = false;
+    error_state_ = true;
+    diagnostic_ = d;
+    return std::unexpected(d);
 }
 
 /**
  * @program:     Core::Game::check
  * @description: This function checks the game state when all commands have been executed 
  *               or the input is empty
+ * @return:      kSuccess when the output is same as needed, otherwise kFail
  */
-void Core::Game::check() {
-    if (error_state_) return;
-
-    bool f = true;
-    unsigned int count = 0;
-    f = (game_output_.seq_.size() == needed_seq_.size());
-
-    while (game_output_.seq_.size() != 0) {
-        int e = game_output_.seq_.front();
-        game_output_.seq_.pop_front();
-        if (e != needed_seq_[count]) {
-            f = false;
-            break;
-        }
-        count++;
-    }
+Core::Verdict Core::Game::check() {
+    Core::AllocRecorder recorder(stats_, Core::AllocPhase::kPhaseVerify);
+    Core::TraceSpan span("Game::check", "verify");
+
+    bool f = std::equal(
+        game_output_.seq_.begin(), game_output_.seq_.end(),
+        needed_seq_.begin(), needed_seq_.end()
+    );
 
-    // Check the game output == needed sequence
+    // Check the game output == needed sequence, the output is kept for Cli and Gui
 
     if (f) {
-        std::cout << "Success" << std::endl;
         Core::logMessage(
             "Success! The output is same as needed.", 
             Core::LogLocation::kCore,
             Core::LogType::kInfo
         );
+        return Core::Verdict::kSuccess;
     } else {
-        std::cout << "Fail" << std::endl;
         Core::logMessage(
             "Fail! The output is not same as needed.", 
             Core::LogLocation::kCore, 
             Core::LogType::kInfo
         );
+        return Core::Verdict::kFail;
     }
 }
 
 /**
- * @program:     Core::Game::runAll
- * @description: This function is to run all commands from begin to end
+ * @program:     Core::Game::runLoop
+ * @description: This function runs commands until the game ends, or the target reference
+ *               is reached
+ * @param:       target_ref : The target reference of commands, 0 means no target
  */
-void Core::Game::runAll() {
-    game_state_ = !error_state_;
-
-    // First set game state the negation of error state
-
-    while (game_state_ && !error_state_) {
-        game_robot_.runRefCommand();
+std::expected<void, Core::Diagnostic> Core::Game::runLoop(int target_ref) {
+    Core::AllocRecorder recorder(stats_, Core::AllocPhase::kPhaseRun);
+    Core::TraceSpan span("Game::runLoop", "run");
+
+    while (game_state_) {
+        if (step_limit_ != 0 && game_robot_.getSteps() >= step_limit_) {
+            return stop({ 
+                Core::DiagnosticCode::kStepLimitExceeded, 
+                static_cast<unsigned int>(game_robot_.getRef()), 
+                0 
+            });
+        }
+        if (auto result = game_robot_.runRefCommand(); !result) {
+            return stop(result.error());
+        }
+        if (target_ref != 0 && target_ref == game_robot_.getRef()) {
+            game_state_ = false;
+        }
         std::this_thread::sleep_for(std::chrono::seconds(game_gap_));
 
         // pause to wait for the animation of robot
 
     }
-    check();
+    return {};
+}
+
+/**
+ * @program:     Core::Game::runAll
+ * @description: This function is to run all commands from begin to end
+ * @return:      The verdict of the game, or the diagnostic when a command goes wrong
+ */
+std::expected<Core::Verdict, Core::Diagnostic> Core::Game::runAll() {
+    if (error_state_) return std::unexpected(diagnostic_);
+    game_state_ = true;
+
+    if (auto result = runLoop(0); !result) {
+        return std::unexpected(result.error());
+    }
+    return check();
 }
 
 /**
  * @program:     Core::Game::runTo
  * @description: This function is to run all commands from begin to the target reference
  * @param:       target_ref : The target reference of commands
+ * @return:      The verdict of the game, or the diagnostic when a command goes wrong
  */
-void Core::Game::runTo(int target_ref) {
-    game_state_ = !error_state_;
-    while (game_state_ && error_state_) {
-        game_robot_.runRefCommand();
-        if (target_ref == game_robot_.getRef()) {
-            game_state_ = false;
-        }
-        std::this_thread::sleep_for(std::chrono::seconds(game_gap_));
+std::expected<Core::Verdict, Core::Diagnostic> Core::Game::runTo(int target_ref) {
+    if (error_state_) return std::unexpected(diagnostic_);
+    game_state_ = true;
 
-        // pause to wait for the animation of robot
+    if (auto result = runLoop(target_ref); !result) {
+        return std::unexpected(result.error());
     }
-    check();
+    return check();
 }
 
 /**
@@ -687,14 +742,56 @@ void Core::Game::runTo(int target_ref) {
  * @description: This function is to run all commands from begin to end **again**
  */
 void Core::Game::restart() {
+    profile_.reset(game_robot_.getSize());
     game_state_ = true;
     error_state_ = false;
+    diagnostic_ = Core::Diagnostic();
     game_robot_.setRef(1);
-    game_vacant_.seq_.clear();
-    game_vacant_.seq_empty_.clear();
+    game_robot_.setSteps(0);
+    game_robot_.setValue(Core::Robot::kEmptyHandbox);
+    game_robot_.setState(true);
+    game_vacant_.seq_.assign(vac_size_, 0);
+    game_vacant_.seq_empty_.assign(vac_size_, true);
     game_input_.seq_.clear();
     game_output_.seq_.clear();
     for (const auto& e : provided_seq_) {
         game_input_.seq_.push_back(e);
     }
+}
+
+/**
+ * @program:     Core::Game::setProfiling
+ * @description: This function turns the profile on or off. Counting is a branch and an
+ *               increment per step, so it can be left on while grading
+ * @p:           TRUE means counting the executions of every command
+ */
+void Core::Game::setProfiling(bool p) {
+    profiling_ = p;
+    game_robot_.setProfile(p ? &profile_ : nullptr);
+}
+
+/**
+ * @program:     Core::Game::snapshot
+ * @description: This function flattens the state of game to a Core::Machine, so the game
+ *               can be compared with the other engines. The vacant of a large level is
+ *               flattened to the sparse one, as the engines keep it
+ */
+Core::Machine Core::Game::snapshot() {
+    Core::Machine m;
+    m.reset(vac_size_);
+    m.ref_ = game_robot_.getRef();
+    m.handbox_ = game_robot_.getValue();
+    m.handbox_empty_ = game_robot_.isEmpty();
+    if (m.sparse()) {
+        for (int i = 0; i < vac_size_; ++i) {
+            if (!game_vacant_.seq_empty_[i]) m.sparse_.put(i, game_vacant_.seq_[i]);
+        }
+    } else {
+        m.vacant_.assign(game_vacant_.seq_.begin(), game_vacant_.seq_.end());
+        m.vacant_empty_.assign(game_vacant_.seq_empty_.begin(), game_vacant_.seq_empty_.end());
+    }
+    m.input_pos_ = provided_seq_.size() - game_input_.seq_.size();
+    m.output_.assign(game_output_.seq_.begin(), game_output_.seq_.end());
+    m.steps_ = game_robot_.getSteps();
+    return m;
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #ifndef CORE_H
 #define CORE_H
 
+#include "alloc_stats.h"
+#include "profile.h"
+
 #include <array>
 #include <deque>
+#include <expected>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -20,6 +24,45 @@ enum LogLocation {
     kGui
 };
 
+/**
+ * DiagnosticCode is the reason why the game stops with an error. Core never prints
+ * it, the code is returned to the caller and Cli / Gui decide how to render it.
+ */
+enum DiagnosticCode {
+    kNoError,
+    kUnknownCommand,        // The available command is not in Command::kAllCmd
+    kUnavailableCommand,    // The command is not in the available commands of level
+    kOpindexSurplus,        // No-parameter command has an operated vacant index
+    kOpindexOverflow,       // Operated vacant index >= vacant size
+    kOpindexUnderflow,      // Operated vacant index < 0
+    kVacantEmpty,           // Operated vacant doesn't store any box
+    kHandboxEmpty,          // Robot doesn't take any box
+    kCmindexOverflow,       // Jump target is after the end of command list
+    kCmindexUnderflow,      // Jump target is before the begin of command list
+    kStepLimitExceeded,     // The game runs more steps than the step limit
+    kValueOverflow          // The value doesn't fit the value type of level, see Core::ValueKind
+};
+
+enum Verdict {
+    kSuccess,
+    kFail
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+class Diagnostic {
+  public:
+    DiagnosticCode code_ = kNoError;
+    unsigned int instruction_ = 0;  // Command ID (counts from 1) of the fault, 0 means the level itself
+    int operand_ = 0;               // The operated index of the fault command, or index of available command
+
+    bool operator==(const Diagnostic& d) const = default;
+};
+
+std::string describeDiagnostic(const Diagnostic& d);
+
 void logMessage(
     const std::string& message, 
     LogLocation loc, 
@@ -27,6 +70,8 @@ void logMessage(
 );
 
 void initLogFile();
+void setLogEnabled(bool enabled);   // Batch runs (fuzz, bench, judge) turn the log file off
+bool isLogEnabled();
 
 constexpr static std::string log_directory = "log";
 const static std::filesystem::path log(log_directory);
@@ -34,6 +79,8 @@ static std::string log_name;
 
 class Robot;
 class Game;
+template <class Value> class BasicMachine;
+using Machine = BasicMachine<int>;
 
 // forward declaration
 
@@ -105,15 +152,21 @@ class Command {
 
     ~Command() = default;
 
-    void runRefCommand();
+    std::expected<void, Diagnostic> runRefCommand();
     void appendToList(const std::string& name, int index);
     int getRef() { return ref_; }
     void setRef(int r) { ref_ = r; }
+    unsigned long long getSteps() { return steps_; }
+    void setSteps(unsigned long long s) { steps_ = s; }
+    void setProfile(Profile* p) { profile_ = p; }
+    std::size_t getSize() { return list_.size(); }
 
   private:
     
     std::vector<SingleCommand> list_; // A list of all command
     unsigned int ref_ = 1;            // Reference to the command which is executed now
+    unsigned long long steps_ = 0;    // Count of commands executed successfully
+    Profile* profile_ = nullptr;      // Counts the executions when it's not nullptr
 
     Game* game_;
     Robot* owner_;
@@ -121,12 +174,13 @@ class Command {
     Output* output_;
     Vacant* vacant_;
 
-    bool checkOpindexSurplus(); // `Opindex` stands for `Operated Index`
-    bool checkOpindexInvalid();
-    bool checkHandboxEmpty();
-    bool checkCmindexInvalid(); // `Cmindex` stands for `Command Index`
+    std::unexpected<Diagnostic> fail(DiagnosticCode code);
+
+    std::expected<void, Diagnostic> checkOpindexSurplus(); // `Opindex` stands for `Operated Index`
+    std::expected<void, Diagnostic> checkOpindexInvalid();
+    std::expected<void, Diagnostic> checkHandboxEmpty();
+    std::expected<void, Diagnostic> checkCmindexInvalid(); // `Cmindex` stands for `Command Index`
     bool checkInputEmpty();
-    bool checkVacantEmpty();
 
 };
 
@@ -159,9 +213,13 @@ class Robot {
 
     // These functions are designed to pass the information of command list
 
-    void runRefCommand() { cmd_.runRefCommand(); }
+    std::expected<void, Diagnostic> runRefCommand() { return cmd_.runRefCommand(); }
     int getRef() { return cmd_.getRef(); }
     void setRef(int r) { cmd_.setRef(r); }
+    unsigned long long getSteps() { return cmd_.getSteps(); }
+    void setSteps(unsigned long long s) { cmd_.setSteps(s); }
+    void setProfile(Profile* p) { cmd_.setProfile(p); }
+    std::size_t getSize() { return cmd_.getSize(); }
 
     void initCommandList(const std::string& name, int index);
 };
@@ -175,6 +233,7 @@ class Game {
     bool game_state_ = true;    // TRUE means game is running correctly, FALSE when not
     bool error_state_ = false;  // TRUE means there is a happened error, FALSE when not
     int game_gap_ = 0;          // Game gap sets the gap between one command and the next command
+    unsigned long long step_limit_ = 0; // The game stops with an error after so many steps, 0 means no limit
     std::vector<std::string> available_cmd_;
     std::vector<int> provided_seq_, needed_seq_;
     int vac_size_;
@@ -182,13 +241,19 @@ class Game {
     Input game_input_;
     Output game_output_;
     Vacant game_vacant_;
+    Diagnostic diagnostic_;     // The last error, code is kNoError when there is no error
+    AllocStats stats_;          // Allocations of this game by phase, see `alloc_stats.h`
+    Profile profile_;           // Executions of every command, only counted when profiling
+    bool profiling_ = false;
 
-    void check();
+    Verdict check();
+    std::expected<void, Diagnostic> runLoop(int target_ref);
+    std::unexpected<Diagnostic> stop(const Diagnostic& d);
 
   public:
     Game() : game_robot_(this, &game_input_, &game_output_, &game_vacant_) { initLogFile(); }
 
-    void initialize(
+    std::expected<void, Diagnostic> initialize(
         std::vector<std::string>& a,
         std::vector<int>& ps,
         std::vector<int>& ns,
@@ -202,9 +267,17 @@ class Game {
     void setErrorState(bool e) { error_state_ = e; }
     int getGap() { return game_gap_; }
     void setGap(int v) { game_gap_ = v; }
-
-    void runAll();
-    void runTo(int target_ref);
+    unsigned long long getStepLimit() { return step_limit_; }
+    void setStepLimit(unsigned long long l) { step_limit_ = l; }
+    const Diagnostic& getDiagnostic() { return diagnostic_; }
+    Machine snapshot();
+    const AllocStats& stats() { return stats_; }    // Accumulates over restart, all 0 without ROBOX_ALLOC_STATS
+    bool getProfiling() { return profiling_; }
+    void setProfiling(bool p);
+    const Profile& profile() { return profile_; }   // Counts since initialize or restart
+
+    std::expected<Verdict, Diagnostic> runAll();
+    std::expected<Verdict, Diagnostic> runTo(int target_ref);
     void pause() { game_state_ = false; }
     void start() { game_state_ = true; }
     void restart();
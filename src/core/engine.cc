@@ -0,0 +1,727 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file `engine.h` //
+//======================================================//
+
+#include "engine.h"
+#include "accel.h"
+#include "expected_output.h"
+#include "hot_trace.h"
+#include "input_source.h"
+#include "metrics.h"
+#include "optimizer.h"
+#include "program_cache.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+/**
+ * @program:     Core::BasicMachine::reset
+ * @description: This function resets the machine to the state before the first command.
+ *               A vacant of more than kDenseVacant tiles is sparse, so resetting it only
+ *               clears the tiles put by the last run
+ * @vac_size:    The size of vacant
+ */
+template <class Value>
+void Core::BasicMachine<Value>::reset(int vac_size) {
+    ref_ = 1;
+    handbox_ = Core::Robot::kEmptyHandbox;
+    handbox_empty_ = true;
+    if (vac_size > Core::kDenseVacant) {
+        vacant_.clear();
+        vacant_empty_.clear();
+        sparse_.reset(vac_size);
+    } else {
+        vacant_.assign(vac_size, 0);
+        vacant_empty_.assign(vac_size, true);
+        sparse_.reset(0);
+    }
+    input_pos_ = 0;
+    output_.clear();
+    steps_ = 0;
+}
+
+template class Core::BasicMachine<std::int16_t>;
+template class Core::BasicMachine<int>;
+template class Core::BasicMachine<std::int64_t>;
+
+/**
+ * @program:     Core::engineName
+ * @description: This function returns the name of engine, used by fuzz and bench output
+ */
+std::string Core::engineName(Core::EngineKind kind) {
+    switch (kind) {
+    case Core::EngineKind::kReferenceEngine : return "reference";
+    case Core::EngineKind::kDecodedEngine :   return "decoded";
+    case Core::EngineKind::kAcceleratedEngine : return "accelerated";
+    case Core::EngineKind::kTracingEngine :     return "tracing";
+    case Core::EngineKind::kOptimizedEngine :   return "optimized";
+    }
+    return "unknown";
+}
+
+/**
+ * @program:     Core::decodeProgram
+ * @description: This function decodes the command names to opcodes once, so the engine
+ *               doesn't compare strings in every step. The diagnostics are the same as
+ *               Core::Game::initialize
+ * @cmd:         Commands, they are the pair of command name and vacant index
+ * @available:   Available commands of the level
+ */
+std::expected<Core::Program, Core::Diagnostic> Core::decodeProgram(
+    const Core::CommandList& cmd,
+    const std::vector<std::string>& available
+) {
+    for (auto it = available.begin(); it < available.end(); ++it) {
+        if (std::find(
+                Core::Command::kAllCmd.begin(),
+                Core::Command::kAllCmd.end(), *it
+            ) == Core::Command::kAllCmd.end()
+        ) {
+            return std::unexpected(Core::Diagnostic{
+                Core::DiagnosticCode::kUnknownCommand,
+                0,
+                static_cast<int>(it - available.begin())
+            });
+        }
+    }
+
+    Core::Program p;
+    p.code_.reserve(cmd.size());
+    for (auto it = cmd.begin(); it < cmd.end(); ++it) {
+        const auto& [name, index] = *it;
+        if (std::find(available.begin(), available.end(), name) == available.end()) {
+            return std::unexpected(Core::Diagnostic{
+                Core::DiagnosticCode::kUnavailableCommand,
+                static_cast<unsigned int>(it - cmd.begin() + 1),
+                index
+            });
+        }
+        auto op = std::find(
+            Core::Command::kAllCmd.begin(),
+            Core::Command::kAllCmd.end(), name
+        ) - Core::Command::kAllCmd.begin();
+        p.code_.push_back({ static_cast<Core::Opcode>(op), index });
+    }
+    return p;
+}
+
+/**
+ * @program:     Core::encodeProgram
+ * @description: This function turns the decoded commands back to names, it's the inverse
+ *               of Core::decodeProgram for the programs built by the searches
+ * @code:        Decoded commands, such as Core::Program::code_
+ */
+Core::CommandList Core::encodeProgram(const std::vector<Core::Instruction>& code) {
+    Core::CommandList cmd;
+    cmd.reserve(code.size());
+    for (const Core::Instruction& ins : code) {
+        cmd.push_back({ Core::Command::kAllCmd[ins.op_], ins.operand_ });
+    }
+    return cmd;
+}
+
+namespace {
+
+/**
+ * VectorFeed is the input of level.provided_seq_, m.input_pos_ is its position. The boxes
+ * fit Value, see Core::inputOverflow
+ */
+class VectorFeed {
+  public:
+    const std::vector<std::int64_t>& seq_;
+
+    template <class Value>
+    bool take(Core::BasicMachine<Value>& m) {
+        if (m.input_pos_ == seq_.size()) return false;
+        m.handbox_ = static_cast<Value>(seq_[m.input_pos_++]);
+        return true;
+    }
+};
+
+/**
+ * ConveyorFeed is the streamed input, m.input_pos_ only counts the boxes taken
+ */
+class ConveyorFeed {
+  public:
+    Core::InputConveyor& conveyor_;
+
+    bool take(Core::Machine& m) {
+        if (!conveyor_.next(m.handbox_)) return false;
+        m.input_pos_++;
+        return true;
+    }
+};
+
+/**
+ * VectorSink keeps the output in m.output_, it's compared with level.needed_seq_ at the end
+ */
+class VectorSink {
+  public:
+    static constexpr bool kChecked = false;
+
+    template <class Value>
+    void drain(Core::BasicMachine<Value>&) {}
+
+    template <class Value>
+    Core::Verdict verdict(const Core::BasicMachine<Value>& m, const Core::Level& level) {
+        return std::equal(
+            m.output_.begin(), m.output_.end(),
+            level.needed_seq_.begin(), level.needed_seq_.end()
+        ) ? Core::Verdict::kSuccess : Core::Verdict::kFail;
+    }
+};
+
+/**
+ * CheckSink compares the output with the expected output whenever kDrainSize boxes are
+ * put, and drops them, so m.output_ only holds the boxes put since the last check
+ */
+class CheckSink {
+  public:
+    static constexpr bool kChecked = true;
+    static constexpr std::size_t kDrainSize = 1 << 12;
+
+    Core::ExpectedOutput& expected_;
+
+    void drain(Core::Machine& m) {
+        expected_.check(m.output_.data(), m.output_.size());
+        m.output_.clear();
+    }
+
+    Core::Verdict verdict(Core::Machine& m, const Core::Level&) {
+        drain(m);
+        return expected_.matched() ? Core::Verdict::kSuccess : Core::Verdict::kFail;
+    }
+};
+
+}
+
+/**
+ * @program:     Core::inputOverflow
+ * @description: This function finds the first input box after from which doesn't fit Value
+ * @return:      The kValueOverflow of the box, the operand is its position in the input
+ */
+template <class Value>
+std::optional<Core::Diagnostic> Core::inputOverflow(const Core::Level& level, std::size_t from) {
+    if constexpr (sizeof(Value) < sizeof(std::int64_t)) {
+        for (std::size_t i = from; i < level.provided_seq_.size(); ++i) {
+            const std::int64_t box = level.provided_seq_[i];
+            if (box < std::numeric_limits<Value>::min() || box > std::numeric_limits<Value>::max()) {
+                return Core::Diagnostic{ Core::DiagnosticCode::kValueOverflow, 0, static_cast<int>(i) };
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+template std::optional<Core::Diagnostic> Core::inputOverflow<std::int16_t>(const Core::Level&, std::size_t);
+template std::optional<Core::Diagnostic> Core::inputOverflow<int>(const Core::Level&, std::size_t);
+
+/**
+ * @program:     decodedLoop
+ * @description: This function is the loop of Core::runDecoded, kProfiled builds the loop
+ *               with the counting, kAccelerated with the loop skipping and kTraced with
+ *               the hot traces, so the loop without them doesn't even test the pointers.
+ *               Feed gives the boxes to `inbox` and Sink takes the output, the traces need
+ *               VectorFeed and VectorSink. Value is the type of boxes, the arithmetic of any
+ *               type but `int` is checked, and the accelerator and the traces need `int`.
+ *               kSparse reads the vacant from m.sparse_, the accelerator and the traces
+ *               need the dense one
+ */
+template <bool kProfiled, bool kAccelerated, bool kTraced, bool kSparse = false, class Feed, class Sink, class Value>
+static std::expected<Core::Verdict, Core::Diagnostic> decodedLoop(
+    const Core::Program& p,
+    const Core::Level& level,
+    Feed input,
+    Sink output,
+    Core::BasicMachine<Value>& m,
+    unsigned long long step_limit,
+    Core::Profile* profile,
+    Core::LoopAccelerator* accel,
+    Core::TraceCache* traces
+) {
+    const auto& code = p.code_;
+    const unsigned int size = code.size();
+    const int vac_size = kSparse ? m.sparse_.tiles() : m.vacant_.size();
+
+    auto fail = [&m](Core::DiagnosticCode c, int operand) {
+        return std::unexpected(Core::Diagnostic{ c, m.ref_, operand });
+    };
+
+    while (true) {
+        if (step_limit != 0 && m.steps_ >= step_limit) {
+            return fail(Core::DiagnosticCode::kStepLimitExceeded, 0);
+        }
+        if (m.ref_ == size + 1) break;
+
+        // All the commands have been executed
+
+        const unsigned int line = m.ref_ - 1;
+        const Core::Instruction& ins = code[line];
+        const int x = ins.operand_;
+
+        switch (ins.op_) {
+        case Core::Opcode::kInbox :
+            if (x != Core::Command::SingleCommand::kNullVacant) {
+                return fail(Core::DiagnosticCode::kOpindexSurplus, x);
+            }
+            if (!input.take(m)) goto finish;
+
+            // The input is empty, the game ends normally
+
+            m.handbox_empty_ = false;
+            m.ref_++;
+            break;
+        case Core::Opcode::kOutbox :
+            if (x != Core::Command::SingleCommand::kNullVacant) {
+                return fail(Core::DiagnosticCode::kOpindexSurplus, x);
+            }
+            if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, x);
+            m.output_.push_back(m.handbox_);
+            m.handbox_ = Core::Robot::kEmptyHandbox;
+            m.handbox_empty_ = true;
+            m.ref_++;
+            if constexpr (Sink::kChecked) {
+                if (m.output_.size() >= CheckSink::kDrainSize) output.drain(m);
+            }
+            break;
+        case Core::Opcode::kAdd :
+        case Core::Opcode::kSub :
+            if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, x);
+            if (x < 0) return fail(Core::DiagnosticCode::kOpindexUnderflow, x);
+            if (x >= vac_size) return fail(Core::DiagnosticCode::kOpindexOverflow, x);
+            Value operand;
+            if constexpr (kSparse) {
+                const Value* tile = m.sparse_.find(x);
+                if (tile == nullptr) return fail(Core::DiagnosticCode::kVacantEmpty, x);
+                operand = *tile;
+            } else {
+                if (m.vacant_empty_[x]) return fail(Core::DiagnosticCode::kVacantEmpty, x);
+                operand = m.vacant_[x];
+            }
+            if constexpr (std::is_same_v<Value, int>) {
+                m.handbox_ = (ins.op_ == Core::Opcode::kAdd)
+                           ? m.handbox_ + operand
+                           : m.handbox_ - operand;
+            } else {
+                Value result;
+                const bool overflow = (ins.op_ == Core::Opcode::kAdd)
+                                    ? __builtin_add_overflow(m.handbox_, operand, &result)
+                                    : __builtin_sub_overflow(m.handbox_, operand, &result);
+                if (overflow) return fail(Core::DiagnosticCode::kValueOverflow, x);
+                m.handbox_ = result;
+            }
+            m.ref_++;
+            break;
+        case Core::Opcode::kCopyto :
+            if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, x);
+            if (x < 0) return fail(Core::DiagnosticCode::kOpindexUnderflow, x);
+            if (x >= vac_size) return fail(Core::DiagnosticCode::kOpindexOverflow, x);
+            if constexpr (kSparse) {
+                m.sparse_.put(x, m.handbox_);
+            } else {
+                m.vacant_[x] = m.handbox_;
+                m.vacant_empty_[x] = false;
+            }
+            m.ref_++;
+            break;
+        case Core::Opcode::kCopyfrom :
+            if (x < 0) return fail(Core::DiagnosticCode::kOpindexUnderflow, x);
+            if (x >= vac_size) return fail(Core::DiagnosticCode::kOpindexOverflow, x);
+            if constexpr (kSparse) {
+                const Value* tile = m.sparse_.find(x);
+                if (tile == nullptr) return fail(Core::DiagnosticCode::kVacantEmpty, x);
+                m.handbox_ = *tile;
+            } else {
+                if (m.vacant_empty_[x]) return fail(Core::DiagnosticCode::kVacantEmpty, x);
+                m.handbox_ = m.vacant_[x];
+            }
+            m.handbox_empty_ = false;
+            m.ref_++;
+            break;
+        case Core::Opcode::kJump :
+            if (x <= 0) return fail(Core::DiagnosticCode::kCmindexUnderflow, x);
+            if (static_cast<unsigned int>(x) > size) {
+                return fail(Core::DiagnosticCode::kCmindexOverflow, x);
+            }
+            m.ref_ = x;
+            break;
+        case Core::Opcode::kJumpifzero :
+            if (m.handbox_ == 0) {
+                if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, x);
+                if (x <= 0) return fail(Core::DiagnosticCode::kCmindexUnderflow, x);
+                if (static_cast<unsigned int>(x) > size) {
+                    return fail(Core::DiagnosticCode::kCmindexOverflow, x);
+                }
+                m.ref_ = x;
+                if constexpr (kProfiled) profile->taken_[line]++;
+            } else {
+                m.ref_++;
+                if constexpr (kProfiled) profile->not_taken_[line]++;
+            }
+            break;
+        }
+        m.steps_++;
+        if constexpr (kProfiled) {
+            profile->count_[line]++;
+            profile->steps_++;
+        }
+        if constexpr (kAccelerated) {
+            if (ins.op_ == Core::Opcode::kJump && accel->loopAt(line) >= 0) {
+                if constexpr (Sink::kChecked) {
+                    accel->accelerate(p, accel->loopAt(line), m, step_limit, kProfiled ? profile : nullptr, CheckSink::kDrainSize);
+                    output.drain(m);
+                } else {
+                    accel->accelerate(p, accel->loopAt(line), m, step_limit, kProfiled ? profile : nullptr);
+                }
+            }
+        }
+        if constexpr (kTraced) {
+            if (traces->recording() || ins.op_ >= Core::Opcode::kJump) {
+                traces->onStep(p, line, m, input.seq_, step_limit, kProfiled ? profile : nullptr);
+            }
+        }
+    }
+
+finish:
+    return output.verdict(m, level);
+}
+
+/**
+ * @program:     sparseLoop
+ * @description: This function is decodedLoop on a machine with the sparse vacant, without
+ *               the accelerator and the traces
+ */
+template <class Feed, class Sink, class Value>
+static std::expected<Core::Verdict, Core::Diagnostic> sparseLoop(
+    const Core::Program& p,
+    const Core::Level& level,
+    Feed input,
+    Sink output,
+    Core::BasicMachine<Value>& m,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    return profile == nullptr
+         ? decodedLoop<false, false, false, true>(p, level, input, output, m, step_limit, nullptr, nullptr, nullptr)
+         : decodedLoop<true, false, false, true>(p, level, input, output, m, step_limit, profile, nullptr, nullptr);
+}
+
+/**
+ * @program:     Core::runDecoded
+ * @description: This function runs the decoded program on the machine until the game ends.
+ *               The semantics (including the order of checks and the state left behind by
+ *               an error) are exactly the same as Core::Command::runRefCommand
+ * @p:           The decoded program
+ * @level:       The level, the input is read from level.provided_seq_
+ * @m:           The machine, it should be reset before the first call
+ * @step_limit:  The game stops with kStepLimitExceeded after so many steps, 0 means no limit
+ * @profile:     The counts of every command are added to it when it's not nullptr, it
+ *               should be reset to the size of program
+ * @accel:       The counting loops of program are skipped in closed form when it's not
+ *               nullptr, see `accel.h`
+ * @traces:      The hot loops of program are run by their compiled traces when it's not
+ *               nullptr, see `hot_trace.h`. It's used instead of accel when both are given.
+ *               Neither is used when the vacant of m is sparse
+ */
+std::expected<Core::Verdict, Core::Diagnostic> Core::runDecoded(
+    const Core::Program& p,
+    const Core::Level& level,
+    Core::Machine& m,
+    unsigned long long step_limit,
+    Core::Profile* profile,
+    Core::LoopAccelerator* accel,
+    Core::TraceCache* traces
+) {
+    if (auto overflow = Core::inputOverflow<int>(level, m.input_pos_)) return std::unexpected(*overflow);
+    const VectorFeed input{ level.provided_seq_ };
+    const VectorSink output;
+    if (m.sparse()) return sparseLoop(p, level, input, output, m, step_limit, profile);
+    if (traces != nullptr) {
+        traces->startRun();
+        return profile == nullptr
+             ? decodedLoop<false, false, true>(p, level, input, output, m, step_limit, nullptr, nullptr, traces)
+             : decodedLoop<true, false, true>(p, level, input, output, m, step_limit, profile, nullptr, traces);
+    }
+    if (accel != nullptr && accel->size() != 0) {
+        return profile == nullptr
+             ? decodedLoop<false, true, false>(p, level, input, output, m, step_limit, nullptr, accel, nullptr)
+             : decodedLoop<true, true, false>(p, level, input, output, m, step_limit, profile, accel, nullptr);
+    }
+    return profile == nullptr
+         ? decodedLoop<false, false, false>(p, level, input, output, m, step_limit, nullptr, nullptr, nullptr)
+         : decodedLoop<true, false, false>(p, level, input, output, m, step_limit, profile, nullptr, nullptr);
+}
+
+/**
+ * @program:     Core::runTyped
+ * @description: This function is Core::runDecoded on boxes of type Value, see
+ *               Core::ValueKind. An input box which doesn't fit Value stops the game before
+ *               the first command, as it does in Core::runDecoded for `int`
+ */
+template <class Value>
+std::expected<Core::Verdict, Core::Diagnostic> Core::runTyped(
+    const Core::Program& p,
+    const Core::Level& level,
+    Core::BasicMachine<Value>& m,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    if (auto overflow = Core::inputOverflow<Value>(level, m.input_pos_)) return std::unexpected(*overflow);
+    const VectorFeed input{ level.provided_seq_ };
+    const VectorSink output;
+    if (m.sparse()) return sparseLoop(p, level, input, output, m, step_limit, profile);
+    return profile == nullptr
+         ? decodedLoop<false, false, false>(p, level, input, output, m, step_limit, nullptr, nullptr, nullptr)
+         : decodedLoop<true, false, false>(p, level, input, output, m, step_limit, profile, nullptr, nullptr);
+}
+
+template std::expected<Core::Verdict, Core::Diagnostic> Core::runTyped(
+    const Core::Program&, const Core::Level&, Core::BasicMachine<std::int16_t>&, unsigned long long, Core::Profile*
+);
+template std::expected<Core::Verdict, Core::Diagnostic> Core::runTyped(
+    const Core::Program&, const Core::Level&, Core::BasicMachine<std::int64_t>&, unsigned long long, Core::Profile*
+);
+
+/**
+ * @program:     Core::runStreamed
+ * @description: This function is Core::runDecoded with the input taken from the conveyor
+ *               instead of level.provided_seq_, m.input_pos_ counts the boxes taken. The
+ *               traces read the input ahead, so they are not supported
+ * @input:       The input, it goes on from where the last run stopped
+ * @expected:    The output is compared with it and dropped when it's not nullptr, instead
+ *               of compared with level.needed_seq_. m.output_ only holds the boxes put
+ *               after the last comparison then, which are not compared when the run fails
+ *               with an error
+ */
+std::expected<Core::Verdict, Core::Diagnostic> Core::runStreamed(
+    const Core::Program& p,
+    const Core::Level& level,
+    Core::InputConveyor& input,
+    Core::ExpectedOutput* expected,
+    Core::Machine& m,
+    unsigned long long step_limit,
+    Core::Profile* profile,
+    Core::LoopAccelerator* accel
+) {
+    const ConveyorFeed feed{ input };
+    auto run = [&](auto output) -> std::expected<Core::Verdict, Core::Diagnostic> {
+        if (m.sparse()) return sparseLoop(p, level, feed, output, m, step_limit, profile);
+        if (accel != nullptr && accel->size() != 0) {
+            return profile == nullptr
+                 ? decodedLoop<false, true, false>(p, level, feed, output, m, step_limit, nullptr, accel, nullptr)
+                 : decodedLoop<true, true, false>(p, level, feed, output, m, step_limit, profile, accel, nullptr);
+        }
+        return profile == nullptr
+             ? decodedLoop<false, false, false>(p, level, feed, output, m, step_limit, nullptr, nullptr, nullptr)
+             : decodedLoop<true, false, false>(p, level, feed, output, m, step_limit, profile, nullptr, nullptr);
+    };
+    return expected == nullptr ? run(VectorSink{}) : run(CheckSink{ *expected });
+}
+
+/**
+ * @program:     runFlattened
+ * @description: This function runs the level on the machine m of its value type and
+ *               flattens the state to flat, the values are narrowed to `int` there, the
+ *               verdict isn't
+ * @narrowed:    Set when a box doesn't fit `int`, it's saturated in flat
+ */
+template <class Value>
+static std::expected<Core::Verdict, Core::Diagnostic> runFlattened(
+    const Core::Program& p,
+    const Core::Level& level,
+    Core::BasicMachine<Value>& m,
+    Core::Machine& flat,
+    bool& narrowed,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    m.reset(level.vac_size_);
+    auto verdict = Core::runTyped(p, level, m, step_limit, profile);
+
+    auto narrow = [&narrowed](Value box) -> int {
+        if constexpr (sizeof(Value) > sizeof(int)) {
+            if (box < std::numeric_limits<int>::min() || box > std::numeric_limits<int>::max()) {
+                narrowed = true;
+                return box < 0 ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+            }
+        }
+        return static_cast<int>(box);
+    };
+    flat.ref_ = m.ref_;
+    flat.handbox_ = narrow(m.handbox_);
+    flat.handbox_empty_ = m.handbox_empty_;
+    flat.vacant_.resize(m.vacant_.size());
+    std::transform(m.vacant_.begin(), m.vacant_.end(), flat.vacant_.begin(), narrow);
+    flat.vacant_empty_ = m.vacant_empty_;
+    for (auto [x, box] : m.sparse_.sorted()) flat.sparse_.put(x, narrow(box));
+    flat.input_pos_ = m.input_pos_;
+    flat.output_.resize(m.output_.size());
+    std::transform(m.output_.begin(), m.output_.end(), flat.output_.begin(), narrow);
+    flat.steps_ = m.steps_;
+    return verdict;
+}
+
+/**
+ * @program:     Core::runEngine
+ * @description: This function runs the commands on the level with the given engine and
+ *               returns the flat final state, so every engine can be compared
+ * @kind:        The engine, see Core::kAllEngine
+ * @level:       The level
+ * @cmd:         Commands, they are the pair of command name and vacant index
+ * @step_limit:  The game stops with kStepLimitExceeded after so many steps, 0 means no limit
+ * @compiled:    cmd compiled by Core::ProgramCache for the level, the reference engine
+ *               doesn't use it. The tracing engine keeps its traces in it for the next runs
+ */
+Core::RunResult Core::runEngine(
+    Core::EngineKind kind,
+    const Core::Level& level,
+    const Core::CommandList& cmd,
+    unsigned long long step_limit,
+    const Core::CompiledProgram* compiled
+) {
+    Core::TraceSpan span("runEngine", "judge");
+    auto begin = std::chrono::steady_clock::now();
+    Core::RunResult result;
+    const bool perf = Core::isPerfEnabled();
+    const bool profiling = Core::isProfileEnabled();
+
+    // The counters only wrap the run (Game::runAll or the run loop of engine), loading
+    // and flattening are not counted
+
+    switch (kind) {
+    case Core::EngineKind::kReferenceEngine : {
+        auto available = level.available_cmd_;
+        auto commands = cmd;
+
+        // Core::Game::initialize moves its parameters, so pass the copies. Its boxes are
+        // `int`, so the input must fit, and a needed box which doesn't can't be put
+
+        bool unreachable = false;
+        std::vector<int> provided(level.provided_seq_.begin(), level.provided_seq_.end());
+        std::vector<int> needed;
+        needed.reserve(level.needed_seq_.size());
+        for (std::int64_t box : level.needed_seq_) {
+            if (box < std::numeric_limits<int>::min() || box > std::numeric_limits<int>::max()) unreachable = true;
+            needed.push_back(static_cast<int>(box));
+        }
+
+        Core::Game game;
+        game.setStepLimit(step_limit);
+        game.setProfiling(profiling);
+        auto loaded = game.initialize(available, provided, needed, commands, level.vac_size_);
+        if (!loaded) {
+            result.verdict_ = std::unexpected(loaded.error());
+        } else if (auto overflow = Core::inputOverflow<int>(level, 0)) {
+            result.verdict_ = std::unexpected(*overflow);
+        } else {
+            if (perf) Core::threadPerfCounters().start();
+            result.verdict_ = game.runAll();
+            if (perf) result.perf_ = Core::threadPerfCounters().stop();
+            if (unreachable && result.verdict_ == Core::Verdict::kSuccess) result.verdict_ = Core::Verdict::kFail;
+        }
+        result.state_ = game.snapshot();
+        result.stats_ = game.stats();
+        if (profiling) result.profile_ = game.profile();
+        break;
+    }
+    case Core::EngineKind::kDecodedEngine :
+    case Core::EngineKind::kAcceleratedEngine :
+    case Core::EngineKind::kTracingEngine :
+    case Core::EngineKind::kOptimizedEngine : {
+        std::expected<Core::Program, Core::Diagnostic> p;
+        std::optional<Core::LoopAccelerator> accel;
+        std::optional<Core::TraceCache> traces;
+        std::unique_ptr<Core::TraceCache> kept_traces;
+        std::optional<Core::OptimizedProgram> optimized;
+        const Core::Program* program = nullptr;
+        const Core::OptimizedProgram* opt = nullptr;
+        const bool typed = level.value_kind_ != Core::ValueKind::kValue32;
+        const bool sparse = level.vac_size_ > Core::kDenseVacant;
+        {
+            Core::AllocRecorder recorder(result.stats_, Core::AllocPhase::kPhaseLoad);
+            Core::TraceSpan span("decodeProgram", "load");
+            result.state_.reset(level.vac_size_);
+            if (compiled != nullptr) {
+                program = &compiled->program_;
+            } else {
+                p = Core::decodeProgram(cmd, level.available_cmd_);
+                if (p) program = &*p;
+            }
+            if (profiling && program) result.profile_.reset(cmd.size());
+            if (kind == Core::EngineKind::kAcceleratedEngine && program && !typed && !sparse) accel.emplace(*program, level.vac_size_);
+            if (kind == Core::EngineKind::kTracingEngine && program && !typed && !sparse) {
+                if (compiled != nullptr) {
+                    kept_traces = compiled->takeTraces(level.vac_size_);
+                } else {
+                    traces.emplace(*program, level.vac_size_);
+                }
+            }
+            if (kind == Core::EngineKind::kOptimizedEngine && program && !typed && !sparse) {
+                if (compiled == nullptr) optimized = Core::optimizeProgram(*program);
+                opt = compiled != nullptr ? &compiled->optimized_ : &*optimized;
+            }
+        }
+
+        // A compiled program skips decoding and optimization, they were done when it was
+        // put to the cache, and its traces are kept from the runs before
+
+        if (program == nullptr) {
+            result.verdict_ = std::unexpected(p.error());
+            break;
+        }
+        Core::AllocRecorder recorder(result.stats_, Core::AllocPhase::kPhaseRun);
+        Core::TraceSpan span("runDecoded", "run");
+        if (perf) Core::threadPerfCounters().start();
+
+        // The value type is chosen once here, the accelerator, the traces and the
+        // optimizer only run `int` on the dense vacant, so every engine of a typed or
+        // sparse level is the plain loop
+
+        if (typed) {
+            Core::Profile* profile = profiling ? &result.profile_ : nullptr;
+            Core::BasicMachine<std::int16_t> m16;
+            result.verdict_ = level.value_kind_ == Core::ValueKind::kValue16
+                            ? runFlattened(*program, level, m16, result.state_, result.narrowed_, step_limit, profile)
+                            : runFlattened(*program, level, result.wide_state_, result.state_, result.narrowed_, step_limit, profile);
+        } else if (opt != nullptr) {
+            result.verdict_ = Core::runOptimized(
+                *opt, *program, level, result.state_, step_limit,
+                profiling ? &result.profile_ : nullptr
+            );
+        } else {
+            result.verdict_ = Core::runDecoded(
+                *program, level, result.state_, step_limit, 
+                profiling ? &result.profile_ : nullptr, 
+                accel ? &*accel : nullptr,
+                kept_traces ? kept_traces.get() : traces ? &*traces : nullptr
+            );
+        }
+        if (kept_traces) compiled->keepTraces(std::move(kept_traces));
+        if (perf) result.perf_ = Core::threadPerfCounters().stop();
+        break;
+    }
+    }
+
+    Core::observeMetric(
+        Core::MetricHistogram::kMetricRunLatency,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()
+    );
+    Core::addMetric(Core::MetricCounter::kMetricSubmissions);
+    Core::addMetric(Core::MetricCounter::kMetricSteps, result.state_.steps_);
+    Core::addMetric(
+        !result.verdict_ ? Core::MetricCounter::kMetricVerdictError
+        : *result.verdict_ == Core::Verdict::kSuccess ? Core::MetricCounter::kMetricVerdictSuccess
+        : Core::MetricCounter::kMetricVerdictFail
+    );
+    return result;
+}
@@ -0,0 +1,197 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "core.h"
+#include "perf_counters.h"
+#include "profile.h"
+#include "sparse_vacant.h"
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Core {
+
+using CommandList = std::vector<std::pair<std::string, int>>;
+
+// CommandList is the same as the `cmd` parameter of Core::Game::initialize
+
+/**
+ * Opcode is the decoded command name, the order is the same as Command::kAllCmd
+ */
+enum Opcode {
+    kInbox,
+    kOutbox,
+    kAdd,
+    kSub,
+    kCopyto,
+    kCopyfrom,
+    kJump,
+    kJumpifzero
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+class Instruction {
+  public:
+    Opcode op_;
+    int operand_;   // Vacant index or jump target, Command::SingleCommand::kNullVacant when not given
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+class Program {
+  public:
+    std::vector<Instruction> code_; // code_[i] is the command whose ID is i + 1
+};
+
+/**
+ * ValueKind is the type of the boxes when a level is run by the decoded engine. kValue32
+ * is `int` with the arithmetic of Core::Game, the others check every `add` and `sub` and
+ * stop with kValueOverflow : kValue16 is dense for the values of the original game and
+ * kValue64 is for generated levels whose values grow large
+ */
+enum ValueKind {
+    kValue32,
+    kValue16,
+    kValue64
+};
+
+/**
+ * Level keeps everything that Core::Game::initialize needs except the commands. The boxes
+ * are int64_t, so a kValue64 level can hold any box, the engines of `int` boxes stop with
+ * kValueOverflow on an input box which doesn't fit them (see Core::runTyped)
+ *
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+class Level {
+  public:
+    std::vector<std::string> available_cmd_;
+    std::vector<std::int64_t> provided_seq_;
+    std::vector<std::int64_t> needed_seq_;
+    int vac_size_ = 0;
+    ValueKind value_kind_ = kValue32;   // Only the decoded engines use it, see runTyped
+};
+
+/**
+ * Machine is the flat state of game, all the engines run on it or can be flattened
+ * to it (see Core::Game::snapshot), so the engines can be compared with each other.
+ * BasicMachine<Value> is the state with boxes of another type, see Core::runTyped. The
+ * vacant of a large level is sparse_ instead of vacant_ and vacant_empty_, see reset
+ *
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+template <class Value>
+class BasicMachine {
+  public:
+    unsigned int ref_ = 1;                      // Command ID which is executed next, counts from 1
+    Value handbox_ = 0;
+    bool handbox_empty_ = true;
+    std::vector<Value> vacant_;
+    std::vector<unsigned char> vacant_empty_;   // Not std::vector<bool>, engines read it every step
+    SparseVacant<Value> sparse_;                // Only for more than kDenseVacant tiles
+    std::size_t input_pos_ = 0;                 // Count of boxes taken from the input
+    std::vector<Value> output_;
+    unsigned long long steps_ = 0;
+
+    void reset(int vac_size);
+    bool sparse() const { return sparse_.tiles() != 0; }
+    bool operator==(const BasicMachine& m) const = default;
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-20
+ */
+class RunResult {
+  public:
+    Machine state_;
+    std::expected<Verdict, Diagnostic> verdict_;
+    AllocStats stats_;      // Allocations by phase, all 0 without ROBOX_ALLOC_STATS
+    PerfSample perf_;       // Counters of the run, only when Core::setPerfEnabled(true)
+    Profile profile_;       // Executions of every command, only when Core::setProfileEnabled(true)
+    bool narrowed_ = false; // A box of the typed machine didn't fit int, it's saturated in state_
+    BasicMachine<std::int64_t> wide_state_;     // The state of a kValue64 run, before state_ is narrowed
+};
+
+enum EngineKind {
+    kReferenceEngine,   // Core::Game, Command::runRefCommand
+    kDecodedEngine,     // Core::runDecoded
+    kAcceleratedEngine, // Core::runDecoded with Core::LoopAccelerator
+    kTracingEngine,     // Core::runDecoded with Core::TraceCache
+    kOptimizedEngine    // Core::runOptimized
+};
+
+constexpr static std::array<EngineKind, 5> kAllEngine = {
+    kReferenceEngine, kDecodedEngine, kAcceleratedEngine, kTracingEngine, kOptimizedEngine
+};
+
+class CompiledProgram;
+class ExpectedOutput;
+class InputConveyor;
+class LoopAccelerator;
+class TraceCache;
+
+std::string engineName(EngineKind kind);
+
+std::expected<Program, Diagnostic> decodeProgram(
+    const CommandList& cmd,
+    const std::vector<std::string>& available
+);
+
+CommandList encodeProgram(const std::vector<Instruction>& code);
+
+std::expected<Verdict, Diagnostic> runDecoded(
+    const Program& p,
+    const Level& level,
+    Machine& m,
+    unsigned long long step_limit,
+    Profile* profile = nullptr,
+    LoopAccelerator* accel = nullptr,
+    TraceCache* traces = nullptr
+);
+
+template <class Value>
+std::optional<Diagnostic> inputOverflow(const Level& level, std::size_t from);
+
+template <class Value>
+std::expected<Verdict, Diagnostic> runTyped(
+    const Program& p,
+    const Level& level,
+    BasicMachine<Value>& m,
+    unsigned long long step_limit,
+    Profile* profile = nullptr
+);
+
+std::expected<Verdict, Diagnostic> runStreamed(
+    const Program& p,
+    const Level& level,
+    InputConveyor& input,
+    ExpectedOutput* expected,
+    Machine& m,
+    unsigned long long step_limit,
+    Profile* profile = nullptr,
+    LoopAccelerator* accel = nullptr
+);
+
+RunResult runEngine(
+    EngineKind kind,
+    const Level& level,
+    const CommandList& cmd,
+    unsigned long long step_limit,
+    const CompiledProgram* compiled = nullptr
+);
+
+}
+
+#endif
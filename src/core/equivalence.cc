@@ -0,0 +1,257 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `equivalence.h`                                      //
+//======================================================//
+
+#include "equivalence.h"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+enum SideStatus {
+    kSideWaiting,   // Stopped at inbox for the next box
+    kSideFinished,  // Executed all the commands
+    kSideFailed
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class Side {
+  public:
+    Core::Machine m_;
+    SideStatus status_ = kSideWaiting;
+};
+
+/**
+ * SearchNode is the two programs stopped on the same input, side_[0] is the submission
+ *
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class SearchNode {
+  public:
+    Side side_[2];
+    int ahead_ = -1;            // The side whose outputs are not matched yet, -1 for none
+    std::vector<int> pending_;  // Its outputs not matched yet
+    std::vector<int> input_;
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class StateHash {
+  public:
+    std::size_t operator()(const std::vector<int>& key) const {
+        std::size_t h = 1469598103934665603ULL;
+        for (int v : key) h = (h ^ static_cast<unsigned int>(v)) * 1099511628211ULL;
+        return h;
+    }
+};
+
+/**
+ * @program:     runSide
+ * @description: This function runs the side on the boxes in scratch until it stops at
+ *               inbox again or the game ends. The steps and outputs are of this run only
+ */
+static void runSide(
+    const Core::Program& p,
+    Side& s,
+    const Core::Level& scratch,
+    unsigned long long step_limit
+) {
+    s.m_.input_pos_ = 0;
+    s.m_.output_.clear();
+    s.m_.steps_ = 0;
+    auto verdict = Core::runDecoded(p, scratch, s.m_, step_limit);
+    if (!verdict) {
+        s.status_ = kSideFailed;
+    } else {
+        s.status_ = s.m_.ref_ == p.code_.size() + 1 ? kSideFinished : kSideWaiting;
+    }
+}
+
+/**
+ * @program:     matchOutput
+ * @description: This function matches the new outputs of side with the outputs of the
+ *               other side which are ahead
+ * @return:      false when an output differs
+ */
+static bool matchOutput(SearchNode& n, int side) {
+    for (int v : n.side_[side].m_.output_) {
+        if (n.ahead_ == -1 || n.ahead_ == side) {
+            n.ahead_ = side;
+            n.pending_.push_back(v);
+        } else {
+            if (n.pending_.front() != v) return false;
+            n.pending_.erase(n.pending_.begin());
+            if (n.pending_.empty()) n.ahead_ = -1;
+        }
+    }
+    return true;
+}
+
+/**
+ * @program:     stateKey
+ * @description: This function flattens the node without the input, the steps and the
+ *               outputs already matched. A side which has stopped for good is only its status
+ */
+static std::vector<int> stateKey(const SearchNode& n) {
+    std::vector<int> key;
+    for (const Side& s : n.side_) {
+        key.push_back(s.status_);
+        if (s.status_ != kSideWaiting) continue;
+        key.push_back(s.m_.ref_);
+        key.push_back(s.m_.handbox_);
+        key.push_back(s.m_.handbox_empty_);
+        key.insert(key.end(), s.m_.vacant_.begin(), s.m_.vacant_.end());
+        key.insert(key.end(), s.m_.vacant_empty_.begin(), s.m_.vacant_empty_.end());
+        for (auto [x, box] : s.m_.sparse_.sorted()) {
+            key.push_back(x);
+            key.push_back(box);
+        }
+    }
+    key.push_back(n.ahead_);
+    key.insert(key.end(), n.pending_.begin(), n.pending_.end());
+    return key;
+}
+
+/**
+ * @program:     Core::checkEquivalence
+ * @description: This function searches all the inputs in the bound for one on which the
+ *               submission and the reference differ, see `equivalence.h`
+ * @level:       The level, only its available commands and vacant size are used
+ * @submission:  Commands of the submission
+ * @reference:   Commands of the reference solution
+ * @bound:       The bound of inputs
+ * @return:      The result, or the diagnostic when either program can't be loaded
+ */
+std::expected<Core::EquivalenceResult, Core::Diagnostic> Core::checkEquivalence(
+    const Core::Level& level,
+    const Core::CommandList& submission,
+    const Core::CommandList& reference,
+    const Core::EquivalenceBound& bound
+) {
+    auto sub = Core::decodeProgram(submission, level.available_cmd_);
+    if (!sub) return std::unexpected(sub.error());
+    auto ref = Core::decodeProgram(reference, level.available_cmd_);
+    if (!ref) return std::unexpected(ref.error());
+    const Core::Program* program[2] = { &*sub, &*ref };
+
+    Core::EquivalenceResult result;
+    unsigned int threads = bound.threads_ != 0 ? bound.threads_ : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1U);
+
+    auto differs = [](const SearchNode& n) {
+        const bool ok0 = n.side_[0].status_ != kSideFailed;
+        const bool ok1 = n.side_[1].status_ != kSideFailed;
+        return ok0 != ok1 || n.ahead_ != -1;
+    };
+
+    // The input ending at the node makes both waiting sides finish at their inbox
+
+    Core::Level empty;
+    SearchNode root;
+    for (int side = 0; side < 2; ++side) {
+        root.side_[side].m_.reset(level.vac_size_);
+        runSide(*program[side], root.side_[side], empty, bound.step_limit_);
+        if (!matchOutput(root, side)) return result;
+    }
+    std::unordered_set<std::vector<int>, StateHash> visited;
+    visited.insert(stateKey(root));
+    std::vector<SearchNode> frontier;
+    frontier.push_back(std::move(root));
+
+    for (unsigned int depth = 0; !frontier.empty(); ++depth) {
+        const bool expand = depth < bound.max_length_;
+        std::vector<unsigned char> end_differs(frontier.size(), false);
+        std::vector<std::optional<std::vector<int>>> child_differs(frontier.size());
+        std::vector<std::vector<SearchNode>> children(frontier.size());
+        std::atomic<std::size_t> next_index = 0;
+
+        auto work = [&]() {
+            Core::Level scratch;
+            scratch.provided_seq_.resize(1);
+            for (std::size_t i = next_index++; i < frontier.size(); i = next_index++) {
+                const SearchNode& n = frontier[i];
+                if (differs(n)) {
+                    end_differs[i] = true;
+                    continue;
+                }
+                const bool waiting = n.side_[0].status_ == kSideWaiting || n.side_[1].status_ == kSideWaiting;
+                if (!expand || !waiting) continue;
+
+                for (int v = bound.min_value_; v <= bound.max_value_; ++v) {
+                    SearchNode child = n;
+                    child.input_.push_back(v);
+                    scratch.provided_seq_[0] = v;
+                    bool same = true;
+                    for (int side = 0; side < 2 && same; ++side) {
+                        if (child.side_[side].status_ != kSideWaiting) continue;
+                        runSide(*program[side], child.side_[side], scratch, bound.step_limit_);
+                        same = matchOutput(child, side);
+                    }
+                    if (!same) {
+                        child_differs[i] = std::move(child.input_);
+                        break;
+                    }
+                    children[i].push_back(std::move(child));
+                }
+            }
+        };
+
+        // Every node is expanded by one thread, the children are kept in the order of
+        // their parents, so the result doesn't depend on the threads
+
+        std::vector<std::thread> pool;
+        for (unsigned int t = 1; t < std::min<std::size_t>(threads, frontier.size()); ++t) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto& t : pool) t.join();
+
+        for (std::size_t i = 0; i < frontier.size(); ++i) {
+            if (end_differs[i]) {
+                result.counterexample_ = frontier[i].input_;
+                result.states_ = visited.size();
+                return result;
+            }
+        }
+        for (std::size_t i = 0; i < frontier.size(); ++i) {
+            if (child_differs[i]) {
+                result.counterexample_ = std::move(*child_differs[i]);
+                result.states_ = visited.size();
+                return result;
+            }
+        }
+
+        std::vector<SearchNode> next;
+        for (auto& list : children) {
+            for (auto& child : list) {
+                if (visited.insert(stateKey(child)).second) next.push_back(std::move(child));
+            }
+        }
+        if (visited.size() > bound.max_states_) {
+            result.complete_ = false;
+            result.states_ = visited.size();
+            return result;
+        }
+        frontier = std::move(next);
+    }
+
+    // A state met again is reached by a shorter or earlier input, which has the same future
+
+    result.equivalent_ = true;
+    result.states_ = visited.size();
+    return result;
+}
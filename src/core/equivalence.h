@@ -0,0 +1,57 @@
+#ifndef EQUIVALENCE_H
+#define EQUIVALENCE_H
+
+#include "engine.h"
+
+#include <cstddef>
+#include <expected>
+#include <vector>
+
+namespace Core {
+
+// Bounded equivalence checking of two programs on one level. Both programs run side by side
+// on the same input, and they stop together whenever one of them takes a box. From there
+// the input either ends or goes on with every value in the bound, so every input up to
+// the bound is covered. Two programs are equivalent when, for every input, their outputs are
+// the same and either both fail or neither does.
+//
+// The search is breadth first, so the counterexample found is one of the shortest. The
+// states are hashed without the steps and the position of input, and a state met again is
+// not searched again. The runs of every depth are spread over the threads.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class EquivalenceBound {
+  public:
+    unsigned int max_length_ = 4;           // Inputs of at most so many boxes
+    int min_value_ = -9;                    // Every box is in [min_value_, max_value_]
+    int max_value_ = 9;
+    unsigned long long step_limit_ = 10000; // Steps between two boxes, more is an error
+    std::size_t max_states_ = 1 << 20;      // The search gives up after so many states
+    unsigned int threads_ = 0;              // 0 means one per core
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class EquivalenceResult {
+  public:
+    bool equivalent_ = false;               // Proven in the bound
+    bool complete_ = true;                  // false when max_states_ stops the search
+    std::vector<int> counterexample_;       // The input on which they differ, when found
+    std::size_t states_ = 0;                // Distinct states searched
+};
+
+std::expected<EquivalenceResult, Diagnostic> checkEquivalence(
+    const Level& level,
+    const CommandList& submission,
+    const CommandList& reference,
+    const EquivalenceBound& bound
+);
+
+}
+
+#endif
@@ -0,0 +1,226 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `expected_output.h`                                  //
+//======================================================//
+
+#include "expected_output.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kBinaryMagic[8] = { 'R', 'B', 'X', 'O', 'U', 'T', '0', '1' };
+constexpr char kWideMagic[8] = { 'R', 'B', 'X', 'O', 'U', 'T', '6', '4' };
+constexpr std::size_t kDropBytes = 1 << 20;
+
+}
+
+Core::ExpectedOutput::~ExpectedOutput() {
+    release();
+}
+
+Core::ExpectedOutput::ExpectedOutput(Core::ExpectedOutput&& e) noexcept {
+    *this = std::move(e);
+}
+
+Core::ExpectedOutput& Core::ExpectedOutput::operator=(Core::ExpectedOutput&& e) noexcept {
+    if (this == &e) return *this;
+    release();
+    base_ = e.base_;
+    size_ = e.size_;
+    mapped_ = e.mapped_;
+    binary_ = e.binary_;
+    pos_ = e.pos_;
+    dropped_ = e.dropped_;
+    checked_ = e.checked_;
+    mismatch_ = e.mismatch_;
+    error_ = std::move(e.error_);
+    e.base_ = nullptr;
+    e.size_ = 0;
+    e.mapped_ = false;
+    return *this;
+}
+
+void Core::ExpectedOutput::release() {
+    if (base_ == nullptr) return;
+#ifdef __linux__
+    if (mapped_) {
+        munmap(const_cast<char*>(base_), size_);
+        base_ = nullptr;
+        return;
+    }
+#endif
+    delete[] base_;
+    base_ = nullptr;
+}
+
+/**
+ * @program:     Core::ExpectedOutput::open
+ * @description: This function maps the file, or reads it where mmap isn't available. The
+ *               pages are read ahead, as the boxes are compared in order
+ * @return:      The expected output, or the reason when the file can't be read
+ */
+std::expected<Core::ExpectedOutput, std::string> Core::ExpectedOutput::open(
+    const std::filesystem::path& path
+) {
+    Core::ExpectedOutput e;
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return std::unexpected("Fail to open " + path.string());
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return std::unexpected("Fail to read " + path.string());
+    }
+    if (st.st_size != 0) {
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return std::unexpected("Fail to map " + path.string());
+        }
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        e.base_ = static_cast<const char*>(map);
+        e.size_ = st.st_size;
+        e.mapped_ = true;
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return std::unexpected("Fail to open " + path.string());
+    e.size_ = file.tellg();
+    auto buffer = std::make_unique<char[]>(e.size_);
+    file.seekg(0);
+    if (!file.read(buffer.get(), e.size_)) return std::unexpected("Fail to read " + path.string());
+    e.base_ = buffer.release();
+#endif
+
+    if (e.size_ >= sizeof(kBinaryMagic) && std::memcmp(e.base_, kBinaryMagic, sizeof(kBinaryMagic)) == 0) {
+        e.binary_ = sizeof(std::int32_t);
+    } else if (e.size_ >= sizeof(kWideMagic) && std::memcmp(e.base_, kWideMagic, sizeof(kWideMagic)) == 0) {
+        e.binary_ = sizeof(std::int64_t);
+    }
+    if (e.binary_ != 0) {
+        if ((e.size_ - sizeof(kBinaryMagic)) % e.binary_ != 0) {
+            return std::unexpected("Truncated expected output " + path.string());
+        }
+        e.pos_ = sizeof(kBinaryMagic);
+    }
+    return e;
+}
+
+/**
+ * @program:     Core::ExpectedOutput::fromSequence
+ * @description: This function keeps a copy of the sequence in the 64-bit binary format
+ */
+Core::ExpectedOutput Core::ExpectedOutput::fromSequence(const std::vector<std::int64_t>& seq) {
+    Core::ExpectedOutput e;
+    e.size_ = sizeof(kWideMagic) + seq.size() * sizeof(std::int64_t);
+    char* buffer = new char[e.size_];
+    std::memcpy(buffer, kWideMagic, sizeof(kWideMagic));
+    if (!seq.empty()) std::memcpy(buffer + sizeof(kWideMagic), seq.data(), seq.size() * sizeof(std::int64_t));
+    e.base_ = buffer;
+    e.binary_ = sizeof(std::int64_t);
+    e.pos_ = sizeof(kWideMagic);
+    return e;
+}
+
+/**
+ * @program:     Core::ExpectedOutput::next
+ * @description: This function reads the next needed box
+ * @return:      FALSE at the end of file, or when the box is illegal
+ */
+bool Core::ExpectedOutput::next(std::int64_t& box) {
+    if (binary_ == sizeof(std::int32_t)) {
+        if (pos_ == size_) return false;
+        std::int32_t value;
+        std::memcpy(&value, base_ + pos_, sizeof(value));
+        pos_ += sizeof(value);
+        box = value;
+        return true;
+    }
+    if (binary_ == sizeof(std::int64_t)) {
+        if (pos_ == size_) return false;
+        std::memcpy(&box, base_ + pos_, sizeof(box));
+        pos_ += sizeof(box);
+        return true;
+    }
+    while (pos_ < size_ && std::isspace(static_cast<unsigned char>(base_[pos_]))) pos_++;
+    if (pos_ == size_) return false;
+    std::size_t stop = pos_;
+    while (stop < size_ && !std::isspace(static_cast<unsigned char>(base_[stop]))) stop++;
+
+    const char* first = base_ + pos_;
+    if (*first == '+' && stop - pos_ > 1) first++;
+    auto [ptr, ec] = std::from_chars(first, base_ + stop, box);
+    if (ec != std::errc() || ptr != base_ + stop) {
+        error_ = "Illegal box `" + std::string(base_ + pos_, stop - pos_) + "`.";
+        pos_ = size_;
+        return false;
+    }
+    pos_ = stop;
+    return true;
+}
+
+/**
+ * @program:     Core::ExpectedOutput::check
+ * @description: This function compares the next n boxes put with the needed ones, the
+ *               boxes after the first mismatch are only counted
+ */
+void Core::ExpectedOutput::check(const int* boxes, std::size_t n) {
+    for (std::size_t i = 0; i < n && !mismatch_; ++i) {
+        std::int64_t box;
+        if (!next(box) || box != boxes[i]) mismatch_ = checked_ + i;
+    }
+    checked_ += n;
+    if (pos_ - dropped_ >= kDropBytes) dropPages();
+}
+
+/**
+ * @program:     Core::ExpectedOutput::dropPages
+ * @description: This function drops the mapped pages which have been compared, they are
+ *               clean, so the memory of a long run stays flat instead of growing with the
+ *               file in the page cache of process
+ */
+void Core::ExpectedOutput::dropPages() {
+#ifdef __linux__
+    if (!mapped_) return;
+    const std::size_t page = sysconf(_SC_PAGESIZE);
+    const std::size_t end = pos_ / page * page;
+    if (end > dropped_) {
+        madvise(const_cast<char*>(base_) + dropped_, end - dropped_, MADV_DONTNEED);
+        dropped_ = end;
+    }
+#else
+    dropped_ = pos_;
+#endif
+}
+
+/**
+ * @program:     Core::ExpectedOutput::matched
+ * @description: This function tells whether the output is exactly the needed sequence, it's
+ *               called once after the run
+ */
+bool Core::ExpectedOutput::matched() {
+    std::int64_t box;
+    if (!mismatch_ && next(box)) mismatch_ = checked_;
+
+    // The needed sequence goes on after the output
+
+    return !mismatch_ && error_.empty();
+}
@@ -0,0 +1,65 @@
+#ifndef EXPECTED_OUTPUT_H
+#define EXPECTED_OUTPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+// Needed sequence of a level too long to keep in Level::needed_seq_, the counterpart of
+// `input_source.h`. The file is mapped and the boxes put by the engine are compared with
+// it as they come (see Core::runStreamed), then dropped, and so are the pages of the file
+// compared, so neither the needed sequence nor the output is ever in memory as a whole.
+// The file is either text, the boxes separated by whitespace as in `needed` of level
+// files, or binary : the 8 bytes `RBXOUT01` and then every box as a 32-bit integer in the
+// byte order of the machine, or `RBXOUT64` and then every box as a 64-bit integer, for the
+// levels of kValue64.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class ExpectedOutput {
+  public:
+    ExpectedOutput() = default;
+    ~ExpectedOutput();
+    ExpectedOutput(ExpectedOutput&& e) noexcept;
+    ExpectedOutput& operator=(ExpectedOutput&& e) noexcept;
+    ExpectedOutput(const ExpectedOutput&) = delete;
+    ExpectedOutput& operator=(const ExpectedOutput&) = delete;
+
+    static std::expected<ExpectedOutput, std::string> open(const std::filesystem::path& path);
+    static ExpectedOutput fromSequence(const std::vector<std::int64_t>& seq);
+
+    void check(const int* boxes, std::size_t n);
+    bool matched();
+
+    unsigned long long checked() const { return checked_; }     // Boxes put
+    std::optional<unsigned long long> mismatch() const { return mismatch_; }
+    const std::string& error() const { return error_; }
+
+  private:
+    bool next(std::int64_t& box);
+    void dropPages();
+    void release();
+
+    const char* base_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;           // Otherwise base_ is owned by new[]
+    std::size_t binary_ = 0;        // Bytes of a box in a binary file, 0 for text
+    std::size_t pos_ = 0;           // Offset of the next box in the file
+    std::size_t dropped_ = 0;       // The pages before it are dropped from memory
+
+    unsigned long long checked_ = 0;
+    std::optional<unsigned long long> mismatch_;    // Position of the first box which differs
+    std::string error_;             // An illegal box of a text file
+};
+
+}
+
+#endif
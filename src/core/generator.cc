@@ -0,0 +1,232 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `generator.h`                                        //
+//======================================================//
+
+#include "generator.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+constexpr std::uint64_t kGolden = 0x9e3779b97f4a7c15ULL;
+
+std::unexpected<std::string> lineError(int line_number, const std::string& message) {
+    return std::unexpected("Line " + std::to_string(line_number) + " : " + message);
+}
+
+/**
+ * @program:     runReference
+ * @description: This function runs the reference on the machine of the value type of test
+ * @m:           The machine of worker, it's reused by the tests so a sparse vacant is only
+ *               cleared, not allocated, for every test
+ * @return:      The output, or why it isn't a needed sequence
+ */
+template <class Value>
+std::expected<std::vector<std::int64_t>, std::string> runReference(
+    const Core::Program& p,
+    const Core::Level& test,
+    Core::BasicMachine<Value>& m,
+    unsigned long long step_limit
+) {
+    m.reset(test.vac_size_);
+    std::expected<Core::Verdict, Core::Diagnostic> verdict;
+    if constexpr (std::is_same_v<Value, int>) {
+        verdict = Core::runDecoded(p, test, m, step_limit);
+    } else {
+        verdict = Core::runTyped(p, test, m, step_limit);
+    }
+    if (!verdict) return std::unexpected(Core::describeDiagnostic(verdict.error()));
+
+    return std::vector<std::int64_t>(m.output_.begin(), m.output_.end());
+}
+
+}
+
+std::uint64_t Core::SplitMix::next() {
+    state_ += kGolden;
+    return Core::ContentHash::mix(state_);
+}
+
+/**
+ * @program:     Core::SplitMix::uniform
+ * @description: This function returns a value in [low, high], by the multiply and shift
+ *               of Lemire, the bias is at most range / 2^64. A range of every int64_t is
+ *               2^64, which wraps to 0, and then every word is a value
+ */
+std::int64_t Core::SplitMix::uniform(std::int64_t low, std::int64_t high) {
+    const std::uint64_t range = static_cast<std::uint64_t>(high) - static_cast<std::uint64_t>(low) + 1;
+    const std::uint64_t offset = range == 0 ? next() : static_cast<std::uint64_t>(static_cast<unsigned __int128>(next()) * range >> 64);
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(low) + offset);
+}
+
+Core::SplitMix Core::SplitMix::split(std::uint64_t i) const {
+    return Core::SplitMix(Core::ContentHash::mix(state_ ^ Core::ContentHash::mix(i + kGolden)));
+}
+
+/**
+ * @program:     Core::parseGeneratorSpec
+ * @description: This function reads a spec file, see the format in `generator.h`
+ * @return:      The spec, or the message with the line number when the file is illegal
+ */
+std::expected<Core::GeneratorSpec, std::string> Core::parseGeneratorSpec(std::istream& in) {
+    Core::GeneratorSpec spec;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(in, line)) {
+        line_number++;
+        std::stringstream ss(line.substr(0, line.find('#')));
+        std::string key;
+        if (!(ss >> key)) continue;
+
+        if (key == "structure") {
+            std::string name;
+            ss >> name;
+            if (name == "plain") spec.structure_ = Core::InputStructure::kPlainInput;
+            else if (name == "pairs") spec.structure_ = Core::InputStructure::kPairInput;
+            else if (name == "strings") spec.structure_ = Core::InputStructure::kStringInput;
+            else return lineError(line_number, "unknown structure `" + name + "`.");
+        } else if (key == "value") {
+            if (!(ss >> spec.min_value_ >> spec.max_value_) || spec.min_value_ > spec.max_value_) {
+                return lineError(line_number, "illegal value range.");
+            }
+        } else if (key == "length" || key == "string") {
+            unsigned int& low = key == "length" ? spec.min_length_ : spec.min_string_;
+            unsigned int& high = key == "length" ? spec.max_length_ : spec.max_string_;
+            long long a, b;
+            if (!(ss >> a >> b) || a < 0 || a > b || b > 1 << 30) {
+                return lineError(line_number, "illegal " + key + " range.");
+            }
+            low = a;
+            high = b;
+        } else {
+            return lineError(line_number, "unknown key `" + key + "`.");
+        }
+    }
+    if (spec.structure_ == Core::InputStructure::kStringInput
+        && spec.max_string_ > 0 && spec.min_value_ == 0 && spec.max_value_ == 0) {
+        return std::unexpected("A box of a string can't be 0.");
+    }
+    return spec;
+}
+
+/**
+ * @program:     Core::generateInput
+ * @description: This function generates an input of the spec from the stream
+ */
+std::vector<std::int64_t> Core::generateInput(const Core::GeneratorSpec& spec, Core::SplitMix& rng) {
+    const unsigned int length = rng.uniform(spec.min_length_, spec.max_length_);
+    std::vector<std::int64_t> input;
+    switch (spec.structure_) {
+    case Core::InputStructure::kPlainInput :
+    case Core::InputStructure::kPairInput : {
+        const std::size_t boxes = spec.structure_ == Core::InputStructure::kPairInput ? 2ULL * length : length;
+        input.reserve(boxes);
+        for (std::size_t i = 0; i < boxes; ++i) input.push_back(rng.uniform(spec.min_value_, spec.max_value_));
+        break;
+    }
+    case Core::InputStructure::kStringInput :
+        for (unsigned int s = 0; s < length; ++s) {
+            const unsigned int size = rng.uniform(spec.min_string_, spec.max_string_);
+            for (unsigned int i = 0; i < size; ++i) {
+
+                // 0 ends the string, so it's drawn again, the spec has a nonzero value
+
+                std::int64_t value;
+                do {
+                    value = rng.uniform(spec.min_value_, spec.max_value_);
+                } while (value == 0);
+                input.push_back(value);
+            }
+            input.push_back(0);
+        }
+        break;
+    }
+    return input;
+}
+
+/**
+ * @program:     Core::generateTests
+ * @description: This function generates the tests of the level in parallel, the needed
+ *               sequence of every test is the output of the reference on its input
+ * @level:       The level, its input and needed sequence are replaced
+ * @reference:   A solution of the level, it must not fail with an error on any input
+ * @return:      The tests in order, or the error of the reference on the first test which
+ *               it can't run
+ */
+std::expected<std::vector<Core::Level>, std::string> Core::generateTests(
+    const Core::Level& level,
+    const Core::CommandList& reference,
+    const Core::GeneratorSpec& spec,
+    const Core::GeneratorOptions& options
+) {
+    auto program = Core::decodeProgram(reference, level.available_cmd_);
+    if (!program) return std::unexpected("The reference can't be loaded : " + Core::describeDiagnostic(program.error()));
+    if (level.value_kind_ != Core::ValueKind::kValue64
+        && (spec.min_value_ < std::numeric_limits<int>::min() || spec.max_value_ > std::numeric_limits<int>::max())) {
+        return std::unexpected("The value range of the spec doesn't fit int, the level needs `value int64`.");
+    }
+
+    std::vector<Core::Level> tests(options.count_);
+    const Core::SplitMix root(options.seed_);
+    std::atomic<std::size_t> next_index = 0;
+    std::atomic<std::size_t> first_error = options.count_;
+    std::mutex error_lock;
+    std::string error;
+
+    auto work = [&]() {
+        Core::BasicMachine<std::int16_t> m16;
+        Core::Machine m32;
+        Core::BasicMachine<std::int64_t> m64;
+        for (std::size_t i = next_index++; i < first_error; i = next_index++) {
+            Core::SplitMix rng = root.split(i);
+            Core::Level& test = tests[i];
+            test.available_cmd_ = level.available_cmd_;
+            test.vac_size_ = level.vac_size_;
+            test.value_kind_ = level.value_kind_;
+            test.provided_seq_ = Core::generateInput(spec, rng);
+
+            auto output = level.value_kind_ == Core::ValueKind::kValue16
+                        ? runReference(*program, test, m16, options.step_limit_)
+                        : level.value_kind_ == Core::ValueKind::kValue64
+                        ? runReference(*program, test, m64, options.step_limit_)
+                        : runReference(*program, test, m32, options.step_limit_);
+            if (output) {
+                test.needed_seq_ = std::move(*output);
+                continue;
+            }
+
+            // The error of the first failed test is kept, so it's the same for every count
+            // of threads, the tests after it are not generated
+
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (i < first_error) {
+                first_error = i;
+                error = "The reference fails on test " + std::to_string(i) + " : " + output.error();
+            }
+        }
+    };
+
+    unsigned int threads = options.threads_ != 0 ? options.threads_ : std::thread::hardware_concurrency();
+    threads = static_cast<unsigned int>(std::min<std::size_t>(std::max(threads, 1U), std::max<std::size_t>(options.count_, 1)));
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    if (first_error < options.count_) return std::unexpected(error);
+    return tests;
+}
@@ -0,0 +1,91 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "engine.h"
+
+#include <cstdint>
+#include <expected>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+// Generator of tests for stress suites. A spec tells the shape of inputs, and every test is
+// the level with a random input of that shape and the output of a reference solution on it
+// as the needed sequence. Spec file, in the format of level files (see `loader.h`) :
+//
+//     structure strings   # plain boxes, pairs of boxes, or strings which end with 0
+//     value -9 9          # Every box is in the range, a box of a string is never 0. The
+//                         # range must fit int unless the level is int64
+//     length 1 8          # Boxes, pairs or strings of an input
+//     string 0 4          # Boxes of a string before its 0, only for strings
+//
+// Test i is generated from its own stream, split from the seed by i, so the tests are the
+// same whatever the count of threads and test i doesn't change when more are generated.
+
+enum InputStructure {
+    kPlainInput,
+    kPairInput,
+    kStringInput
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class GeneratorSpec {
+  public:
+    InputStructure structure_ = kPlainInput;
+    std::int64_t min_value_ = -9;
+    std::int64_t max_value_ = 9;
+    unsigned int min_length_ = 0;
+    unsigned int max_length_ = 8;
+    unsigned int min_string_ = 0;
+    unsigned int max_string_ = 4;
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class GeneratorOptions {
+  public:
+    std::size_t count_ = 100;
+    std::uint64_t seed_ = 0;
+    unsigned long long step_limit_ = 1000000;   // A longer run of the reference is an error
+    unsigned int threads_ = 0;                  // 0 means one per core
+};
+
+/**
+ * SplitMix is the splitmix64 generator, split(i) is an independent stream for every i
+ *
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SplitMix {
+  public:
+    explicit SplitMix(std::uint64_t seed) : state_(seed) {}
+
+    std::uint64_t next();
+    std::int64_t uniform(std::int64_t low, std::int64_t high);
+    SplitMix split(std::uint64_t i) const;
+
+  private:
+    std::uint64_t state_;
+};
+
+std::expected<GeneratorSpec, std::string> parseGeneratorSpec(std::istream& in);
+
+std::vector<std::int64_t> generateInput(const GeneratorSpec& spec, SplitMix& rng);
+
+std::expected<std::vector<Level>, std::string> generateTests(
+    const Level& level,
+    const CommandList& reference,
+    const GeneratorSpec& spec,
+    const GeneratorOptions& options
+);
+
+}
+
+#endif
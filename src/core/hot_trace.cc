@@ -0,0 +1,270 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `hot_trace.h`                                        //
+//======================================================//
+
+#include "hot_trace.h"
+
+/**
+ * @program:     Core::TraceCache::TraceCache
+ * @description: This function prepares the counters, nothing is compiled until it's hot
+ * @p:           The decoded program, it must live as long as the cache
+ * @vac_size:    The size of vacant, the operands are checked against it when compiling
+ */
+Core::TraceCache::TraceCache(const Core::Program& p, int vac_size)
+    : program_( p )
+    , vac_size_( vac_size )
+    , hot_( p.code_.size(), 0 )
+    , threshold_( p.code_.size(), kHotThreshold )
+    , trace_at_( p.code_.size(), -1 ) {
+    record_.reserve(kMaxTraceLength);
+}
+
+std::size_t Core::TraceCache::size() const {
+    return traces_.size();
+}
+
+/**
+ * @program:     Core::TraceCache::startRun
+ * @description: This function drops the recording left by the last run, which may have
+ *               ended in the middle of a loop. The counters and the traces are kept
+ */
+void Core::TraceCache::startRun() {
+    recording_ = false;
+    record_.clear();
+}
+
+/**
+ * @program:     Core::TraceCache::onStep
+ * @description: This function is called by the interpreter after a command succeeds, when
+ *               it's recording or the command is a jump. It records the command, or counts
+ *               the backward jump and enters the trace of its target
+ * @line:        The line of command which has just been executed
+ * @m:           The machine after the command
+ * @input:       The input of level
+ * @step_limit:  The step limit of run, 0 means no limit
+ * @profile:     The counts of commands executed in traces are added to it when it's not nullptr
+ */
+void Core::TraceCache::onStep(
+    const Core::Program& p,
+    unsigned int line,
+    Core::Machine& m,
+    const std::vector<std::int64_t>& input,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    const Core::Instruction& ins = p.code_[line];
+
+    if (recording_) {
+        record_.push_back({ line, ins.op_ == Core::Opcode::kJumpifzero && m.handbox_ == 0 });
+        if (m.ref_ - 1 == record_header_) {
+            compile();
+            recording_ = false;
+        } else if (record_.size() >= kMaxTraceLength) {
+            recording_ = false;
+            hot_[record_header_] = 0;
+            threshold_[record_header_] *= 2;
+            return;
+        } else {
+            return;
+        }
+    }
+
+    // The trace is closed when the run comes back to its header, too long traces (e.g. an
+    // outer loop around a loop which runs long) are given up and tried later
+
+    if (ins.op_ != Core::Opcode::kJump && ins.op_ != Core::Opcode::kJumpifzero) return;
+    const unsigned int target = m.ref_ - 1;
+    if (target > line) return;
+
+    // Only a backward jump counts, a jumpifzero going on has target line + 1
+
+    if (trace_at_[target] >= 0) {
+        run(traces_[trace_at_[target]], m, input, step_limit, profile);
+    } else if (++hot_[target] >= threshold_[target]) {
+        recording_ = true;
+        record_header_ = target;
+        record_.clear();
+    }
+}
+
+/**
+ * @program:     Core::TraceCache::compile
+ * @description: This function compiles the recording to a trace. Every recorded command
+ *               succeeded, so its operand is in range, and which places must be full is known
+ *               from the order of commands, except for what the round reads before writing
+ */
+void Core::TraceCache::compile() {
+    const auto& code = program_.code_;
+    Core::HotTrace t;
+    t.header_ = record_header_;
+    t.length_ = record_.size();
+
+    bool hand_known = false;
+    std::vector<unsigned char> vacant_known(vac_size_, false);
+
+    auto readHand = [&]() {
+        if (!hand_known) t.need_hand_ = true;
+        hand_known = true;
+    };
+    auto readVacant = [&](int x) {
+        if (!vacant_known[x]) t.need_vacant_.push_back(x);
+        vacant_known[x] = true;
+    };
+
+    for (unsigned int i = 0; i < record_.size(); ++i) {
+        const unsigned int line = record_[i].line_;
+        const int x = code[line].operand_;
+        Core::TraceOpcode op = Core::TraceOpcode::kTraceInbox;     // Set by every case but kJump
+
+        switch (code[line].op_) {
+        case Core::Opcode::kInbox :
+            op = Core::TraceOpcode::kTraceInbox;
+            hand_known = true;
+            break;
+        case Core::Opcode::kOutbox :
+            op = Core::TraceOpcode::kTraceOutbox;
+            readHand();
+            break;
+        case Core::Opcode::kAdd :
+            op = Core::TraceOpcode::kTraceAdd;
+            readHand();
+            readVacant(x);
+            break;
+        case Core::Opcode::kSub :
+            op = Core::TraceOpcode::kTraceSub;
+            readHand();
+            readVacant(x);
+            break;
+        case Core::Opcode::kCopyto :
+            op = Core::TraceOpcode::kTraceCopyto;
+            readHand();
+            vacant_known[x] = true;
+            break;
+        case Core::Opcode::kCopyfrom :
+            op = Core::TraceOpcode::kTraceCopyfrom;
+            readVacant(x);
+            hand_known = true;
+            break;
+        case Core::Opcode::kJump :
+            t.jump_line_.push_back(line);
+            t.jump_index_.push_back(i);
+            continue;
+        case Core::Opcode::kJumpifzero :
+            if (record_[i].taken_) {
+                op = Core::TraceOpcode::kTraceGuardZero;
+                readHand();
+            } else {
+                op = Core::TraceOpcode::kTraceGuardNonZero;
+            }
+            break;
+        }
+        t.ops_.push_back({ op, x, line, i });
+    }
+
+    // hand_known means whether the handbox is empty is decided by the commands before. An
+    // empty handbox is 0, so a jumpifzero going on never reads an empty handbox
+
+    trace_at_[t.header_] = traces_.size();
+    traces_.push_back(std::move(t));
+}
+
+/**
+ * @program:     runTrace
+ * @description: This function runs rounds of the trace until a guard fails or the next round
+ *               may reach the step limit, then the interpreter goes on from m.ref_
+ */
+template <bool kProfiled>
+static void runTrace(
+    const Core::HotTrace& t,
+    Core::Machine& m,
+    const std::vector<std::int64_t>& input,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    auto leave = [&](const Core::TraceOp& op) {
+        m.ref_ = op.line_ + 1;
+        m.steps_ += op.index_;
+        if constexpr (kProfiled) {
+            profile->steps_ += op.index_;
+            for (std::size_t j = 0; j < t.jump_line_.size() && t.jump_index_[j] < op.index_; ++j) {
+                profile->count_[t.jump_line_[j]]++;
+            }
+        }
+    };
+
+    while (true) {
+        if (step_limit != 0 && m.steps_ + t.length_ > step_limit) return;
+        if (t.need_hand_ && m.handbox_empty_) return;
+        for (int x : t.need_vacant_) {
+            if (m.vacant_empty_[x]) return;
+        }
+
+        // The run is at the header, so leaving here needs nothing else
+
+        for (const Core::TraceOp& op : t.ops_) {
+            const int x = op.operand_;
+
+            switch (op.op_) {
+            case Core::TraceOpcode::kTraceInbox :
+                if (m.input_pos_ == input.size()) return leave(op);
+                m.handbox_ = static_cast<int>(input[m.input_pos_++]);
+                m.handbox_empty_ = false;
+                break;
+            case Core::TraceOpcode::kTraceOutbox :
+                m.output_.push_back(m.handbox_);
+                m.handbox_ = Core::Robot::kEmptyHandbox;
+                m.handbox_empty_ = true;
+                break;
+            case Core::TraceOpcode::kTraceAdd :
+                m.handbox_ += m.vacant_[x];
+                break;
+            case Core::TraceOpcode::kTraceSub :
+                m.handbox_ -= m.vacant_[x];
+                break;
+            case Core::TraceOpcode::kTraceCopyto :
+                m.vacant_[x] = m.handbox_;
+                m.vacant_empty_[x] = false;
+                break;
+            case Core::TraceOpcode::kTraceCopyfrom :
+                m.handbox_ = m.vacant_[x];
+                m.handbox_empty_ = false;
+                break;
+            case Core::TraceOpcode::kTraceGuardZero :
+                if (m.handbox_ != 0) return leave(op);
+                if constexpr (kProfiled) profile->taken_[op.line_]++;
+                break;
+            case Core::TraceOpcode::kTraceGuardNonZero :
+                if (m.handbox_ == 0) return leave(op);
+                if constexpr (kProfiled) profile->not_taken_[op.line_]++;
+                break;
+            }
+            if constexpr (kProfiled) profile->count_[op.line_]++;
+        }
+
+        m.steps_ += t.length_;
+        if constexpr (kProfiled) {
+            profile->steps_ += t.length_;
+            for (unsigned int line : t.jump_line_) profile->count_[line]++;
+        }
+    }
+}
+
+void Core::TraceCache::run(
+    const Core::HotTrace& t,
+    Core::Machine& m,
+    const std::vector<std::int64_t>& input,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    if (profile == nullptr) {
+        runTrace<false>(t, m, input, step_limit, nullptr);
+    } else {
+        runTrace<true>(t, m, input, step_limit, profile);
+    }
+}
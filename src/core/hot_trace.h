@@ -0,0 +1,119 @@
+#ifndef HOT_TRACE_H
+#define HOT_TRACE_H
+
+#include "engine.h"
+
+#include <vector>
+
+namespace Core {
+
+// Trace compilation of hot loops. The interpreter counts the backward jumps to every
+// command, when a command is jumped back to often enough, the commands executed from it
+// until the run comes back to it are recorded and compiled to a straight block:
+//
+//  - `jump` disappears, it's only counted as a step
+//  - `jumpifzero` becomes a guard of the direction that was recorded
+//  - the operands are checked once when compiling, the empty places once per round
+//
+// Whenever a guard fails, the run leaves the block before that command and the interpreter
+// executes it, so the errors and the steps are the same as Command::runRefCommand.
+
+enum TraceOpcode {
+    kTraceInbox,
+    kTraceOutbox,
+    kTraceAdd,
+    kTraceSub,
+    kTraceCopyto,
+    kTraceCopyfrom,
+    kTraceGuardZero,        // Recorded jumping, leaves when the handbox is not 0
+    kTraceGuardNonZero      // Recorded going on, leaves when the handbox is 0
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-27
+ */
+class TraceOp {
+  public:
+    TraceOpcode op_;
+    int operand_;
+    unsigned int line_;     // Lines count from 0 here
+    unsigned int index_;    // Position in the recorded trace, the steps done before this command
+};
+
+/**
+ * HotTrace is one compiled loop, it starts and ends at header_
+ *
+ * @author: AshGrey
+ * @date:   2024-12-27
+ */
+class HotTrace {
+  public:
+    unsigned int header_;
+    unsigned int length_;                   // Steps of a full round, the jumps included
+    std::vector<TraceOp> ops_;              // Without the jumps
+    std::vector<unsigned int> jump_line_;   // The jumps, only for the profile
+    std::vector<unsigned int> jump_index_;
+    bool need_hand_ = false;                // The round reads the handbox before setting it
+    std::vector<int> need_vacant_;          // The round reads them before writing them
+};
+
+/**
+ * TraceCache keeps the hot counters and the compiled traces of one program. It can be used
+ * by many runs of the program on levels with the same vacant size
+ *
+ * @author: AshGrey
+ * @date:   2024-12-27
+ */
+class TraceCache {
+  public:
+    static constexpr unsigned int kHotThreshold = 16;   // Backward jumps before recording
+    static constexpr unsigned int kMaxTraceLength = 512;
+
+    TraceCache(const Program& p, int vac_size);
+
+    bool recording() const { return recording_; }
+    int vacSize() const { return vac_size_; }
+    std::size_t size() const;                           // Count of compiled traces
+
+    void startRun();
+    void onStep(
+        const Program& p,
+        unsigned int line,
+        Machine& m,
+        const std::vector<std::int64_t>& input,
+        unsigned long long step_limit,
+        Profile* profile
+    );
+
+  private:
+    class Recorded {
+      public:
+        unsigned int line_;
+        bool taken_;
+    };
+
+    void compile();
+    void run(
+        const HotTrace& t,
+        Machine& m,
+        const std::vector<std::int64_t>& input,
+        unsigned long long step_limit,
+        Profile* profile
+    );
+
+    const Program& program_;
+    int vac_size_;
+    std::vector<unsigned int> hot_;         // Backward jumps to every command
+    std::vector<unsigned int> threshold_;   // Doubled every time the recording fails
+    std::vector<int> trace_at_;             // Index of the trace starting at every command, or -1
+    std::vector<HotTrace> traces_;
+
+    bool recording_ = false;
+    unsigned int record_header_ = 0;
+    std::vector<Recorded> record_;
+};
+
+}
+
+#endif
@@ -0,0 +1,247 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `input_source.h`                                     //
+//======================================================//
+
+#include "input_source.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+std::size_t Core::SequenceInput::read(int* buf, std::size_t n) {
+    n = std::min(n, seq_.size() - pos_);
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::int64_t box = seq_[pos_ + i];
+        if (box < std::numeric_limits<int>::min() || box > std::numeric_limits<int>::max()) {
+            error_ = "The box " + std::to_string(box) + " doesn't fit int.";
+            n = i;
+            break;
+        }
+        buf[i] = static_cast<int>(box);
+    }
+    pos_ += n;
+    return n;
+}
+
+Core::TextInput::TextInput(std::FILE* file, bool owned) : file_(file), owned_(owned) {
+#ifdef __linux__
+    if (pipe2(cancel_, O_CLOEXEC) != 0) cancel_[0] = cancel_[1] = -1;
+#endif
+}
+
+Core::TextInput::~TextInput() {
+    if (owned_) std::fclose(file_);
+#ifdef __linux__
+    for (int fd : cancel_) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+/**
+ * @program:     Core::TextInput::cancel
+ * @description: This function wakes the read which waits for the file, it and every read
+ *               after it return 0. It may be called from any thread
+ */
+void Core::TextInput::cancel() {
+#ifdef __linux__
+    const char wake = 0;
+    while (cancel_[1] >= 0 && write(cancel_[1], &wake, 1) < 0 && errno == EINTR) {}
+#endif
+}
+
+/**
+ * @program:     Core::TextInput::fill
+ * @description: This function reads at most n bytes of the file, it waits in poll for the
+ *               file and the pipe of cancel, so it never blocks in read
+ * @return:      The count of bytes, 0 at the end of file, on an error or when cancelled
+ */
+std::size_t Core::TextInput::fill(char* buf, std::size_t n) {
+#ifdef __linux__
+    const int fd = fileno(file_);
+    while (true) {
+        pollfd fds[2] = { { fd, POLLIN, 0 }, { cancel_[0], POLLIN, 0 } };
+        if (poll(fds, cancel_[0] >= 0 ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            error_ = "Fail to read the input.";
+            return 0;
+        }
+        if (fds[1].revents != 0) return 0;
+        const ssize_t got = ::read(fd, buf, n);
+        if (got >= 0) return got;
+        if (errno != EINTR && errno != EAGAIN) {
+            error_ = "Fail to read the input.";
+            return 0;
+        }
+    }
+#else
+    const std::size_t got = std::fread(buf, 1, n, file_);
+    if (got == 0 && std::ferror(file_)) error_ = "Fail to read the input.";
+    return got;
+#endif
+}
+
+/**
+ * @program:     Core::TextInput::open
+ * @description: This function opens the file, which may be a named pipe
+ */
+std::expected<std::unique_ptr<Core::TextInput>, std::string> Core::TextInput::open(
+    const std::filesystem::path& path
+) {
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) return std::unexpected("Fail to open " + path.string());
+    return std::unique_ptr<Core::TextInput>(new Core::TextInput(file, true));
+}
+
+std::unique_ptr<Core::TextInput> Core::TextInput::standardInput() {
+    return std::unique_ptr<Core::TextInput>(new Core::TextInput(stdin, false));
+}
+
+/**
+ * @program:     Core::TextInput::read
+ * @description: This function parses the boxes of the bytes read, a box split by the end of
+ *               the bytes waits for the next read. An illegal box ends the input with error
+ */
+std::size_t Core::TextInput::read(int* buf, std::size_t n) {
+    std::size_t count = 0;
+    while (count < n && error_.empty()) {
+        while (begin_ < end_ && std::isspace(static_cast<unsigned char>(bytes_[begin_]))) ++begin_;
+        std::size_t stop = begin_;
+        while (stop < end_ && !std::isspace(static_cast<unsigned char>(bytes_[stop]))) ++stop;
+
+        if (stop == end_ && !eof_) {
+
+            // The box may go on in the bytes not read yet, so the rest is moved to the front
+
+            std::memmove(bytes_.data(), bytes_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+            if (end_ == bytes_.size()) {
+                error_ = "A box is too long.";
+                break;
+            }
+            const std::size_t got = fill(bytes_.data() + end_, bytes_.size() - end_);
+            eof_ = got == 0;
+            end_ += got;
+            continue;
+        }
+        if (begin_ == stop) break;
+
+        const char* first = bytes_.data() + begin_;
+        const char* last = bytes_.data() + stop;
+        if (*first == '+' && last - first > 1) first++;
+        int value;
+        auto [ptr, ec] = std::from_chars(first, last, value);
+        if (ec != std::errc() || ptr != last) {
+            error_ = "Illegal box `" + std::string(bytes_.data() + begin_, stop - begin_) + "`.";
+            break;
+        }
+        buf[count++] = value;
+        begin_ = stop;
+    }
+    return count;
+}
+
+std::size_t Core::GeneratorInput::read(int* buf, std::size_t n) {
+    std::size_t count = 0;
+    while (!done_ && count < n) {
+        if (next_(buf[count])) {
+            count++;
+        } else {
+            done_ = true;
+        }
+    }
+    return count;
+}
+
+/**
+ * @program:     Core::InputConveyor::InputConveyor
+ * @description: This function starts the thread which prefetches the chunks
+ * @chunk:       Boxes of a chunk
+ * @prefetch:    Otherwise the chunks are read by the engine when it needs them
+ */
+Core::InputConveyor::InputConveyor(
+    std::unique_ptr<Core::InputSource> source,
+    std::size_t chunk,
+    bool prefetch
+) : source_(std::move(source)), front_(std::max<std::size_t>(chunk, 1)) {
+    if (prefetch) {
+        back_.resize(front_.size());
+        thread_ = std::thread(&Core::InputConveyor::produce, this);
+    }
+}
+
+/**
+ * @program:     Core::InputConveyor::~InputConveyor
+ * @description: This function stops the prefetching thread. The engine may stop before the
+ *               end of input, when the thread waits for a pipe which never closes, so the
+ *               read is cancelled before the thread is joined
+ */
+Core::InputConveyor::~InputConveyor() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    source_->cancel();
+    thread_.join();
+}
+
+/**
+ * @program:     Core::InputConveyor::produce
+ * @description: This function is the prefetching thread, it fills back_ and waits until
+ *               the engine takes it, an empty chunk is the end
+ */
+void Core::InputConveyor::produce() {
+    while (true) {
+        const std::size_t n = source_->read(back_.data(), back_.size());
+        std::unique_lock<std::mutex> guard(lock_);
+        back_size_ = n;
+        back_ready_ = true;
+        changed_.notify_all();
+        if (n == 0) return;
+        changed_.wait(guard, [this]() { return !back_ready_ || stop_; });
+        if (stop_) return;
+    }
+}
+
+/**
+ * @program:     Core::InputConveyor::refill
+ * @description: This function swaps the prefetched chunk in, or reads the next chunk when
+ *               there is no prefetching
+ * @return:      FALSE when the input has ended
+ */
+bool Core::InputConveyor::refill() {
+    pos_ = 0;
+    if (!thread_.joinable()) {
+        size_ = source_->read(front_.data(), front_.size());
+        return size_ != 0;
+    }
+    std::unique_lock<std::mutex> guard(lock_);
+    changed_.wait(guard, [this]() { return back_ready_; });
+    if (back_size_ == 0) {
+        size_ = 0;
+        return false;
+    }
+    front_.swap(back_);
+    size_ = back_size_;
+    back_ready_ = false;
+    changed_.notify_all();
+    return true;
+}
@@ -0,0 +1,169 @@
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Core {
+
+// Streamed input for levels too long to keep in Level::provided_seq_. An InputSource gives
+// the boxes in chunks, from a vector, a text file or pipe, or a generator, and the
+// InputConveyor takes them one by one for `inbox` (see Core::runStreamed). The conveyor
+// holds two chunks : while the engine takes the boxes of one, a thread of the conveyor
+// fills the other, so the memory is the same for any length of input.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class InputSource {
+  public:
+    virtual ~InputSource() = default;
+
+    // Fills at most n boxes to buf and returns the count, 0 is the end of input
+
+    virtual std::size_t read(int* buf, std::size_t n) = 0;
+
+    // The reason why the input ended early, empty when it's the real end
+
+    virtual std::string error() const { return {}; }
+
+    // Makes a read which waits in another thread return 0, InputConveyor calls it when the
+    // engine stops before the end of input. A source which never waits ignores it
+
+    virtual void cancel() {}
+};
+
+/**
+ * SequenceInput gives the boxes of a level, the input ends at a box which doesn't fit int
+ *
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SequenceInput : public InputSource {
+  public:
+    explicit SequenceInput(const std::vector<std::int64_t>& seq) : seq_(seq) {}
+
+    std::size_t read(int* buf, std::size_t n) override;
+    std::string error() const override { return error_; }
+
+  private:
+    const std::vector<std::int64_t>& seq_;
+    std::size_t pos_ = 0;
+    std::string error_;
+};
+
+/**
+ * TextInput reads boxes separated by whitespace, in the format of `input` of level files.
+ * A pipe or a terminal may never close, so on Linux the read waits in poll together with
+ * a pipe of its own, and cancel writes to that pipe
+ *
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class TextInput : public InputSource {
+  public:
+    ~TextInput() override;
+
+    static std::expected<std::unique_ptr<TextInput>, std::string> open(const std::filesystem::path& path);
+    static std::unique_ptr<TextInput> standardInput();
+
+    std::size_t read(int* buf, std::size_t n) override;
+    std::string error() const override { return error_; }
+    void cancel() override;
+
+  private:
+    TextInput(std::FILE* file, bool owned);
+
+    std::size_t fill(char* buf, std::size_t n);
+
+    std::FILE* file_;
+    bool owned_;
+    int cancel_[2] = { -1, -1 };    // The pipe which wakes the read, see cancel
+    std::vector<char> bytes_ = std::vector<char>(1 << 16);
+    std::size_t begin_ = 0;     // Unparsed bytes are bytes_[begin_, end_)
+    std::size_t end_ = 0;
+    bool eof_ = false;
+    std::string error_;
+};
+
+/**
+ * GeneratorInput takes the boxes from a function, which returns false at the end
+ *
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class GeneratorInput : public InputSource {
+  public:
+    explicit GeneratorInput(std::function<bool(int&)> next) : next_(std::move(next)) {}
+
+    std::size_t read(int* buf, std::size_t n) override;
+
+  private:
+    std::function<bool(int&)> next_;
+    bool done_ = false;
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class InputConveyor {
+  public:
+    static constexpr std::size_t kDefaultChunk = 1 << 16;
+
+    explicit InputConveyor(
+        std::unique_ptr<InputSource> source,
+        std::size_t chunk = kDefaultChunk,
+        bool prefetch = true
+    );
+    ~InputConveyor();
+    InputConveyor(const InputConveyor&) = delete;
+    InputConveyor& operator=(const InputConveyor&) = delete;
+
+    /**
+     * @program:     Core::InputConveyor::next
+     * @description: This function takes the next box, box is not changed at the end
+     * @return:      FALSE when the input has ended
+     */
+    bool next(int& box) {
+        if (pos_ == size_ && !refill()) return false;
+        box = front_[pos_++];
+        return true;
+    }
+
+    std::string error() const { return source_->error(); }
+
+  private:
+    bool refill();
+    void produce();
+
+    std::unique_ptr<InputSource> source_;
+    std::vector<int> front_;    // The chunk which the engine takes boxes from
+    std::size_t pos_ = 0;
+    std::size_t size_ = 0;
+
+    // The prefetched chunk is handed over under the lock, back_ready_ tells who owns back_
+
+    std::vector<int> back_;
+    std::size_t back_size_ = 0;
+    bool back_ready_ = false;
+    bool stop_ = false;
+    std::mutex lock_;
+    std::condition_variable changed_;
+    std::thread thread_;
+};
+
+}
+
+#endif
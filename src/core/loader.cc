@@ -0,0 +1,110 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file `loader.h` //
+//======================================================//
+
+#include "loader.h"
+#include "trace.h"
+
+#include <cstdint>
+#include <limits>
+#include <sstream>
+
+/**
+ * @program:     stripComment
+ * @description: This function removes the `#` comment of a line
+ */
+static std::string stripComment(const std::string& line) {
+    return line.substr(0, line.find('#'));
+}
+
+/**
+ * @program:     Core::parseLevel
+ * @description: This function reads a level file, see the format in `loader.h`
+ * @return:      The level, or the message with the line number when the file is illegal
+ */
+std::expected<Core::Level, std::string> Core::parseLevel(std::istream& in) {
+    Core::TraceSpan span("parseLevel", "load");
+    Core::Level level;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(in, line)) {
+        line_number++;
+        std::stringstream ss(stripComment(line));
+        std::string key;
+        if (!(ss >> key)) continue;
+
+        if (key == "vacant") {
+            if (!(ss >> level.vac_size_) || level.vac_size_ < 0) {
+                return std::unexpected("Line " + std::to_string(line_number) + " : illegal vacant size.");
+            }
+        } else if (key == "available") {
+            std::string name;
+            while (ss >> name) level.available_cmd_.push_back(name);
+        } else if (key == "input" || key == "needed") {
+            auto& seq = (key == "input") ? level.provided_seq_ : level.needed_seq_;
+            std::int64_t value;
+            while (ss >> value) seq.push_back(value);
+            if (!ss.eof()) {
+                return std::unexpected("Line " + std::to_string(line_number) + " : illegal box value.");
+            }
+        } else if (key == "value") {
+            std::string type;
+            ss >> type;
+            if (type == "int16") level.value_kind_ = Core::ValueKind::kValue16;
+            else if (type == "int32") level.value_kind_ = Core::ValueKind::kValue32;
+            else if (type == "int64") level.value_kind_ = Core::ValueKind::kValue64;
+            else return std::unexpected("Line " + std::to_string(line_number) + " : unknown value type `" + type + "`.");
+        } else {
+            return std::unexpected("Line " + std::to_string(line_number) + " : unknown key `" + key + "`.");
+        }
+    }
+
+    // The value type may come after the boxes, so they are checked at the end
+
+    if (level.value_kind_ != Core::ValueKind::kValue64) {
+        for (const auto* seq : { &level.provided_seq_, &level.needed_seq_ }) {
+            for (std::int64_t box : *seq) {
+                if (box < std::numeric_limits<int>::min() || box > std::numeric_limits<int>::max()) {
+                    return std::unexpected("The box " + std::to_string(box) + " doesn't fit int, it needs `value int64`.");
+                }
+            }
+        }
+    }
+    return level;
+}
+
+/**
+ * @program:     Core::parseCommands
+ * @description: This function reads a command file, see the format in `loader.h`. The names
+ *               are not checked here, Game::initialize and decodeProgram do it
+ * @return:      The commands, or the message with the line number when the file is illegal
+ */
+std::expected<Core::CommandList, std::string> Core::parseCommands(std::istream& in) {
+    Core::TraceSpan span("parseCommands", "load");
+    Core::CommandList cmd;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(in, line)) {
+        line_number++;
+        std::stringstream ss(stripComment(line));
+        std::string name;
+        if (!(ss >> name)) continue;
+
+        int index;
+        if (ss >> index) {
+            cmd.emplace_back(name, index);
+        } else if (ss.eof()) {
+            cmd.emplace_back(name, Core::Command::SingleCommand::kNullVacant);
+        } else {
+            return std::unexpected("Line " + std::to_string(line_number) + " : illegal index.");
+        }
+    }
+    return cmd;
+}
@@ -0,0 +1,50 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "engine.h"
+
+#include <charconv>
+#include <expected>
+#include <istream>
+#include <string>
+#include <string_view>
+
+namespace Core {
+
+// Level file, every line is a key and its values, `#` starts a comment :
+//
+//     vacant 3
+//     available inbox outbox copyto copyfrom
+//     input 1 2 3
+//     needed 3 2 1
+//     value int64     # Optional : int16, int32 (default) or int64, see Core::ValueKind
+//
+// The boxes of a level which isn't int64 must fit int.
+//
+// Command file, every line is a command name and the optional index :
+//
+//     inbox
+//     copyto 0
+//     jump 1
+
+std::expected<Level, std::string> parseLevel(std::istream& in);
+std::expected<CommandList, std::string> parseCommands(std::istream& in);
+
+/**
+ * @program:     Core::parseNumber
+ * @description: This function reads the whole text as a number, the tools read the values
+ *               of their options with it, so a bad value is reported instead of thrown
+ * @return:      FALSE when the text isn't a number of type T, number is unchanged then
+ */
+template <class T>
+bool parseNumber(std::string_view text, T& number) {
+    T value;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) return false;
+    number = value;
+    return true;
+}
+
+}
+
+#endif
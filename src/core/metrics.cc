@@ -0,0 +1,282 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `metrics.h`                                          //
+//======================================================//
+
+#include "metrics.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace {
+
+constexpr std::array<const char*, Core::kMetricCounterCount> kCounterName = {
+    "robox_submissions_total",
+    "robox_steps_total",
+    "robox_verdicts_total{verdict=\"success\"}",
+    "robox_verdicts_total{verdict=\"fail\"}",
+    "robox_verdicts_total{verdict=\"error\"}",
+    "robox_log_bytes_total",
+    "robox_verdict_cache_total{result=\"hit\"}",
+    "robox_verdict_cache_total{result=\"miss\"}"
+};
+
+// The labels of one metric family (e.g. the verdicts) are in a row, only the first of them
+// prints the HELP and TYPE
+
+constexpr std::array<const char*, Core::kMetricCounterCount> kCounterHelp = {
+    "Submissions evaluated.",
+    "Steps executed by the engines.",
+    "Verdicts of the submissions.",
+    nullptr,
+    nullptr,
+    "Bytes written to the log file.",
+    "Lookups of the verdict cache.",
+    nullptr
+};
+
+/**
+ * Shard is the metrics of one thread, only the owner thread writes it, so an update is a
+ * relaxed load and store, not a locked read-modify-write
+ */
+struct Shard {
+    std::array<std::atomic<unsigned long long>, Core::kMetricCounterCount> counter_ = {};
+    std::array<
+        std::array<std::atomic<unsigned long long>, Core::kMetricBucketCount + 1>,
+        Core::kMetricHistogramCount
+    > bucket_ = {};
+    std::array<std::atomic<unsigned long long>, Core::kMetricHistogramCount> sum_ns_ = {};
+};
+
+// A shard outlives its thread, the counts of a finished worker are still exported
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<Shard>> registry;
+std::array<std::atomic<long long>, Core::kMetricGaugeCount> gauges = {};
+
+Shard& threadShard() {
+    thread_local std::shared_ptr<Shard> shard = [] {
+        auto s = std::make_shared<Shard>();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(s);
+        return s;
+    }();
+    return *shard;
+}
+
+void bump(std::atomic<unsigned long long>& a, unsigned long long n) {
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+}
+
+void Core::addMetric(Core::MetricCounter counter, unsigned long long n) {
+    bump(threadShard().counter_[counter], n);
+}
+
+void Core::setMetric(Core::MetricGauge gauge, long long value) {
+    gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+void Core::addMetric(Core::MetricGauge gauge, long long delta) {
+    gauges[gauge].fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @program:     Core::observeMetric
+ * @description: This function puts a sample to the histogram
+ * @seconds:     The sample, e.g. the latency of one run
+ */
+void Core::observeMetric(Core::MetricHistogram histogram, double seconds) {
+    Shard& s = threadShard();
+    int b = 0;
+    while (b < Core::kMetricBucketCount && seconds > Core::kMetricBucketBound[b]) b++;
+    bump(s.bucket_[histogram][b], 1);
+    bump(s.sum_ns_[histogram], static_cast<unsigned long long>(seconds * 1e9));
+}
+
+/**
+ * @program:     Core::renderMetrics
+ * @description: This function sums the shards of all threads
+ * @return:      The metrics in Prometheus text format (version 0.0.4)
+ */
+std::string Core::renderMetrics() {
+    std::array<unsigned long long, Core::kMetricCounterCount> counter = {};
+    std::array<std::array<unsigned long long, Core::kMetricBucketCount + 1>, Core::kMetricHistogramCount> bucket = {};
+    std::array<unsigned long long, Core::kMetricHistogramCount> sum_ns = {};
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& s : registry) {
+            for (int i = 0; i < Core::kMetricCounterCount; ++i) {
+                counter[i] += s->counter_[i].load(std::memory_order_relaxed);
+            }
+            for (int h = 0; h < Core::kMetricHistogramCount; ++h) {
+                for (int b = 0; b <= Core::kMetricBucketCount; ++b) {
+                    bucket[h][b] += s->bucket_[h][b].load(std::memory_order_relaxed);
+                }
+                sum_ns[h] += s->sum_ns_[h].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::stringstream ss;
+    for (int i = 0; i < Core::kMetricCounterCount; ++i) {
+        if (kCounterHelp[i] != nullptr) {
+            std::string family = kCounterName[i];
+            family = family.substr(0, family.find('{'));
+            ss << "# HELP " << family << ' ' << kCounterHelp[i] << '\n'
+               << "# TYPE " << family << " counter\n";
+        }
+        ss << kCounterName[i] << ' ' << counter[i] << '\n';
+    }
+
+    ss << "# HELP robox_queue_depth Submissions waiting to be judged.\n"
+       << "# TYPE robox_queue_depth gauge\n"
+       << "robox_queue_depth " << gauges[Core::kMetricQueueDepth].load(std::memory_order_relaxed) << '\n';
+
+    ss << "# HELP robox_run_latency_seconds Latency of loading, running and checking one submission.\n"
+       << "# TYPE robox_run_latency_seconds histogram\n";
+    unsigned long long cumulative = 0;
+    char bound[32];
+    for (int b = 0; b <= Core::kMetricBucketCount; ++b) {
+        cumulative += bucket[Core::kMetricRunLatency][b];
+        if (b < Core::kMetricBucketCount) {
+            std::snprintf(bound, sizeof(bound), "%.9g", Core::kMetricBucketBound[b]);
+        } else {
+            std::snprintf(bound, sizeof(bound), "+Inf");
+        }
+        ss << "robox_run_latency_seconds_bucket{le=\"" << bound << "\"} " << cumulative << '\n';
+    }
+    ss << "robox_run_latency_seconds_sum " << sum_ns[Core::kMetricRunLatency] * 1e-9 << '\n'
+       << "robox_run_latency_seconds_count " << cumulative << '\n';
+    return ss.str();
+}
+
+/**
+ * @program:     Core::writeMetrics
+ * @description: This function writes the metrics to a temporary file and renames it, so a
+ *               collector (e.g. the textfile collector of node_exporter) never reads half a file
+ * @return:      FALSE when the file can't be written
+ */
+bool Core::writeMetrics(const std::filesystem::path& path) {
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp);
+        if (!file.is_open()) return false;
+        file << Core::renderMetrics();
+        if (!file.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+Core::MetricsServer::~MetricsServer() {
+    stop();
+}
+
+#ifdef __linux__
+
+/**
+ * @program:     Core::MetricsServer::start
+ * @description: This function listens on the socket and serves it in a background thread
+ * @path:        The path of Unix domain socket, an old socket file is removed
+ * @return:      FALSE when the socket can't be created
+ */
+bool Core::MetricsServer::start(const std::filesystem::path& path) {
+    stop();
+
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.string().size() >= sizeof(addr.sun_path)) return false;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0) return false;
+    unlink(path.c_str());
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd_, 8) != 0) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    path_ = path;
+    running_ = true;
+    thread_ = std::thread(&Core::MetricsServer::serve, this);
+    return true;
+}
+
+void Core::MetricsServer::stop() {
+    if (!running_) return;
+    running_ = false;
+    thread_.join();
+    close(fd_);
+    fd_ = -1;
+    unlink(path_.c_str());
+}
+
+/**
+ * @program:     Core::MetricsServer::serve
+ * @description: This function answers the connections one by one, the request is read but
+ *               ignored, every path gets the metrics
+ */
+void Core::MetricsServer::serve() {
+    while (running_) {
+        pollfd p = { fd_, POLLIN, 0 };
+        if (poll(&p, 1, 100) <= 0) continue;
+
+        // Wake up every 100 ms to see whether the server is stopped
+
+        int client = accept(fd_, nullptr, nullptr);
+        if (client < 0) continue;
+
+        char request[1024];
+        pollfd c = { client, POLLIN, 0 };
+        if (poll(&c, 1, 100) > 0) recv(client, request, sizeof(request), 0);
+
+        std::string body = Core::renderMetrics();
+        std::string response =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+        std::size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += n;
+        }
+        close(client);
+    }
+}
+
+#else
+
+bool Core::MetricsServer::start(const std::filesystem::path& path) {
+    return false;
+}
+
+void Core::MetricsServer::stop() {}
+
+void Core::MetricsServer::serve() {}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace Core {
+
+// Metrics of a long-running judge process, exported in Prometheus text format. Every thread
+// updates its own shard with relaxed atomics, so the hot path takes no lock, the shards are
+// only summed by renderMetrics.
+
+enum MetricCounter {
+    kMetricSubmissions,
+    kMetricSteps,
+    kMetricVerdictSuccess,
+    kMetricVerdictFail,
+    kMetricVerdictError,
+    kMetricLogBytes,
+    kMetricCacheHit,
+    kMetricCacheMiss
+};
+
+enum MetricGauge {
+    kMetricQueueDepth
+};
+
+enum MetricHistogram {
+    kMetricRunLatency
+};
+
+constexpr static int kMetricCounterCount = 8;
+constexpr static int kMetricGaugeCount = 1;
+constexpr static int kMetricHistogramCount = 1;
+
+// Upper bounds of the latency buckets in seconds, the last bucket is +Inf
+
+constexpr static int kMetricBucketCount = 12;
+constexpr static std::array<double, kMetricBucketCount> kMetricBucketBound = {
+    1e-6, 4e-6, 1.6e-5, 6.4e-5, 2.56e-4, 1.024e-3, 4.096e-3, 1.6384e-2, 6.5536e-2, 0.262144, 1.048576, 4.194304
+};
+
+void addMetric(MetricCounter counter, unsigned long long n = 1);
+void setMetric(MetricGauge gauge, long long value);
+void addMetric(MetricGauge gauge, long long delta);
+void observeMetric(MetricHistogram histogram, double seconds);
+
+std::string renderMetrics();
+bool writeMetrics(const std::filesystem::path& path);   // Replaces the file atomically
+
+/**
+ * MetricsServer answers every connection of a Unix domain socket with the current metrics
+ * as an HTTP response, so `curl --unix-socket PATH http://localhost/metrics` or a local
+ * Prometheus agent can scrape it
+ *
+ * @author: AshGrey
+ * @date:   2024-12-25
+ */
+class MetricsServer {
+  public:
+    MetricsServer() = default;
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start(const std::filesystem::path& path);
+    void stop();
+
+  private:
+    void serve();
+
+    int fd_ = -1;
+    std::filesystem::path path_;
+    std::atomic<bool> running_ = false;
+    std::thread thread_;
+};
+
+}
+
+#endif
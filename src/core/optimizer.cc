@@ -0,0 +1,386 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `optimizer.h`                                        //
+//======================================================//
+
+#include "optimizer.h"
+
+#include <algorithm>
+
+/**
+ * @program:     noOpNext
+ * @description: This function returns the line which the no-op at line moves the run to
+ */
+static unsigned int noOpNext(const Core::Program& p, unsigned int line) {
+    return p.code_[line].op_ == Core::Opcode::kJump ? p.code_[line].operand_ - 1 : line + 1;
+}
+
+/**
+ * @program:     handFull
+ * @description: This function finds the lines which are reached with a full handbox on
+ *               every path, and the lines which are reached at all
+ * @full:        full[i] is whether the handbox is never empty before line i
+ * @reached:     reached[i] is whether line i can be reached from the begin
+ */
+static void handFull(
+    const Core::Program& p,
+    std::vector<unsigned char>& full,
+    std::vector<unsigned char>& reached
+) {
+    const auto& code = p.code_;
+    const unsigned int size = code.size();
+    full.assign(size, true);
+    reached.assign(size, false);
+    std::vector<unsigned int> work;
+
+    auto flow = [&](unsigned int line, bool hand) {
+        if (line >= size) return;
+        if (!reached[line]) {
+            reached[line] = true;
+            full[line] = hand;
+        } else if (full[line] && !hand) {
+            full[line] = false;
+        } else {
+            return;
+        }
+        work.push_back(line);
+    };
+    auto target = [&](unsigned int line) -> unsigned int {
+        const int x = code[line].operand_;
+        return x >= 1 && static_cast<unsigned int>(x) <= size ? x - 1 : size;
+    };
+
+    if (size != 0) flow(0, false);
+    while (!work.empty()) {
+        const unsigned int line = work.back();
+        work.pop_back();
+
+        switch (code[line].op_) {
+        case Core::Opcode::kOutbox :
+            flow(line + 1, false);
+            break;
+        case Core::Opcode::kJump :
+            flow(target(line), full[line]);
+            break;
+        case Core::Opcode::kJumpifzero :
+            flow(line + 1, true);
+            flow(target(line), true);
+            break;
+        default :
+            flow(line + 1, true);
+        }
+    }
+
+    // A command which succeeds leaves the handbox full, except outbox. jumpifzero goes on
+    // only with a box other than 0 and jumps only with a full handbox, an empty one is 0
+}
+
+/**
+ * @program:     Core::optimizeProgram
+ * @description: This function builds the control flow graph of the decoded program, threads
+ *               its edges through the no-ops and drops the commands which can't be reached
+ * @p:           The decoded program
+ */
+Core::OptimizedProgram Core::optimizeProgram(const Core::Program& p) {
+    const auto& code = p.code_;
+    const unsigned int size = code.size();
+    Core::OptimizedProgram o;
+    o.size_ = size;
+
+    std::vector<unsigned char> full, reached;
+    handFull(p, full, reached);
+
+    std::vector<unsigned char> no_op(size, false);
+    for (unsigned int line = 0; line < size; ++line) {
+        const int x = code[line].operand_;
+        if (code[line].op_ == Core::Opcode::kJump) {
+            no_op[line] = x >= 1 && static_cast<unsigned int>(x) <= size;
+        } else if (code[line].op_ == Core::Opcode::kJumpifzero) {
+            no_op[line] = reached[line] && full[line] && static_cast<unsigned int>(x) == line + 2 && line + 2 <= size;
+        }
+        o.threaded_ += no_op[line];
+    }
+
+    // A jumpifzero to the next command checks only that the handbox is full, and it can't
+    // jump out of the program
+
+    std::vector<unsigned int> seen(size, 0);
+    unsigned int walk = 0;
+    auto thread = [&](unsigned int line) {
+        Core::OptEdge e{ line, 0, line };
+        walk++;
+        while (e.to_ < size && no_op[e.to_] && seen[e.to_] != walk) {
+            seen[e.to_] = walk;
+            e.skipped_++;
+            e.to_ = noOpNext(p, e.to_);
+        }
+        return e;
+    };
+
+    // A cycle of no-ops stops the walk, the no-op met again is kept and executed
+
+    std::vector<Core::OptEdge> next(size), target(size);
+    for (unsigned int line = 0; line < size; ++line) {
+        const int x = code[line].operand_;
+        next[line] = thread(line + 1);
+        if (code[line].op_ >= Core::Opcode::kJump && x >= 1 && static_cast<unsigned int>(x) <= size) {
+            target[line] = thread(x - 1);
+        }
+    }
+    o.entry_ = thread(0);
+
+    std::vector<unsigned int> index(size + 1, Core::OptEdge::kNoEdge);
+    std::vector<unsigned int> work;
+    auto visit = [&](const Core::OptEdge& e) {
+        if (e.to_ < size && index[e.to_] == Core::OptEdge::kNoEdge) {
+            index[e.to_] = 0;
+            work.push_back(e.to_);
+        }
+    };
+    visit(o.entry_);
+    while (!work.empty()) {
+        const unsigned int line = work.back();
+        work.pop_back();
+        if (code[line].op_ != Core::Opcode::kJump) visit(next[line]);
+        if (code[line].op_ >= Core::Opcode::kJump) visit(target[line]);
+    }
+
+    // index[i] marks the reached lines, they are numbered in the original order below, so
+    // a run which goes on stays in the same order
+
+    unsigned int count = 0;
+    for (unsigned int line = 0; line < size; ++line) {
+        if (index[line] != Core::OptEdge::kNoEdge) index[line] = count++;
+    }
+    index[size] = count;
+
+    auto remap = [&index](Core::OptEdge e) {
+        if (e.to_ != Core::OptEdge::kNoEdge) e.to_ = index[e.to_];
+        return e;
+    };
+    o.code_.reserve(count);
+    for (unsigned int line = 0; line < size; ++line) {
+        if (index[line] == Core::OptEdge::kNoEdge) continue;
+        o.code_.push_back({ code[line].op_, code[line].operand_, line, remap(next[line]), remap(target[line]) });
+    }
+    o.entry_ = remap(o.entry_);
+    return o;
+}
+
+/**
+ * @program:     skipNoOps
+ * @description: This function counts the no-ops skipped by the edge as they were executed
+ * @return:      The line where the step limit stops the run among them, or the size of
+ *               program when the run goes on along the edge
+ */
+template <bool kProfiled>
+static unsigned int skipNoOps(
+    const Core::Program& p,
+    const Core::OptEdge& e,
+    Core::Machine& m,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    unsigned long long k = e.skipped_;
+    if (step_limit != 0 && m.steps_ + k > step_limit) k = step_limit - m.steps_;
+    m.steps_ += k;
+    if (!kProfiled && k == e.skipped_) return p.code_.size();
+
+    unsigned int line = e.first_;
+    for (unsigned long long i = 0; i < k; ++i) {
+        if constexpr (kProfiled) {
+            profile->count_[line]++;
+            if (p.code_[line].op_ == Core::Opcode::kJumpifzero) {
+                (m.handbox_ == 0 ? profile->taken_ : profile->not_taken_)[line]++;
+            }
+        }
+        line = noOpNext(p, line);
+    }
+    if constexpr (kProfiled) profile->steps_ += k;
+    return k == e.skipped_ ? p.code_.size() : line;
+}
+
+/**
+ * @program:     optimizedLoop
+ * @description: This function is the loop of Core::runOptimized, the checks of every command
+ *               are the same as the loop of Core::runDecoded. m.ref_ is only set when the
+ *               run stops, with the line in the original program
+ */
+template <bool kProfiled>
+static std::expected<Core::Verdict, Core::Diagnostic> optimizedLoop(
+    const Core::OptimizedProgram& o,
+    const Core::Program& p,
+    const Core::Level& level,
+    Core::Machine& m,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    const auto& code = o.code_;
+    const auto& input = level.provided_seq_;
+    const unsigned int end = code.size();
+    const unsigned int size = o.size_;
+    const int vac_size = m.vacant_.size();
+    unsigned int pc;
+
+    auto fail = [&m](Core::DiagnosticCode c, unsigned int line, int operand) {
+        m.ref_ = line + 1;
+        return std::unexpected(Core::Diagnostic{ c, m.ref_, operand });
+    };
+
+    pc = o.entry_.to_;
+    if (o.entry_.skipped_ != 0) {
+        const unsigned int stop = skipNoOps<kProfiled>(p, o.entry_, m, step_limit, profile);
+        if (stop != size) return fail(Core::DiagnosticCode::kStepLimitExceeded, stop, 0);
+    }
+
+    while (true) {
+        if (step_limit != 0 && m.steps_ >= step_limit) {
+            return fail(Core::DiagnosticCode::kStepLimitExceeded, pc == end ? size : code[pc].line_, 0);
+        }
+        if (pc == end) {
+            m.ref_ = size + 1;
+            break;
+        }
+
+        // All the commands have been executed
+
+        const Core::OptInstruction& ins = code[pc];
+        const unsigned int line = ins.line_;
+        const int x = ins.operand_;
+        const Core::OptEdge* e = &ins.next_;
+
+        switch (ins.op_) {
+        case Core::Opcode::kInbox :
+            if (x != Core::Command::SingleCommand::kNullVacant) {
+                return fail(Core::DiagnosticCode::kOpindexSurplus, line, x);
+            }
+            if (m.input_pos_ == input.size()) {
+                m.ref_ = line + 1;
+                goto finish;
+            }
+            m.handbox_ = static_cast<int>(input[m.input_pos_++]);
+            m.handbox_empty_ = false;
+            break;
+        case Core::Opcode::kOutbox :
+            if (x != Core::Command::SingleCommand::kNullVacant) {
+                return fail(Core::DiagnosticCode::kOpindexSurplus, line, x);
+            }
+            if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, line, x);
+            m.output_.push_back(m.handbox_);
+            m.handbox_ = Core::Robot::kEmptyHandbox;
+            m.handbox_empty_ = true;
+            break;
+        case Core::Opcode::kAdd :
+        case Core::Opcode::kSub :
+            if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, line, x);
+            if (x < 0) return fail(Core::DiagnosticCode::kOpindexUnderflow, line, x);
+            if (x >= vac_size) return fail(Core::DiagnosticCode::kOpindexOverflow, line, x);
+            if (m.vacant_empty_[x]) return fail(Core::DiagnosticCode::kVacantEmpty, line, x);
+            m.handbox_ = (ins.op_ == Core::Opcode::kAdd)
+                       ? m.handbox_ + m.vacant_[x]
+                       : m.handbox_ - m.vacant_[x];
+            break;
+        case Core::Opcode::kCopyto :
+            if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, line, x);
+            if (x < 0) return fail(Core::DiagnosticCode::kOpindexUnderflow, line, x);
+            if (x >= vac_size) return fail(Core::DiagnosticCode::kOpindexOverflow, line, x);
+            m.vacant_[x] = m.handbox_;
+            m.vacant_empty_[x] = false;
+            break;
+        case Core::Opcode::kCopyfrom :
+            if (x < 0) return fail(Core::DiagnosticCode::kOpindexUnderflow, line, x);
+            if (x >= vac_size) return fail(Core::DiagnosticCode::kOpindexOverflow, line, x);
+            if (m.vacant_empty_[x]) return fail(Core::DiagnosticCode::kVacantEmpty, line, x);
+            m.handbox_ = m.vacant_[x];
+            m.handbox_empty_ = false;
+            break;
+        case Core::Opcode::kJump :
+            if (x <= 0) return fail(Core::DiagnosticCode::kCmindexUnderflow, line, x);
+            if (static_cast<unsigned int>(x) > size) {
+                return fail(Core::DiagnosticCode::kCmindexOverflow, line, x);
+            }
+            e = &ins.target_;
+            break;
+        case Core::Opcode::kJumpifzero :
+            if (m.handbox_ == 0) {
+                if (m.handbox_empty_) return fail(Core::DiagnosticCode::kHandboxEmpty, line, x);
+                if (x <= 0) return fail(Core::DiagnosticCode::kCmindexUnderflow, line, x);
+                if (static_cast<unsigned int>(x) > size) {
+                    return fail(Core::DiagnosticCode::kCmindexOverflow, line, x);
+                }
+                e = &ins.target_;
+                if constexpr (kProfiled) profile->taken_[line]++;
+            } else if constexpr (kProfiled) {
+                profile->not_taken_[line]++;
+            }
+            break;
+        }
+        m.steps_++;
+        if constexpr (kProfiled) {
+            profile->count_[line]++;
+            profile->steps_++;
+        }
+        if (e->skipped_ == 0 && e->to_ == pc + 1) {
+            pc++;
+            continue;
+        }
+
+        // Going on is predicted, so the next command doesn't wait for the edge to be read
+
+        if (e->skipped_ == 0) {
+            pc = e->to_;
+            continue;
+        }
+        if (!kProfiled && (step_limit == 0 || m.steps_ + e->skipped_ <= step_limit)) {
+            m.steps_ += e->skipped_;
+            pc = e->to_;
+            continue;
+        }
+        const unsigned int stop = skipNoOps<kProfiled>(p, *e, m, step_limit, profile);
+        if (stop != size) return fail(Core::DiagnosticCode::kStepLimitExceeded, stop, 0);
+        pc = e->to_;
+    }
+
+finish:
+    return std::equal(
+        m.output_.begin(), m.output_.end(),
+        level.needed_seq_.begin(), level.needed_seq_.end()
+    ) ? Core::Verdict::kSuccess : Core::Verdict::kFail;
+}
+
+/**
+ * @program:     Core::runOptimized
+ * @description: This function runs the optimized program on the machine until the game
+ *               ends, the result is the same as running p with Core::runDecoded
+ * @o:           The program optimized from p
+ * @p:           The decoded program, the no-ops are read from it when the run needs them
+ * @level:       The level, the input is read from level.provided_seq_
+ * @m:           The machine, it should be reset before the first call
+ * @step_limit:  The game stops with kStepLimitExceeded after so many steps, 0 means no limit
+ * @profile:     The counts of every original command are added to it when it's not nullptr.
+ *               A machine with the sparse vacant is run by Core::runDecoded
+ */
+std::expected<Core::Verdict, Core::Diagnostic> Core::runOptimized(
+    const Core::OptimizedProgram& o,
+    const Core::Program& p,
+    const Core::Level& level,
+    Core::Machine& m,
+    unsigned long long step_limit,
+    Core::Profile* profile
+) {
+    if (m.sparse() || (o.threaded_ == 0 && o.code_.size() == o.size_)) {
+        return Core::runDecoded(p, level, m, step_limit, profile);
+    }
+    if (auto overflow = Core::inputOverflow<int>(level, m.input_pos_)) return std::unexpected(*overflow);
+
+    // Nothing was optimized, the loop of runDecoded is a bit faster on the same commands
+
+    return profile == nullptr
+         ? optimizedLoop<false>(o, p, level, m, step_limit, nullptr)
+         : optimizedLoop<true>(o, p, level, m, step_limit, profile);
+}
@@ -0,0 +1,72 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "engine.h"
+
+#include <vector>
+
+namespace Core {
+
+// Control flow optimization of decoded programs. The commands which only move the run on
+// are no-ops:
+//
+//  - `jump` to a command of the program
+//  - `jumpifzero` to the next command, when the handbox is never empty there
+//
+// Every edge of the control flow graph is threaded through the no-ops it reaches, and the
+// commands which can't be reached any more are dropped. An edge remembers how many no-ops
+// it skips and where the first one is, so the steps, the profile and the command where the
+// step limit stops the run are the same as Command::runRefCommand.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class OptEdge {
+  public:
+    static constexpr unsigned int kNoEdge = ~0U;
+
+    unsigned int to_ = kNoEdge;     // Index in OptimizedProgram::code_, code_.size() is the end
+    unsigned int skipped_ = 0;      // Count of no-ops skipped on the way
+    unsigned int first_ = 0;        // Line of the first no-op skipped, lines count from 0
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class OptInstruction {
+  public:
+    Opcode op_;
+    int operand_;           // The same as Instruction::operand_, for the checks and diagnostics
+    unsigned int line_;     // Line in the original program
+    OptEdge next_;          // Going on, not used by `jump`
+    OptEdge target_;        // Jumping, kNoEdge when the target is out of the program
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-28
+ */
+class OptimizedProgram {
+  public:
+    std::vector<OptInstruction> code_;
+    OptEdge entry_;                 // From the begin of run to the first command executed
+    unsigned int size_ = 0;         // Size of the original program, targets are checked with it
+    unsigned int threaded_ = 0;     // Count of no-ops found
+};
+
+OptimizedProgram optimizeProgram(const Program& p);
+
+std::expected<Verdict, Diagnostic> runOptimized(
+    const OptimizedProgram& o,
+    const Program& p,
+    const Level& level,
+    Machine& m,
+    unsigned long long step_limit,
+    Profile* profile = nullptr
+);
+
+}
+
+#endif
@@ -0,0 +1,168 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `perf_counters.h`                                    //
+//======================================================//
+
+#include "perf_counters.h"
+
+#include <atomic>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#endif
+
+static std::atomic<bool> perf_enabled = false;
+
+void Core::setPerfEnabled(bool enabled) {
+    perf_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Core::isPerfEnabled() {
+    return perf_enabled.load(std::memory_order_relaxed);
+}
+
+Core::PerfCounters& Core::threadPerfCounters() {
+    static thread_local Core::PerfCounters counters;
+    return counters;
+}
+
+bool Core::PerfSample::anyValid() const {
+    for (auto v : valid_) {
+        if (v) return true;
+    }
+    return false;
+}
+
+Core::PerfSample& Core::PerfSample::operator+=(const Core::PerfSample& s) {
+    if (s.runs_ == 0) return *this;
+
+    // A submission which fails on loading has no run
+
+    for (int i = 0; i < Core::kPerfEventCount; ++i) {
+        value_[i] += s.value_[i];
+        valid_[i] = (runs_ == 0) ? s.valid_[i] : (valid_[i] && s.valid_[i]);
+    }
+    multiplexed_ = multiplexed_ || s.multiplexed_;
+    runs_ += s.runs_;
+    return *this;
+}
+
+#ifdef __linux__
+
+/**
+ * @program:     openCounter
+ * @description: This function opens one user space counter of the calling thread in the
+ *               group, the leader is opened disabled and the group reads all its counters
+ *               at once with their enabled and running time
+ * @group:       The leader of the group, -1 opens the leader
+ * @return:      The file descriptor, -1 when the counter is not available
+ */
+static int openCounter(unsigned int type, unsigned long long config, int group) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0;  // The members follow their leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+Core::PerfCounters::PerfCounters() {
+    const std::array<std::pair<unsigned int, unsigned long long>, Core::kPerfEventCount> events = {{
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                  | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+    }};
+
+    // The first counter which opens leads the group, a counter which can't join it is left
+    // out instead of counted alone, it would count another interval
+
+    fd_.fill(-1);
+    for (int i = 0; i < Core::kPerfEventCount; ++i) {
+        const int leader = members_ == 0 ? -1 : fd_[order_[0]];
+        fd_[i] = openCounter(events[i].first, events[i].second, leader);
+        if (fd_[i] >= 0) order_[members_++] = i;
+    }
+}
+
+Core::PerfCounters::~PerfCounters() {
+    for (int fd : fd_) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void Core::PerfCounters::start() {
+    if (members_ == 0) return;
+    ioctl(fd_[order_[0]], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd_[order_[0]], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+Core::PerfSample Core::PerfCounters::stop() {
+    Core::PerfSample s;
+    s.runs_ = 1;
+    if (members_ == 0) return s;
+
+    // The group is read as its count, the enabled and the running time, and then the values
+    // in the order of the group. A group which never ran has no valid value
+
+    const int leader = fd_[order_[0]];
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    std::array<std::uint64_t, 3 + Core::kPerfEventCount> data = {};
+    const ssize_t size = (3 + members_) * sizeof(std::uint64_t);
+    if (read(leader, data.data(), size) != size || data[0] != static_cast<std::uint64_t>(members_) || data[2] == 0) {
+        return s;
+    }
+    const std::uint64_t enabled = data[1];
+    const std::uint64_t running = data[2];
+    s.multiplexed_ = running < enabled;
+    for (int m = 0; m < members_; ++m) {
+        std::uint64_t value = data[3 + m];
+        if (s.multiplexed_) value = static_cast<std::uint64_t>(static_cast<double>(value) * enabled / running);
+        s.value_[order_[m]] = value;
+        s.valid_[order_[m]] = true;
+    }
+    return s;
+}
+
+#else
+
+Core::PerfCounters::PerfCounters() {
+    fd_.fill(-1);
+}
+
+Core::PerfCounters::~PerfCounters() {}
+
+void Core::PerfCounters::start() {}
+
+Core::PerfSample Core::PerfCounters::stop() {
+    Core::PerfSample s;
+    s.runs_ = 1;
+    return s;
+}
+
+#endif
+
+bool Core::PerfCounters::available() const {
+    for (int fd : fd_) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+
+namespace Core {
+
+// Hardware performance counters around the run loop of engines (Linux perf_event_open).
+// The counters are opened as one group, so they count the same interval and their ratios
+// hold even when the kernel multiplexes them, then the values are scaled to the whole
+// interval. A counter which can't be opened is left out, so in a container or VM without
+// some counters the others still work, and without any of them the samples are invalid.
+
+enum PerfEvent {
+    kPerfCycles,
+    kPerfInstructions,
+    kPerfBranchMisses,
+    kPerfL1dMisses
+};
+
+constexpr static int kPerfEventCount = 4;
+constexpr static std::array<const char*, kPerfEventCount> kPerfEventName = {
+    "cycles", "instructions", "branch_misses", "l1d_misses"
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-24
+ */
+class PerfSample {
+  public:
+    std::array<unsigned long long, kPerfEventCount> value_ = {};
+    std::array<bool, kPerfEventCount> valid_ = {};  // FALSE when the counter can't be opened
+    unsigned long long runs_ = 0;                   // How many runs are added to this sample
+    bool multiplexed_ = false;                      // The group didn't count all the time, values are scaled
+
+    bool anyValid() const;
+    PerfSample& operator+=(const PerfSample& s);
+};
+
+/**
+ * PerfCounters opens the counters of the calling thread, they only count user space
+ *
+ * @author: AshGrey
+ * @date:   2024-12-24
+ */
+class PerfCounters {
+  public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+    void start();
+    PerfSample stop();
+
+  private:
+    std::array<int, kPerfEventCount> fd_;
+    std::array<int, kPerfEventCount> order_;        // Events in the order of the group, the leader first
+    int members_ = 0;
+};
+
+void setPerfEnabled(bool enabled);  // runEngine fills RunResult::perf_ when it's on
+bool isPerfEnabled();
+PerfCounters& threadPerfCounters(); // Opened once per thread, on the first call
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `profile.h`                                          //
+//======================================================//
+
+#include "profile.h"
+
+#include <algorithm>
+#include <atomic>
+
+static std::atomic<bool> profile_enabled = false;
+
+void Core::setProfileEnabled(bool enabled) {
+    profile_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Core::isProfileEnabled() {
+    return profile_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @program:     Core::Profile::reset
+ * @description: This function clears the counts for a program of the given size
+ * @size:        The count of commands
+ */
+void Core::Profile::reset(std::size_t size) {
+    count_.assign(size, 0);
+    taken_.assign(size, 0);
+    not_taken_.assign(size, 0);
+    steps_ = 0;
+    size_ = size;
+}
+
+unsigned long long Core::Profile::hottest() const {
+    return count_.empty() ? 0 : *std::max_element(count_.begin(), count_.end());
+}
@@ -0,0 +1,35 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Core {
+
+/**
+ * Profile counts the executions of every command of a program. Only the commands which
+ * succeed are counted, so the sum of count_ is the steps of the run, which is the speed
+ * score of HRM, and size_ is the size score.
+ *
+ * @author: AshGrey
+ * @date:   2024-12-26
+ */
+class Profile {
+  public:
+    std::vector<unsigned long long> count_;     // count_[i] is of the command whose ID is i + 1
+    std::vector<unsigned long long> taken_;     // Times that jumpifzero jumps, 0 for the others
+    std::vector<unsigned long long> not_taken_; // Times that jumpifzero goes on
+    unsigned long long steps_ = 0;
+    std::size_t size_ = 0;
+
+    void reset(std::size_t size);
+    unsigned long long hottest() const;         // The largest count, 0 when nothing has run
+    bool operator==(const Profile& p) const = default;
+};
+
+void setProfileEnabled(bool enabled);   // runEngine fills RunResult::profile_ when it's on
+bool isProfileEnabled();
+
+}
+
+#endif
@@ -0,0 +1,307 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `program_cache.h`                                    //
+//======================================================//
+
+#include "program_cache.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Bump it whenever decodeProgram, optimizeProgram or the payload below changes what they
+// produce, the files of the old format are then in another subdirectory
+
+constexpr int kCompiledFormat = 1;
+constexpr char kFileMagic[8] = { 'R', 'B', 'X', 'C', 'P', '0', '1', '\0' };
+
+/**
+ * FileHeader is the start of a compiled file, the payload of words follows it
+ */
+struct FileHeader {
+    char magic_[8];
+    std::uint64_t build_;
+    std::uint64_t key_[2];
+    std::uint64_t words_;
+    std::uint64_t check_;
+};
+
+std::uint64_t payloadCheck(const std::vector<std::uint32_t>& words) {
+    Core::ContentHash h;
+    h.add(words.size());
+    for (std::uint32_t w : words) h.add(w);
+    return h.h_[0];
+}
+
+std::uint64_t buildHash() {
+    Core::ContentHash h;
+    h.add(Core::engineBuildId());
+    return h.h_[0];
+}
+
+std::string hex(std::uint64_t x) {
+    char s[17];
+    std::snprintf(s, sizeof(s), "%016llx", static_cast<unsigned long long>(x));
+    return s;
+}
+
+void putEdge(std::vector<std::uint32_t>& w, const Core::OptEdge& e) {
+    w.push_back(e.to_);
+    w.push_back(e.skipped_);
+    w.push_back(e.first_);
+}
+
+/**
+ * @program:     serialize
+ * @description: This function flattens the compiled program to words, every field is a
+ *               32-bit value
+ */
+std::vector<std::uint32_t> serialize(const Core::CompiledProgram& c) {
+    std::vector<std::uint32_t> w;
+    w.push_back(c.program_.code_.size());
+    for (const Core::Instruction& ins : c.program_.code_) {
+        w.push_back(ins.op_);
+        w.push_back(static_cast<std::uint32_t>(ins.operand_));
+    }
+    const Core::OptimizedProgram& o = c.optimized_;
+    putEdge(w, o.entry_);
+    w.push_back(o.size_);
+    w.push_back(o.threaded_);
+    w.push_back(o.code_.size());
+    for (const Core::OptInstruction& ins : o.code_) {
+        w.push_back(ins.op_);
+        w.push_back(static_cast<std::uint32_t>(ins.operand_));
+        w.push_back(ins.line_);
+        putEdge(w, ins.next_);
+        putEdge(w, ins.target_);
+    }
+    return w;
+}
+
+/**
+ * @program:     validEdge
+ * @description: This function checks that the edge stays in the programs, runOptimized
+ *               follows it without checks. The no-ops it skips are walked as skipNoOps does
+ * @followed:    Whether the run can follow the edge, the others are never read. The next
+ *               edge of `jump` may be kNoEdge, or skip no-ops to a command dropped
+ */
+bool validEdge(const Core::CompiledProgram& c, const Core::OptEdge& e, bool followed) {
+    const auto& code = c.program_.code_;
+    if (!followed) return true;
+    if (e.to_ > c.optimized_.code_.size() || e.skipped_ > code.size()) return false;
+    unsigned int line = e.first_;
+    for (unsigned int i = 0; i < e.skipped_; ++i) {
+        if (line >= code.size()) return false;
+        line = code[line].op_ == Core::Opcode::kJump ? static_cast<unsigned int>(code[line].operand_) - 1 : line + 1;
+    }
+    return true;
+}
+
+/**
+ * @program:     validIndices
+ * @description: This function checks every index of the optimized program against the
+ *               programs. The checksum doesn't stop a stale or forged file, and the engines
+ *               index the code with them
+ */
+bool validIndices(const Core::CompiledProgram& c) {
+    const auto& code = c.program_.code_;
+    const Core::OptimizedProgram& o = c.optimized_;
+    if (o.size_ != code.size() || !validEdge(c, o.entry_, true)) return false;
+    for (const Core::OptInstruction& ins : o.code_) {
+        if (ins.line_ >= code.size()) return false;
+        if (ins.op_ != code[ins.line_].op_ || ins.operand_ != code[ins.line_].operand_) return false;
+        const bool jumps = ins.op_ >= Core::Opcode::kJump
+                        && ins.operand_ >= 1 && static_cast<unsigned int>(ins.operand_) <= code.size();
+        if (!validEdge(c, ins.next_, ins.op_ != Core::Opcode::kJump) || !validEdge(c, ins.target_, jumps)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @program:     deserialize
+ * @description: This function reads the words of serialize back, the checksum has been
+ *               checked, but the counts are still checked against the size and the
+ *               indices against the programs
+ * @return:      FALSE when the words are too few or too many, or an index is out of range
+ */
+bool deserialize(const std::vector<std::uint32_t>& w, Core::CompiledProgram& c) {
+    std::size_t pos = 0;
+    auto take = [&](std::uint32_t& x) {
+        if (pos == w.size()) return false;
+        x = w[pos++];
+        return true;
+    };
+    auto takeEdge = [&](Core::OptEdge& e) {
+        return take(e.to_) && take(e.skipped_) && take(e.first_);
+    };
+
+    std::uint32_t n, op, operand;
+    if (!take(n) || n > w.size()) return false;
+    c.program_.code_.resize(n);
+    for (Core::Instruction& ins : c.program_.code_) {
+        if (!take(op) || !take(operand) || op > Core::Opcode::kJumpifzero) return false;
+        ins.op_ = static_cast<Core::Opcode>(op);
+        ins.operand_ = static_cast<int>(operand);
+    }
+    Core::OptimizedProgram& o = c.optimized_;
+    if (!takeEdge(o.entry_) || !take(o.size_) || !take(o.threaded_) || !take(n) || n > w.size()) return false;
+    o.code_.resize(n);
+    for (Core::OptInstruction& ins : o.code_) {
+        if (!take(op) || !take(operand) || op > Core::Opcode::kJumpifzero) return false;
+        ins.op_ = static_cast<Core::Opcode>(op);
+        ins.operand_ = static_cast<int>(operand);
+        if (!take(ins.line_) || !takeEdge(ins.next_) || !takeEdge(ins.target_)) return false;
+    }
+    return pos == w.size() && validIndices(c);
+}
+
+}
+
+/**
+ * @program:     Core::engineBuildId
+ * @description: This function names the format of compiled programs and the compiler
+ *               which built the engines
+ */
+std::string Core::engineBuildId() {
+    return "robox-compiled-" + std::to_string(kCompiledFormat) + " " + __VERSION__
+         + " " + std::to_string(sizeof(Core::OptInstruction));
+}
+
+Core::ProgramCache::ProgramCache(const std::filesystem::path& dir, std::size_t capacity)
+    : dir_(dir / hex(buildHash())), capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+/**
+ * @program:     Core::CompiledProgram::takeTraces
+ * @description: This function takes an idle trace cache of the vacant size for a run, or
+ *               makes a new one, it's given back by keepTraces after the run
+ */
+std::unique_ptr<Core::TraceCache> Core::CompiledProgram::takeTraces(int vac_size) const {
+    {
+        std::lock_guard<std::mutex> guard(traces_lock_);
+        for (auto it = idle_traces_.begin(); it != idle_traces_.end(); ++it) {
+            if ((*it)->vacSize() != vac_size) continue;
+            auto traces = std::move(*it);
+            idle_traces_.erase(it);
+            return traces;
+        }
+    }
+    return std::make_unique<Core::TraceCache>(program_, vac_size);
+}
+
+/**
+ * @program:     Core::CompiledProgram::keepTraces
+ * @description: This function gives the trace cache back after the run, it's dropped when
+ *               kMaxIdleTraces are already kept
+ */
+void Core::CompiledProgram::keepTraces(std::unique_ptr<Core::TraceCache> traces) const {
+    std::lock_guard<std::mutex> guard(traces_lock_);
+    if (idle_traces_.size() < kMaxIdleTraces) idle_traces_.push_back(std::move(traces));
+}
+
+/**
+ * @program:     Core::ProgramCache::compile
+ * @description: This function returns the compiled program from memory, the directory, or
+ *               compiles it and puts it to both. A program which can't be decoded isn't
+ *               cached, the error is returned at once
+ * @cmd:         Commands, they are the pair of command name and vacant index
+ * @available:   Available commands of the level
+ */
+std::expected<std::shared_ptr<const Core::CompiledProgram>, Core::Diagnostic> Core::ProgramCache::compile(
+    const Core::CommandList& cmd,
+    const std::vector<std::string>& available
+) {
+    Core::ContentHash h;
+    h.add(cmd.size());
+    for (const auto& [name, index] : cmd) {
+        h.add(name);
+        h.add(static_cast<std::uint32_t>(index));
+    }
+    std::vector<std::string> sorted = available;
+    std::sort(sorted.begin(), sorted.end());
+    h.add(sorted.size());
+    for (const std::string& name : sorted) h.add(name);
+    const std::pair<std::uint64_t, std::uint64_t> key = { h.h_[0], h.h_[1] };
+
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = memory_.find(key);
+        if (it != memory_.end()) return it->second;
+    }
+
+    auto remember = [&](std::shared_ptr<const Core::CompiledProgram> c) {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (memory_.size() >= capacity_) memory_.erase(memory_.begin());
+        memory_[key] = c;
+        return c;
+    };
+
+    const std::filesystem::path path = dir_ / (hex(key.first) + hex(key.second) + ".bin");
+    const std::uint64_t build = buildHash();
+    {
+        std::ifstream file(path, std::ios::binary);
+        FileHeader header;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            && std::memcmp(header.magic_, kFileMagic, sizeof(kFileMagic)) == 0
+            && header.build_ == build && header.key_[0] == key.first && header.key_[1] == key.second
+            && header.words_ <= (1ULL << 28)) {
+            std::vector<std::uint32_t> words(header.words_);
+            auto c = std::make_shared<Core::CompiledProgram>();
+            const std::streamsize bytes = words.size() * sizeof(std::uint32_t);
+            if (file.read(reinterpret_cast<char*>(words.data()), bytes)
+                && file.peek() == std::ifstream::traits_type::eof()
+                && payloadCheck(words) == header.check_ && deserialize(words, *c)) {
+                loaded_++;
+                return remember(std::move(c));
+            }
+        }
+    }
+
+    // A missing, stale or broken file is compiled again
+
+    auto p = Core::decodeProgram(cmd, available);
+    if (!p) return std::unexpected(p.error());
+    auto c = std::make_shared<Core::CompiledProgram>();
+    c->optimized_ = Core::optimizeProgram(*p);
+    c->program_ = std::move(*p);
+    compiled_++;
+
+    const std::vector<std::uint32_t> words = serialize(*c);
+    FileHeader header = {};
+    std::memcpy(header.magic_, kFileMagic, sizeof(kFileMagic));
+    header.build_ = build;
+    header.key_[0] = key.first;
+    header.key_[1] = key.second;
+    header.words_ = words.size();
+    header.check_ = payloadCheck(words);
+
+    // The temporary name is random, so two judges compiling the same program write two
+    // files and the last rename wins
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    std::filesystem::path tmp = path;
+    tmp += "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(std::uint32_t));
+        if (!file.good()) ec = std::make_error_code(std::errc::io_error);
+    }
+    if (!ec) std::filesystem::rename(tmp, path, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+    return remember(std::move(c));
+}
@@ -0,0 +1,91 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include "engine.h"
+#include "hot_trace.h"
+#include "optimizer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Core {
+
+// Cache of compiled programs, so a judge doesn't decode and optimize the same submission
+// again after a restart. A compiled program is the decoded program and its optimized form
+// (see `optimizer.h`), Core::runEngine takes it instead of decoding.
+//
+// The directory is content addressed : a program is the file named by the hash of its
+// commands and the available commands, under a subdirectory named by the build ID, so the
+// files of another build (another format or compiler) are never read. Every file has the
+// checksum of its payload, a broken or torn file is compiled again and replaced, and files
+// are written to a temporary name and renamed, so judges may share the directory. Compiled
+// programs are kept in memory too, an arbitrary one is dropped when it's full.
+//
+// A compiled program in memory also keeps the trace caches of its runs (see `hot_trace.h`),
+// so the loops which got hot in one run are already compiled for the next. A run takes a
+// cache for itself and gives it back, the runs on other threads take other ones.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class CompiledProgram {
+  public:
+    static constexpr std::size_t kMaxIdleTraces = 16;
+
+    Program program_;
+    OptimizedProgram optimized_;
+
+    std::unique_ptr<TraceCache> takeTraces(int vac_size) const;
+    void keepTraces(std::unique_ptr<TraceCache> traces) const;
+
+  private:
+    mutable std::mutex traces_lock_;
+    mutable std::vector<std::unique_ptr<TraceCache>> idle_traces_;     // Not taken by any run
+};
+
+std::string engineBuildId();
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class ProgramCache {
+  public:
+    explicit ProgramCache(const std::filesystem::path& dir, std::size_t capacity = 1 << 12);
+
+    std::expected<std::shared_ptr<const CompiledProgram>, Diagnostic> compile(
+        const CommandList& cmd,
+        const std::vector<std::string>& available
+    );
+
+    unsigned long long compiled() const { return compiled_; }   // Misses of both tiers
+    unsigned long long loaded() const { return loaded_; }       // Hits of the directory
+
+  private:
+    class KeyHash {
+      public:
+        std::size_t operator()(const std::pair<std::uint64_t, std::uint64_t>& k) const { return k.first; }
+    };
+
+    std::filesystem::path dir_;     // The subdirectory of the build
+    std::size_t capacity_;
+    std::unordered_map<
+        std::pair<std::uint64_t, std::uint64_t>, std::shared_ptr<const CompiledProgram>, KeyHash
+    > memory_;
+    std::mutex lock_;
+    std::atomic<unsigned long long> compiled_ = 0;
+    std::atomic<unsigned long long> loaded_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,259 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `rewrite.h`                                          //
+//======================================================//
+
+#include "rewrite.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+using Code = std::vector<Core::Instruction>;
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class Candidate {
+  public:
+    Code code_;
+    std::string rewrite_;
+};
+
+/**
+ * @program:     isJump
+ * @description: This function tells whether the command has a jump target
+ */
+static bool isJump(const Core::Instruction& ins) {
+    return ins.op_ >= Core::Opcode::kJump;
+}
+
+/**
+ * @program:     replaceLine
+ * @description: This function replaces the line with the lines of block and moves the
+ *               targets after it, a jump to the line goes to the first line of block. The
+ *               targets in block are of the code before the replacement too
+ * @line:        Line to replace, counts from 0
+ */
+static Code replaceLine(const Code& code, unsigned int line, const Code& block) {
+    const int shift = static_cast<int>(block.size()) - 1;
+    auto move = [&](Core::Instruction ins) {
+        if (isJump(ins) && ins.operand_ > static_cast<int>(line) + 1) ins.operand_ += shift;
+        return ins;
+    };
+
+    Code out;
+    for (unsigned int i = 0; i < code.size(); ++i) {
+        if (i != line) {
+            out.push_back(move(code[i]));
+            continue;
+        }
+        for (const Core::Instruction& ins : block) out.push_back(move(ins));
+    }
+    return out;
+}
+
+/**
+ * @program:     threadJumps
+ * @description: This function makes a candidate of every jump whose target is a `jump`
+ */
+static void threadJumps(const Code& code, std::vector<Candidate>& out) {
+    for (unsigned int line = 0; line < code.size(); ++line) {
+        if (!isJump(code[line])) continue;
+        const int target = code[line].operand_;
+        if (target <= 0 || target > static_cast<int>(code.size())) continue;
+        const Core::Instruction& next = code[target - 1];
+        if (next.op_ != Core::Opcode::kJump || next.operand_ == target) continue;
+
+        Candidate c{ code, "thread line " + std::to_string(line + 1) };
+        c.code_[line].operand_ = next.operand_;
+        out.push_back(std::move(c));
+    }
+}
+
+/**
+ * @program:     inlineJumps
+ * @description: This function makes a candidate of every `jump` and every length of the
+ *               lines copied from its target. The copy stops after a `jump`, otherwise a
+ *               `jump` to the line after the copied ones follows it
+ */
+static void inlineJumps(const Code& code, unsigned int max_inline, std::vector<Candidate>& out) {
+    const unsigned int size = code.size();
+    for (unsigned int line = 0; line < size; ++line) {
+        if (code[line].op_ != Core::Opcode::kJump) continue;
+        const int target = code[line].operand_;
+        if (target <= 0 || target > static_cast<int>(size) || target == static_cast<int>(line) + 1) continue;
+
+        Code block;
+        for (unsigned int i = target - 1; i < size && block.size() < max_inline; ++i) {
+            block.push_back(code[i]);
+            const bool ends = code[i].op_ == Core::Opcode::kJump;
+            if (!ends) {
+                if (i + 1 == size) break;
+                block.push_back({ Core::Opcode::kJump, static_cast<int>(i) + 2 });
+            }
+
+            // A copy which ends at the last line can't fall off the end from the middle
+
+            out.push_back({
+                replaceLine(code, line, block),
+                "inline " + std::to_string(block.size() - !ends) + " lines at line " + std::to_string(line + 1)
+            });
+            if (ends) break;
+            block.pop_back();
+        }
+    }
+}
+
+/**
+ * @program:     deleteLines
+ * @description: This function makes a candidate without every line, a jump to the line
+ *               goes to the line after it
+ */
+static void deleteLines(const Code& code, std::vector<Candidate>& out) {
+    for (unsigned int line = 0; line < code.size(); ++line) {
+        out.push_back({ replaceLine(code, line, {}), "delete line " + std::to_string(line + 1) });
+    }
+}
+
+/**
+ * @program:     hoistCopyfrom
+ * @description: This function makes a candidate of every `copyfrom` between the target of
+ *               a backward `jump` and the jump, which moves before the target. The jump
+ *               back goes after the moved line, other jumps to the target still reach it
+ */
+static void hoistCopyfrom(const Code& code, std::vector<Candidate>& out) {
+    const unsigned int size = code.size();
+    for (unsigned int back = 0; back < size; ++back) {
+        if (code[back].op_ != Core::Opcode::kJump) continue;
+        const int target = code[back].operand_;
+        if (target <= 0 || target > static_cast<int>(back) + 1) continue;
+        const unsigned int header = target - 1;
+
+        for (unsigned int line = header; line < back; ++line) {
+            if (code[line].op_ != Core::Opcode::kCopyfrom) continue;
+
+            // The lines from the header to the moved one go down by one line, and a jump
+            // to the moved line goes to the line after it as it did
+
+            Code c;
+            c.insert(c.end(), code.begin(), code.begin() + header);
+            c.push_back(code[line]);
+            c.insert(c.end(), code.begin() + header, code.begin() + line);
+            c.insert(c.end(), code.begin() + line + 1, code.end());
+            for (Core::Instruction& ins : c) {
+                const int t = ins.operand_;
+                if (isJump(ins) && t > static_cast<int>(header) + 1 && t <= static_cast<int>(line) + 1) {
+                    ins.operand_++;
+                }
+            }
+            c[back].operand_ = header + 2;
+            out.push_back({
+                std::move(c),
+                "hoist line " + std::to_string(line + 1) + " before line " + std::to_string(header + 1)
+            });
+        }
+    }
+}
+
+/**
+ * @program:     Core::reduceSteps
+ * @description: This function rewrites the submission until no rewrite reduces the average
+ *               steps, see `rewrite.h`. The candidates of a round are the same whatever the
+ *               threads are, and the first of the fastest ones is kept
+ * @tests:       The levels, the bounded equivalence uses the commands of the first one
+ * @submission:  Commands of a submission which succeeds on every test
+ * @options:     The bound of search and the threads
+ * @return:      The result, or the reason when the submission doesn't succeed
+ */
+std::expected<Core::RewriteResult, std::string> Core::reduceSteps(
+    const std::vector<Core::Level>& tests,
+    const Core::CommandList& submission,
+    const Core::RewriteOptions& options
+) {
+    if (tests.empty()) return std::unexpected("No test is given");
+    auto decoded = Core::decodeProgram(submission, tests[0].available_cmd_);
+    if (!decoded) return std::unexpected("Fail to load : " + Core::describeDiagnostic(decoded.error()));
+
+    Core::RewriteResult result;
+    std::vector<unsigned long long> limit;
+    unsigned long long total = 0;
+    for (const Core::Level& t : tests) {
+        auto run = Core::runEngine(Core::EngineKind::kDecodedEngine, t, submission, options.step_limit_);
+        if (!run.verdict_ || *run.verdict_ != Core::Verdict::kSuccess) {
+            return std::unexpected("The submission doesn't succeed on every test");
+        }
+        limit.push_back(run.state_.steps_ + 1);
+        total += run.state_.steps_;
+    }
+
+    // A candidate which takes more steps on a test than the submission is never kept, so
+    // its run stops there, and a rewrite which loops forever stops too
+
+    unsigned int threads = options.threads_ != 0 ? options.threads_ : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1U);
+    Core::EquivalenceBound bound = options.bound_;
+    bound.threads_ = 1;
+
+    Code code = decoded->code_;
+    unsigned long long best = total;
+    result.steps_before_ = static_cast<double>(total) / tests.size();
+
+    for (unsigned int round = 0; round < options.max_rounds_; ++round) {
+        std::vector<Candidate> candidates;
+        threadJumps(code, candidates);
+        inlineJumps(code, options.max_inline_, candidates);
+        hoistCopyfrom(code, candidates);
+        deleteLines(code, candidates);
+        result.candidates_ += candidates.size();
+
+        constexpr unsigned long long kRejected = std::numeric_limits<unsigned long long>::max();
+        std::vector<unsigned long long> steps(candidates.size(), kRejected);
+        std::atomic<std::size_t> next_index = 0;
+
+        auto work = [&]() {
+            for (std::size_t i = next_index++; i < candidates.size(); i = next_index++) {
+                const Core::CommandList cmd = Core::encodeProgram(candidates[i].code_);
+                unsigned long long sum = 0;
+                for (std::size_t t = 0; t < tests.size() && sum < best; ++t) {
+                    auto run = Core::runEngine(Core::EngineKind::kDecodedEngine, tests[t], cmd, limit[t]);
+                    if (!run.verdict_ || *run.verdict_ != Core::Verdict::kSuccess) {
+                        sum = kRejected;
+                        break;
+                    }
+                    sum += run.state_.steps_;
+                }
+                if (sum >= best) continue;
+
+                auto equivalence = Core::checkEquivalence(tests[0], cmd, submission, bound);
+                if (!equivalence || !equivalence->complete_ || !equivalence->equivalent_) continue;
+                steps[i] = sum;
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned int t = 1; t < std::min<std::size_t>(threads, candidates.size()); ++t) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto& t : pool) t.join();
+
+        auto it = std::min_element(steps.begin(), steps.end());
+        if (it == steps.end() || *it == kRejected) break;
+        const std::size_t kept = it - steps.begin();
+        code = std::move(candidates[kept].code_);
+        best = *it;
+        result.applied_.push_back(std::move(candidates[kept].rewrite_));
+    }
+
+    result.program_ = Core::encodeProgram(code);
+    result.steps_after_ = static_cast<double>(best) / tests.size();
+    return result;
+}
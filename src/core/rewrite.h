@@ -0,0 +1,59 @@
+#ifndef REWRITE_H
+#define REWRITE_H
+
+#include "equivalence.h"
+
+#include <expected>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+// Rewriting of a correct submission for the speed score. Every round makes the rewrites of
+// the current program below, runs them all on the tests, and keeps the one with the fewest
+// average steps among those which still succeed on every test and are equivalent to the
+// submission in the bound (see `equivalence.h`). The search stops when no rewrite helps.
+//
+//   thread     a jump to a `jump` goes to its target at once
+//   inline     a `jump` is replaced by the lines at its target, so they are fallen into
+//   hoist      a `copyfrom` in a loop moves before the loop, the loop jumps after it
+//   delete     a line is removed, e.g. a `copyfrom` of the value already in hand
+//
+// Inlining the first line of a loop at the jump back is the loop rotation. The candidates
+// of a round are evaluated by the threads.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class RewriteOptions {
+  public:
+    unsigned int max_rounds_ = 64;
+    unsigned int max_inline_ = 8;           // Lines copied by one inline at most
+    unsigned long long step_limit_ = 0;     // Of every test, 0 means no limit
+    unsigned int threads_ = 0;              // 0 means one per core
+    EquivalenceBound bound_;                // Its threads_ is ignored
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class RewriteResult {
+  public:
+    CommandList program_;
+    double steps_before_ = 0;               // Average over the tests
+    double steps_after_ = 0;
+    std::vector<std::string> applied_;      // Every rewrite kept, in order
+    unsigned long long candidates_ = 0;
+};
+
+std::expected<RewriteResult, std::string> reduceSteps(
+    const std::vector<Level>& tests,
+    const CommandList& submission,
+    const RewriteOptions& options
+);
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `similarity.h`                                       //
+//======================================================//
+
+#include "similarity.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+namespace {
+
+constexpr char kFileMagic[8] = { 'R', 'B', 'X', 'M', 'H', '0', '1', '\0' };
+constexpr std::uint32_t kUnknownOp = 15;
+
+/**
+ * @program:     bandKey
+ * @description: This function hashes the rows of one band of the signature
+ */
+std::uint64_t bandKey(const Core::MinHashSignature& s, int band) {
+    Core::ContentHash h;
+    for (int r = 0; r < Core::kLshRows; ++r) h.add(s[band * Core::kLshRows + r]);
+    return h.h_[0];
+}
+
+}
+
+/**
+ * @program:     Core::normalizeProgram
+ * @description: This function turns every command to a token of its opcode and its
+ *               operand renamed. Vacants and jump targets have their own names, which count
+ *               from 1 in the order of first use, 0 is no operand
+ */
+std::vector<std::uint32_t> Core::normalizeProgram(const Core::CommandList& cmd) {
+    std::unordered_map<int, std::uint32_t> vacant, target;
+    std::vector<std::uint32_t> tokens;
+    tokens.reserve(cmd.size());
+    for (const auto& [name, index] : cmd) {
+        auto it = std::find(Core::Command::kAllCmd.begin(), Core::Command::kAllCmd.end(), name);
+        const std::uint32_t op = it == Core::Command::kAllCmd.end() ? kUnknownOp : it - Core::Command::kAllCmd.begin();
+        std::uint32_t operand = 0;
+        if (index != Core::Command::SingleCommand::kNullVacant) {
+            auto& names = op >= Core::Opcode::kJump && op != kUnknownOp ? target : vacant;
+            operand = names.try_emplace(index, names.size() + 1).first->second;
+        }
+        tokens.push_back((op << 24) | std::min<std::uint32_t>(operand, 0xffffff));
+    }
+    return tokens;
+}
+
+/**
+ * @program:     Core::minHash
+ * @description: This function computes the MinHash signature of the n-grams of normalized
+ *               commands, a program shorter than n is one n-gram
+ */
+Core::MinHashSignature Core::minHash(const Core::CommandList& cmd, int ngram) {
+    const std::vector<std::uint32_t> tokens = Core::normalizeProgram(cmd);
+    Core::MinHashSignature s;
+    s.fill(std::numeric_limits<std::uint32_t>::max());
+    if (tokens.empty()) return s;
+
+    const std::size_t n = std::min<std::size_t>(std::max(ngram, 1), tokens.size());
+    for (std::size_t i = 0; i + n <= tokens.size(); ++i) {
+        Core::ContentHash h;
+        for (std::size_t j = 0; j < n; ++j) h.add(tokens[i + j]);
+        const std::uint64_t shingle = h.h_[0];
+
+        // The k-th hash function is the mix of the shingle with a seed of its own
+
+        for (int k = 0; k < Core::kMinHashSize; ++k) {
+            const std::uint64_t seed = 0x9e3779b97f4a7c15ULL * (k + 1);
+            const std::uint32_t v = Core::ContentHash::mix(shingle ^ seed) >> 32;
+            s[k] = std::min(s[k], v);
+        }
+    }
+    return s;
+}
+
+void Core::SimilarityIndex::insert(std::uint32_t id, const Core::MinHashSignature& s) {
+    if (!signature_.try_emplace(id, s).second) return;
+    for (int b = 0; b < Core::kLshBands; ++b) bucket_[b][bandKey(s, b)].push_back(id);
+}
+
+void Core::SimilarityIndex::add(std::uint32_t id, const Core::CommandList& cmd) {
+    if (contains(id)) return;
+    insert(id, Core::minHash(cmd));
+}
+
+/**
+ * @program:     Core::SimilarityIndex::addAll
+ * @description: This function computes the signatures of the programs not in the index yet
+ *               in parallel, and then puts them to the buckets in the order given
+ * @programs:    Pairs of ID and commands
+ * @threads:     0 means one per core
+ */
+void Core::SimilarityIndex::addAll(
+    const std::vector<std::pair<std::uint32_t, Core::CommandList>>& programs,
+    unsigned int threads
+) {
+    threads = threads != 0 ? threads : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1U);
+    std::vector<Core::MinHashSignature> signatures(programs.size());
+    std::atomic<std::size_t> next_index = 0;
+
+    auto work = [&]() {
+        for (std::size_t i = next_index++; i < programs.size(); i = next_index++) {
+            if (!contains(programs[i].first)) signatures[i] = Core::minHash(programs[i].second);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < std::min<std::size_t>(threads, programs.size()); ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& t : pool) t.join();
+
+    for (std::size_t i = 0; i < programs.size(); ++i) insert(programs[i].first, signatures[i]);
+}
+
+/**
+ * @program:     Core::SimilarityIndex::query
+ * @description: This function returns the programs which share a bucket with cmd and whose
+ *               estimated similarity is at least threshold, the most similar first
+ */
+std::vector<std::pair<std::uint32_t, double>> Core::SimilarityIndex::query(
+    const Core::CommandList& cmd,
+    double threshold
+) const {
+    const Core::MinHashSignature s = Core::minHash(cmd);
+    std::vector<std::uint32_t> candidates;
+    for (int b = 0; b < Core::kLshBands; ++b) {
+        auto it = bucket_[b].find(bandKey(s, b));
+        if (it != bucket_[b].end()) candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::pair<std::uint32_t, double>> result;
+    for (std::uint32_t id : candidates) {
+        const Core::MinHashSignature& other = signature_.at(id);
+        int equal = 0;
+        for (int k = 0; k < Core::kMinHashSize; ++k) equal += s[k] == other[k];
+        const double similarity = static_cast<double>(equal) / Core::kMinHashSize;
+        if (similarity >= threshold) result.push_back({ id, similarity });
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return result;
+}
+
+/**
+ * @program:     Core::SimilarityIndex::save
+ * @description: This function writes the signatures, the buckets are built again by load
+ * @return:      FALSE when the file can't be written
+ */
+bool Core::SimilarityIndex::save(const std::filesystem::path& path) const {
+    std::vector<std::uint32_t> ids;
+    for (const auto& entry : signature_) ids.push_back(entry.first);
+    std::sort(ids.begin(), ids.end());
+
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary);
+        if (!file.is_open()) return false;
+        const std::uint64_t count = ids.size();
+        file.write(kFileMagic, sizeof(kFileMagic));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (std::uint32_t id : ids) {
+            file.write(reinterpret_cast<const char*>(&id), sizeof(id));
+            file.write(reinterpret_cast<const char*>(signature_.at(id).data()), sizeof(Core::MinHashSignature));
+        }
+        if (!file.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+/**
+ * @program:     Core::SimilarityIndex::load
+ * @description: This function adds the signatures of the file to the index, so an index of
+ *               a course grows with the new submissions only
+ * @return:      FALSE when the file is missing or broken, the index is not changed then
+ */
+bool Core::SimilarityIndex::load(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kFileMagic)];
+    std::uint64_t count;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kFileMagic, sizeof(magic)) != 0) return false;
+    if (!file.read(reinterpret_cast<char*>(&count), sizeof(count))) return false;
+
+    std::vector<std::pair<std::uint32_t, Core::MinHashSignature>> entries;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::pair<std::uint32_t, Core::MinHashSignature> e;
+        if (!file.read(reinterpret_cast<char*>(&e.first), sizeof(e.first))) return false;
+        if (!file.read(reinterpret_cast<char*>(e.second.data()), sizeof(e.second))) return false;
+        entries.push_back(e);
+    }
+    for (const auto& [id, s] : entries) insert(id, s);
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef SIMILARITY_H
+#define SIMILARITY_H
+
+#include "engine.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Core {
+
+// Near-duplicate search over programs, to flag copied solutions. A program is normalized
+// first : the vacants and the jump targets are renamed in the order they are first used,
+// so renaming a vacant or moving the code doesn't hide a copy. The set of its n-grams of
+// normalized commands is summarized by a MinHash signature, the fraction of equal entries
+// of two signatures estimates the Jaccard similarity of the two sets.
+//
+// The signatures are split into bands, and two programs with an equal band share an LSH
+// bucket. A query only compares the programs in its buckets, and a pair with similarity s
+// shares some bucket with probability 1 - (1 - s^r)^b. For the b = 16 bands of r = 4 rows
+// here the curve is steep around (1 / b)^(1 / r) = 0.5, P(0.5) is about 0.64 and P(0.7)
+// about 0.99. So pairs well below the usual thresholds of 0.7 or 0.8 are candidates too,
+// they cost a comparison of signatures and are dropped by the threshold of the query,
+// while a pair above it is almost never missed.
+
+constexpr static int kMinHashSize = 64;
+constexpr static int kLshBands = 16;
+constexpr static int kLshRows = kMinHashSize / kLshBands;
+
+using MinHashSignature = std::array<std::uint32_t, kMinHashSize>;
+
+std::vector<std::uint32_t> normalizeProgram(const CommandList& cmd);
+MinHashSignature minHash(const CommandList& cmd, int ngram = 3);
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SimilarityIndex {
+  public:
+    void add(std::uint32_t id, const CommandList& cmd);
+    void addAll(const std::vector<std::pair<std::uint32_t, CommandList>>& programs, unsigned int threads = 0);
+    bool contains(std::uint32_t id) const { return signature_.count(id) != 0; }
+    std::size_t size() const { return signature_.size(); }
+
+    std::vector<std::pair<std::uint32_t, double>> query(const CommandList& cmd, double threshold) const;
+
+    bool save(const std::filesystem::path& path) const;
+    bool load(const std::filesystem::path& path);
+
+  private:
+    void insert(std::uint32_t id, const MinHashSignature& s);
+
+    std::unordered_map<std::uint32_t, MinHashSignature> signature_;
+    std::array<std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>, kLshBands> bucket_;
+};
+
+}
+
+#endif
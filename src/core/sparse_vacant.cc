@@ -0,0 +1,84 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `sparse_vacant.h`                                    //
+//======================================================//
+
+#include "sparse_vacant.h"
+
+#include <algorithm>
+#include <bit>
+
+/**
+ * @program:     Core::SparseVacant::reset
+ * @description: This function empties every tile, only the slots used are cleared
+ * @tiles:       The declared size of vacant
+ */
+template <class Value>
+void Core::SparseVacant<Value>::reset(int tiles) {
+    tiles_ = tiles;
+    for (std::uint32_t i : used_) keys_[i] = kFreeSlot;
+    used_.clear();
+}
+
+/**
+ * @program:     Core::SparseVacant::grow
+ * @description: This function doubles the table and puts the tiles again in the order
+ *               they were first put
+ */
+template <class Value>
+void Core::SparseVacant<Value>::grow() {
+    std::vector<int> keys(std::max<std::size_t>(keys_.size() * 2, 16), kFreeSlot);
+    std::vector<Value> values(keys.size());
+    std::vector<std::uint32_t> used;
+    used.reserve(keys.size() / 2);
+
+    mask_ = keys.size() - 1;
+    shift_ = 32 - std::countr_zero(keys.size());
+    for (std::uint32_t i : used_) {
+        std::size_t j = slot(keys_[i]);
+        while (keys[j] != kFreeSlot) j = (j + 1) & mask_;
+        keys[j] = keys_[i];
+        values[j] = values_[i];
+        used.push_back(j);
+    }
+    keys_ = std::move(keys);
+    values_ = std::move(values);
+    used_ = std::move(used);
+}
+
+/**
+ * @program:     Core::SparseVacant::sorted
+ * @description: This function lists the tiles put and their boxes in order of tile
+ */
+template <class Value>
+std::vector<std::pair<int, Value>> Core::SparseVacant<Value>::sorted() const {
+    std::vector<std::pair<int, Value>> tiles;
+    tiles.reserve(used_.size());
+    for (std::uint32_t i : used_) tiles.emplace_back(keys_[i], values_[i]);
+    std::sort(tiles.begin(), tiles.end());
+    return tiles;
+}
+
+/**
+ * @program:     Core::SparseVacant::operator==
+ * @description: This function compares the tiles, not the layout of tables, which depends
+ *               on the order the tiles were put
+ */
+template <class Value>
+bool Core::SparseVacant<Value>::operator==(const Core::SparseVacant<Value>& v) const {
+    if (tiles_ != v.tiles_ || used_.size() != v.used_.size()) return false;
+    for (std::uint32_t i : used_) {
+        const Value* box = v.find(keys_[i]);
+        if (box == nullptr || *box != values_[i]) return false;
+    }
+    return true;
+}
+
+template class Core::SparseVacant<std::int16_t>;
+template class Core::SparseVacant<int>;
+template class Core::SparseVacant<std::int64_t>;
@@ -0,0 +1,83 @@
+#ifndef SPARSE_VACANT_H
+#define SPARSE_VACANT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Core {
+
+// Vacant of levels too large to keep as an array, such as the generated levels which
+// address a few tiles far apart. The commands only address the tiles by their operands,
+// so a run touches a few of them however many the level declares. SparseVacant keeps the
+// tiles put in an open-addressing table with linear probing, a tile which isn't in it is
+// empty, and remembers the slots it used, so a reset costs the tiles put instead of the
+// declared size and keeps the table for the next run. Core::BasicMachine::reset picks it
+// for the levels of more than kDenseVacant tiles and the plain array for the others.
+
+constexpr static int kDenseVacant = 1 << 12;
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+template <class Value>
+class SparseVacant {
+  public:
+    int tiles() const { return tiles_; }                // Declared size, 0 when it's not used
+    std::size_t size() const { return used_.size(); }   // Tiles put
+
+    /**
+     * @program:     Core::SparseVacant::find
+     * @description: This function finds the box on the tile
+     * @return:      nullptr when the tile is empty
+     */
+    const Value* find(int x) const {
+        if (keys_.empty()) return nullptr;
+        for (std::size_t i = slot(x); ; i = (i + 1) & mask_) {
+            if (keys_[i] == x) return &values_[i];
+            if (keys_[i] == kFreeSlot) return nullptr;
+        }
+    }
+
+    /**
+     * @program:     Core::SparseVacant::put
+     * @description: This function puts the box on the tile, the table is at most half full
+     */
+    void put(int x, Value box) {
+        if ((used_.size() + 1) * 2 > keys_.size()) grow();
+        std::size_t i = slot(x);
+        while (keys_[i] != x && keys_[i] != kFreeSlot) i = (i + 1) & mask_;
+        if (keys_[i] == kFreeSlot) {
+            keys_[i] = x;
+            used_.push_back(i);
+        }
+        values_[i] = box;
+    }
+
+    void reset(int tiles);
+    std::vector<std::pair<int, Value>> sorted() const;
+    bool operator==(const SparseVacant& v) const;
+
+  private:
+    static constexpr int kFreeSlot = -1;    // The tiles are never negative
+
+    // Fibonacci hashing, the adjacent tiles of a level land far apart
+
+    std::size_t slot(int x) const {
+        return (static_cast<std::uint32_t>(x) * 0x9E3779B9u) >> shift_;
+    }
+    void grow();
+
+    int tiles_ = 0;
+    std::vector<int> keys_;             // Tile of every slot, or kFreeSlot
+    std::vector<Value> values_;
+    std::vector<std::uint32_t> used_;   // Slots used, in the order the tiles were first put
+    std::size_t mask_ = 0;
+    int shift_ = 32;
+};
+
+}
+
+#endif
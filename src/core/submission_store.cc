@@ -0,0 +1,440 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `submission_store.h`                                 //
+//======================================================//
+
+#include "submission_store.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kFileMagic[8] = { 'R', 'B', 'X', 'S', 'S', '0', '1', '\0' };
+constexpr int kOperandBits = 28;
+constexpr std::uint32_t kOperandMask = (1U << kOperandBits) - 1;
+constexpr std::uint32_t kNoCommand = ~0U;   // The command of the root
+
+/**
+ * FileHeader is the start of the store file. The arrays follow it in the order of the
+ * pointers in Core::SubmissionStore, every one of them starts at a multiple of 8 bytes
+ */
+struct FileHeader {
+    char magic_[8];
+    std::uint64_t levels_;
+    std::uint64_t nodes_;
+    std::uint64_t submissions_;
+    std::uint64_t hashes_;
+    std::uint64_t name_bytes_;
+};
+
+std::size_t align8(std::size_t n) {
+    return (n + 7) & ~static_cast<std::size_t>(7);
+}
+
+/**
+ * @program:     fileLayout
+ * @description: This function returns the offset of every array and the size of file
+ */
+std::array<std::size_t, 7> fileLayout(const FileHeader& h) {
+    std::array<std::size_t, 7> at;
+    at[0] = sizeof(FileHeader);
+    at[1] = at[0] + h.levels_ * 2 * sizeof(std::uint64_t);
+    at[2] = at[1] + align8((h.levels_ + 1) * sizeof(std::uint32_t));
+    at[3] = at[2] + h.nodes_ * 2 * sizeof(std::uint32_t);
+    at[4] = at[3] + h.submissions_ * sizeof(Core::StoredSubmission);
+    at[5] = at[4] + h.hashes_ * 2 * sizeof(std::uint64_t);
+    at[6] = at[5] + h.name_bytes_;
+    return at;
+}
+
+}
+
+/**
+ * @program:     Core::encodeCommand
+ * @description: This function packs the command to 4 bytes
+ * @return:      Nothing when the name is unknown or the operand doesn't fit
+ */
+std::optional<Core::StoredCommand> Core::encodeCommand(const std::string& name, int index) {
+    auto it = std::find(Core::Command::kAllCmd.begin(), Core::Command::kAllCmd.end(), name);
+    if (it == Core::Command::kAllCmd.end()) return std::nullopt;
+    if (index < -(1 << (kOperandBits - 1)) || index >= (1 << (kOperandBits - 1))) return std::nullopt;
+    const std::uint32_t op = it - Core::Command::kAllCmd.begin();
+    return (op << kOperandBits) | (static_cast<std::uint32_t>(index) & kOperandMask);
+}
+
+std::pair<std::string, int> Core::decodeCommand(Core::StoredCommand c) {
+    int index = static_cast<int>(c & kOperandMask);
+    if (index >= (1 << (kOperandBits - 1))) index -= 1 << kOperandBits;
+    return { Core::Command::kAllCmd[(c >> kOperandBits) & 7], index };
+}
+
+/**
+ * @program:     Core::programHash
+ * @description: This function hashes the commands, the same program gives the same hash
+ *               in every store
+ */
+std::uint64_t Core::programHash(const Core::CommandList& cmd) {
+    Core::ContentHash h;
+    h.add(cmd.size());
+    for (const auto& [name, index] : cmd) {
+        h.add(name);
+        h.add(static_cast<std::uint32_t>(index));
+    }
+    return h.h_[0];
+}
+
+Core::SubmissionStoreBuilder::SubmissionStoreBuilder() {
+    parent_.push_back(0);
+    command_.push_back(kNoCommand);
+}
+
+/**
+ * @program:     Core::SubmissionStoreBuilder::add
+ * @description: This function walks the trie along the commands, adding the nodes which
+ *               are missing, and records the submission
+ * @level:       Name of the level
+ * @cmd:         Commands, they are the pair of command name and vacant index
+ * @return:      FALSE when a command can't be encoded, nothing is added then
+ */
+bool Core::SubmissionStoreBuilder::add(const std::string& level, const Core::CommandList& cmd) {
+    std::vector<Core::StoredCommand> encoded;
+    encoded.reserve(cmd.size());
+    for (const auto& [name, index] : cmd) {
+        auto c = Core::encodeCommand(name, index);
+        if (!c) return false;
+        encoded.push_back(*c);
+    }
+
+    std::uint32_t node = 0;
+    for (Core::StoredCommand c : encoded) {
+        const std::uint64_t key = (static_cast<std::uint64_t>(node) << 32) | c;
+        auto [it, added] = child_.try_emplace(key, parent_.size());
+        if (added) {
+            parent_.push_back(node);
+            command_.push_back(c);
+        }
+        node = it->second;
+    }
+
+    auto [it, added] = level_index_.try_emplace(level, levels_.size());
+    if (added) levels_.push_back(level);
+    submissions_.push_back({ it->second, node });
+    programs_.try_emplace(node, Core::programHash(cmd));
+    return true;
+}
+
+/**
+ * @program:     Core::SubmissionStoreBuilder::save
+ * @description: This function writes the store file, the levels are sorted by name and the
+ *               submissions of a level keep the order they were added in
+ * @return:      FALSE when the file can't be written
+ */
+bool Core::SubmissionStoreBuilder::save(const std::filesystem::path& path) const {
+    std::vector<std::uint32_t> order(levels_.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](auto a, auto b) { return levels_[a] < levels_[b]; });
+    std::vector<std::uint32_t> rank(levels_.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) rank[order[i]] = i;
+
+    std::vector<Core::StoredSubmission> submissions = submissions_;
+    for (auto& s : submissions) s.level_ = rank[s.level_];
+    std::stable_sort(submissions.begin(), submissions.end(), [](const auto& a, const auto& b) {
+        return a.level_ < b.level_;
+    });
+
+    std::vector<std::uint64_t> names;
+    std::vector<std::uint32_t> begin(levels_.size() + 1, 0);
+    std::string blob;
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        names.push_back(blob.size());
+        names.push_back(levels_[order[i]].size());
+        blob += levels_[order[i]];
+    }
+    for (const auto& s : submissions) begin[s.level_ + 1]++;
+    for (std::size_t i = 1; i < begin.size(); ++i) begin[i] += begin[i - 1];
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> hashes(programs_.begin(), programs_.end());
+    for (auto& h : hashes) std::swap(h.first, h.second);
+    std::sort(hashes.begin(), hashes.end());
+
+    std::vector<std::uint32_t> nodes;
+    nodes.reserve(parent_.size() * 2);
+    for (std::size_t i = 0; i < parent_.size(); ++i) {
+        nodes.push_back(parent_[i]);
+        nodes.push_back(command_[i]);
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic_, kFileMagic, sizeof(kFileMagic));
+    header.levels_ = levels_.size();
+    header.nodes_ = parent_.size();
+    header.submissions_ = submissions.size();
+    header.hashes_ = hashes.size();
+    header.name_bytes_ = blob.size();
+
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary);
+        if (!file.is_open()) return false;
+        auto put = [&file](const void* data, std::size_t bytes) {
+            file.write(static_cast<const char*>(data), bytes);
+        };
+        const char zeros[8] = {};
+        put(&header, sizeof(header));
+        put(names.data(), names.size() * sizeof(std::uint64_t));
+        put(begin.data(), begin.size() * sizeof(std::uint32_t));
+        put(zeros, align8(begin.size() * sizeof(std::uint32_t)) - begin.size() * sizeof(std::uint32_t));
+        put(nodes.data(), nodes.size() * sizeof(std::uint32_t));
+        put(submissions.data(), submissions.size() * sizeof(Core::StoredSubmission));
+        put(hashes.data(), hashes.size() * sizeof(hashes[0]));
+        put(blob.data(), blob.size());
+        if (!file.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+Core::SubmissionStore::~SubmissionStore() {
+    release();
+}
+
+Core::SubmissionStore::SubmissionStore(Core::SubmissionStore&& s) noexcept {
+    *this = std::move(s);
+}
+
+Core::SubmissionStore& Core::SubmissionStore::operator=(Core::SubmissionStore&& s) noexcept {
+    if (this == &s) return *this;
+    release();
+    base_ = s.base_;
+    size_ = s.size_;
+    mapped_ = s.mapped_;
+    level_count_ = s.level_count_;
+    node_count_ = s.node_count_;
+    submission_count_ = s.submission_count_;
+    hash_count_ = s.hash_count_;
+    level_name_ = s.level_name_;
+    level_begin_ = s.level_begin_;
+    node_ = s.node_;
+    submission_ = s.submission_;
+    hash_ = s.hash_;
+    name_blob_ = s.name_blob_;
+    name_bytes_ = s.name_bytes_;
+
+    // The file is this store's now, s is only emptied
+
+    s.base_ = nullptr;
+    s.release();
+    return *this;
+}
+
+/**
+ * @program:     Core::SubmissionStore::release
+ * @description: This function unmaps or frees the file and empties the store, so a store
+ *               moved from has no submission instead of the arrays of another store
+ */
+void Core::SubmissionStore::release() {
+#ifdef __linux__
+    if (base_ != nullptr && mapped_) munmap(const_cast<unsigned char*>(base_), size_);
+    if (!mapped_) delete[] base_;
+#else
+    delete[] base_;
+#endif
+    base_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    level_count_ = 0;
+    node_count_ = 0;
+    submission_count_ = 0;
+    hash_count_ = 0;
+    level_name_ = nullptr;
+    level_begin_ = nullptr;
+    node_ = nullptr;
+    submission_ = nullptr;
+    hash_ = nullptr;
+    name_blob_ = nullptr;
+    name_bytes_ = 0;
+}
+
+/**
+ * @program:     Core::SubmissionStore::open
+ * @description: This function maps the store file, or reads it where mmap isn't available.
+ *               The sizes of the arrays are checked against the size of file, the contents
+ *               are checked when they are read
+ * @return:      The store, or the reason when the file is not a store
+ */
+std::expected<Core::SubmissionStore, std::string> Core::SubmissionStore::open(
+    const std::filesystem::path& path
+) {
+    Core::SubmissionStore s;
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return std::unexpected("Fail to open " + path.string());
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return std::unexpected("Fail to read " + path.string());
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return std::unexpected("Fail to map " + path.string());
+    s.base_ = static_cast<const unsigned char*>(map);
+    s.size_ = st.st_size;
+    s.mapped_ = true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return std::unexpected("Fail to open " + path.string());
+    s.size_ = file.tellg();
+    auto buffer = std::make_unique<unsigned char[]>(s.size_);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.get()), s.size_)) {
+        return std::unexpected("Fail to read " + path.string());
+    }
+    s.base_ = buffer.release();
+#endif
+
+    FileHeader header;
+    if (s.size_ < sizeof(header)) return std::unexpected("Not a submission store");
+    std::memcpy(&header, s.base_, sizeof(header));
+    if (std::memcmp(header.magic_, kFileMagic, sizeof(kFileMagic)) != 0) {
+        return std::unexpected("Not a submission store");
+    }
+    const std::uint64_t limit = s.size_;
+    if (header.levels_ > limit || header.nodes_ > limit || header.submissions_ > limit
+        || header.hashes_ > limit || header.name_bytes_ > limit || fileLayout(header)[6] != s.size_) {
+        return std::unexpected("Truncated submission store");
+    }
+
+    auto at = fileLayout(header);
+    s.level_count_ = header.levels_;
+    s.node_count_ = header.nodes_;
+    s.submission_count_ = header.submissions_;
+    s.hash_count_ = header.hashes_;
+    s.level_name_ = reinterpret_cast<const std::uint64_t*>(s.base_ + at[0]);
+    s.level_begin_ = reinterpret_cast<const std::uint32_t*>(s.base_ + at[1]);
+    s.node_ = reinterpret_cast<const std::uint32_t*>(s.base_ + at[2]);
+    s.submission_ = reinterpret_cast<const Core::StoredSubmission*>(s.base_ + at[3]);
+    s.hash_ = reinterpret_cast<const std::uint64_t*>(s.base_ + at[4]);
+    s.name_blob_ = reinterpret_cast<const char*>(s.base_ + at[5]);
+    s.name_bytes_ = header.name_bytes_;
+    return s;
+}
+
+/**
+ * @program:     Core::SubmissionStore::levelName
+ * @description: This function returns the name of level, a name out of the file is empty
+ */
+std::string Core::SubmissionStore::levelName(std::size_t level) const {
+    const std::uint64_t offset = level_name_[2 * level];
+    const std::uint64_t length = level_name_[2 * level + 1];
+    if (offset > name_bytes_ || length > name_bytes_ - offset) return "";
+    return std::string(name_blob_ + offset, length);
+}
+
+std::vector<std::string> Core::SubmissionStore::levels() const {
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < level_count_; ++i) names.push_back(levelName(i));
+    return names;
+}
+
+/**
+ * @program:     Core::SubmissionStore::program
+ * @description: This function walks from the node up to the root, a parent is always
+ *               before its child, so a broken file can't make it loop
+ * @node:        The node of a submission or of Core::SubmissionStore::byHash
+ */
+Core::CommandList Core::SubmissionStore::program(std::uint32_t node) const {
+    Core::CommandList cmd;
+    if (node >= node_count_) return cmd;
+    while (node != 0) {
+        cmd.push_back(Core::decodeCommand(node_[2 * node + 1]));
+        const std::uint32_t parent = node_[2 * node];
+        if (parent >= node) break;
+        node = parent;
+    }
+    std::reverse(cmd.begin(), cmd.end());
+    return cmd;
+}
+
+/**
+ * @program:     Core::SubmissionStore::byLevel
+ * @description: This function returns the submissions of the level in the order they were
+ *               added, the levels are sorted by name
+ */
+std::vector<Core::StoredSubmission> Core::SubmissionStore::byLevel(const std::string& level) const {
+    std::size_t low = 0, high = level_count_;
+    while (low < high) {
+        const std::size_t mid = (low + high) / 2;
+        if (levelName(mid) < level) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == level_count_ || levelName(low) != level) return {};
+
+    const std::uint32_t begin = level_begin_[low], end = level_begin_[low + 1];
+    if (begin > end || end > submission_count_) return {};
+    return std::vector<Core::StoredSubmission>(submission_ + begin, submission_ + end);
+}
+
+/**
+ * @program:     Core::SubmissionStore::byHash
+ * @description: This function returns the nodes of the programs with the hash, more than
+ *               one only when the hashes collide
+ */
+std::vector<std::uint32_t> Core::SubmissionStore::byHash(std::uint64_t hash) const {
+    std::size_t low = 0, high = hash_count_;
+    while (low < high) {
+        const std::size_t mid = (low + high) / 2;
+        if (hash_[2 * mid] < hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    std::vector<std::uint32_t> nodes;
+    for (std::size_t i = low; i < hash_count_ && hash_[2 * i] == hash; ++i) {
+        nodes.push_back(static_cast<std::uint32_t>(hash_[2 * i + 1]));
+    }
+    return nodes;
+}
+
+/**
+ * @program:     Core::SubmissionStore::find
+ * @description: This function returns the node of the program when it has been submitted
+ */
+std::vector<std::uint32_t> Core::SubmissionStore::find(const Core::CommandList& cmd) const {
+    std::vector<std::uint32_t> nodes = byHash(Core::programHash(cmd));
+    std::erase_if(nodes, [&](std::uint32_t node) { return program(node) != cmd; });
+    return nodes;
+}
+
+/**
+ * @program:     Core::SubmissionStore::programNodes
+ * @description: This function returns the nodes of all the programs submitted, once each
+ */
+std::vector<std::uint32_t> Core::SubmissionStore::programNodes() const {
+    std::vector<std::uint32_t> nodes;
+    nodes.reserve(hash_count_);
+    for (std::size_t i = 0; i < hash_count_; ++i) nodes.push_back(static_cast<std::uint32_t>(hash_[2 * i + 1]));
+    return nodes;
+}
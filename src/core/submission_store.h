@@ -0,0 +1,118 @@
+#ifndef SUBMISSION_STORE_H
+#define SUBMISSION_STORE_H
+
+#include "engine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Core {
+
+// Compact archive of submissions. A command is encoded in 4 bytes, the index of its name
+// in Command::kAllCmd in the high 4 bits and the operand in the low 28 bits, and the
+// programs are the paths of a trie of commands : a node is its parent and its command, so
+// the programs with a common prefix share it and a program submitted again is the same
+// node. A submission is the level and the node of its program, 8 bytes.
+//
+// The archive is built in memory by SubmissionStoreBuilder and saved to a file, which
+// SubmissionStore maps read only. The submissions in the file are grouped by level, and
+// the programs are indexed by Core::programHash, so both queries are binary searches. A
+// command whose name is unknown or whose operand doesn't fit 28 bits can't be archived.
+
+using StoredCommand = std::uint32_t;
+
+std::optional<StoredCommand> encodeCommand(const std::string& name, int index);
+std::pair<std::string, int> decodeCommand(StoredCommand c);
+std::uint64_t programHash(const CommandList& cmd);
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class StoredSubmission {
+  public:
+    std::uint32_t level_;   // Index of the level name
+    std::uint32_t node_;    // The last node of the program, 0 is the empty program
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SubmissionStoreBuilder {
+  public:
+    SubmissionStoreBuilder();
+
+    bool add(const std::string& level, const CommandList& cmd);
+    bool save(const std::filesystem::path& path) const;
+
+    std::size_t submissions() const { return submissions_.size(); }
+    std::size_t nodes() const { return parent_.size(); }
+
+  private:
+    std::vector<std::uint32_t> parent_;
+    std::vector<StoredCommand> command_;
+    std::unordered_map<std::uint64_t, std::uint32_t> child_;    // (parent, command) to node
+    std::unordered_map<std::string, std::uint32_t> level_index_;
+    std::vector<std::string> levels_;
+    std::vector<StoredSubmission> submissions_;
+    std::unordered_map<std::uint32_t, std::uint64_t> programs_; // Node to hash, when submitted
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SubmissionStore {
+  public:
+    SubmissionStore() = default;
+    ~SubmissionStore();
+    SubmissionStore(SubmissionStore&& s) noexcept;
+    SubmissionStore& operator=(SubmissionStore&& s) noexcept;
+    SubmissionStore(const SubmissionStore&) = delete;
+    SubmissionStore& operator=(const SubmissionStore&) = delete;
+
+    static std::expected<SubmissionStore, std::string> open(const std::filesystem::path& path);
+
+    std::size_t submissions() const { return submission_count_; }
+    std::size_t programs() const { return hash_count_; }
+    std::size_t nodes() const { return node_count_; }
+    std::size_t bytes() const { return size_; }
+    std::vector<std::string> levels() const;
+
+    CommandList program(std::uint32_t node) const;
+    std::vector<StoredSubmission> byLevel(const std::string& level) const;
+    std::vector<std::uint32_t> byHash(std::uint64_t hash) const;
+    std::vector<std::uint32_t> find(const CommandList& cmd) const;
+    std::vector<std::uint32_t> programNodes() const;
+
+  private:
+    void release();
+    std::string levelName(std::size_t level) const;
+
+    const unsigned char* base_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;       // Otherwise base_ is owned by new[]
+
+    std::size_t level_count_ = 0;
+    std::size_t node_count_ = 0;
+    std::size_t submission_count_ = 0;
+    std::size_t hash_count_ = 0;
+    const std::uint64_t* level_name_ = nullptr;     // Offset and length of every level name
+    const std::uint32_t* level_begin_ = nullptr;    // First submission of every level, and the end
+    const std::uint32_t* node_ = nullptr;           // Parent and command of every node
+    const StoredSubmission* submission_ = nullptr;
+    const std::uint64_t* hash_ = nullptr;           // Hash and node of every program, sorted
+    const char* name_blob_ = nullptr;
+    std::size_t name_bytes_ = 0;
+};
+
+}
+
+#endif
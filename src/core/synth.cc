@@ -0,0 +1,535 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `synth.h`                                            //
+//======================================================//
+
+#include "synth.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+enum PrefixOutcome {
+    kPrefixPruned,  // Every list with the prefix fails some test
+    kPrefixOpen,    // Some test reaches a line which is not chosen yet
+    kPrefixSolved   // Every test succeeds without the lines not chosen
+};
+
+/**
+ * SynthSearch is the lists of one size, the tasks are their first lines
+ *
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SynthSearch {
+  public:
+    const std::vector<Core::Level>* tests_;
+    std::vector<Core::Instruction> alphabet_;   // Every command which may be on a line
+    unsigned int size_;
+    int vac_size_;
+    unsigned long long step_limit_;
+    std::atomic<unsigned long long> candidates_ = 0;
+};
+
+/**
+ * @program:     runPrefix
+ * @description: This function runs the first filled lines of code on every test. The
+ *               commands come from the alphabet, so only the checks on the state remain,
+ *               in the same order as Core::runDecoded
+ */
+static PrefixOutcome runPrefix(
+    SynthSearch& s,
+    const std::vector<Core::Instruction>& code,
+    unsigned int filled,
+    Core::Machine& m
+) {
+    s.candidates_.fetch_add(1, std::memory_order_relaxed);
+    const unsigned int size = s.size_;
+    bool open = false;
+
+    for (const Core::Level& t : *s.tests_) {
+        m.reset(s.vac_size_);
+        bool reached = false;
+
+        while (true) {
+            if (s.step_limit_ != 0 && m.steps_ >= s.step_limit_) return kPrefixPruned;
+            if (m.ref_ == size + 1) break;
+            const unsigned int line = m.ref_ - 1;
+            if (line >= filled) {
+                reached = true;
+                break;
+            }
+
+            const Core::Instruction& ins = code[line];
+            const int x = ins.operand_;
+            switch (ins.op_) {
+            case Core::Opcode::kInbox :
+                if (m.input_pos_ == t.provided_seq_.size()) goto finish;
+                m.handbox_ = static_cast<int>(t.provided_seq_[m.input_pos_++]);
+                m.handbox_empty_ = false;
+                m.ref_++;
+                break;
+            case Core::Opcode::kOutbox :
+                if (m.handbox_empty_) return kPrefixPruned;
+                if (m.output_.size() == t.needed_seq_.size()) return kPrefixPruned;
+                if (t.needed_seq_[m.output_.size()] != m.handbox_) return kPrefixPruned;
+                m.output_.push_back(m.handbox_);
+                m.handbox_ = Core::Robot::kEmptyHandbox;
+                m.handbox_empty_ = true;
+                m.ref_++;
+                break;
+            case Core::Opcode::kAdd :
+            case Core::Opcode::kSub :
+                if (m.handbox_empty_ || m.vacant_empty_[x]) return kPrefixPruned;
+                m.handbox_ = (ins.op_ == Core::Opcode::kAdd)
+                           ? m.handbox_ + m.vacant_[x]
+                           : m.handbox_ - m.vacant_[x];
+                m.ref_++;
+                break;
+            case Core::Opcode::kCopyto :
+                if (m.handbox_empty_) return kPrefixPruned;
+                m.vacant_[x] = m.handbox_;
+                m.vacant_empty_[x] = false;
+                m.ref_++;
+                break;
+            case Core::Opcode::kCopyfrom :
+                if (m.vacant_empty_[x]) return kPrefixPruned;
+                m.handbox_ = m.vacant_[x];
+                m.handbox_empty_ = false;
+                m.ref_++;
+                break;
+            case Core::Opcode::kJump :
+                m.ref_ = x;
+                break;
+            case Core::Opcode::kJumpifzero :
+                if (m.handbox_ == 0) {
+                    if (m.handbox_empty_) return kPrefixPruned;
+                    m.ref_ = x;
+                } else {
+                    m.ref_++;
+                }
+                break;
+            }
+            m.steps_++;
+        }
+
+    finish:
+        if (reached) {
+            open = true;
+            continue;
+        }
+        if (m.output_.size() != t.needed_seq_.size()) return kPrefixPruned;
+    }
+
+    // A test which ends before the lines not chosen ends the same whatever they are, and
+    // the outputs are compared box by box, so a wrong box fails at once
+
+    return open ? kPrefixOpen : kPrefixSolved;
+}
+
+/**
+ * @program:     allowed
+ * @description: This function breaks the symmetries of the lists. A vacant is only used
+ *               after all the vacants before it, and a jump never goes to itself or to the
+ *               next line, a program with such a line has a shorter equivalent one
+ * @line:        The line of ins, counts from 0
+ * @vacants:     Count of the vacants used before the line
+ */
+static bool allowed(const Core::Instruction& ins, unsigned int line, int vacants) {
+    if (ins.op_ >= Core::Opcode::kJump) {
+        const unsigned int target = ins.operand_;
+        return target != line + 1 && target != line + 2;
+    }
+    if (ins.operand_ == Core::Command::SingleCommand::kNullVacant) return true;
+    return ins.operand_ <= vacants;
+}
+
+/**
+ * @program:     vacantsAfter
+ * @description: This function returns the count of the vacants used after ins
+ */
+static int vacantsAfter(const Core::Instruction& ins, int vacants) {
+    if (ins.op_ >= Core::Opcode::kJump) return vacants;
+    if (ins.operand_ == Core::Command::SingleCommand::kNullVacant) return vacants;
+    return std::max(vacants, ins.operand_ + 1);
+}
+
+/**
+ * @program:     extend
+ * @description: This function chooses the lines from filled on in depth first order, and
+ *               calls found with the first complete list which solves every test, or
+ *               stops at depth and calls found with every open prefix of that length
+ * @return:      TRUE when found returns TRUE, which stops the search as stop does
+ */
+template <typename Stop, typename Found>
+static bool extend(
+    SynthSearch& s,
+    std::vector<Core::Instruction>& code,
+    unsigned int filled,
+    int vacants,
+    unsigned int depth,
+    Core::Machine& m,
+    Stop&& stop,
+    Found&& found
+) {
+    for (const Core::Instruction& ins : s.alphabet_) {
+        if (stop()) return false;
+        if (!allowed(ins, filled, vacants)) continue;
+        code[filled] = ins;
+
+        PrefixOutcome outcome = runPrefix(s, code, filled + 1, m);
+        if (outcome == kPrefixPruned) continue;
+
+        // A prefix which solves all the tests would be a solution of a smaller size,
+        // which has been searched already
+
+        if (outcome == kPrefixSolved) {
+            if (filled + 1 == s.size_ && found(code)) return true;
+            continue;
+        }
+        if (filled + 1 == depth) {
+            if (found(code)) return true;
+            continue;
+        }
+        if (extend(s, code, filled + 1, vacantsAfter(ins, vacants), depth, m, stop, found)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * SynthCheckpoint is the state of a search saved between runs. The finished tasks are the
+ * indices of the prefixes of depth lines, so a resumed search must split the tasks at the
+ * same depth, and it must search the same lists
+ *
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SynthCheckpoint {
+  public:
+    unsigned int size_ = 1;
+    unsigned int depth_ = 0;                    // 0 means no task of the size is finished
+    Core::ContentHash search_;                  // The tests, commands, vacant size and step limit
+    unsigned long long candidates_ = 0;
+    std::vector<std::size_t> done_;
+};
+
+/**
+ * @program:     searchHash
+ * @description: This function hashes everything which decides the lists searched and their
+ *               order, a checkpoint of another search is never resumed
+ */
+static Core::ContentHash searchHash(
+    const std::vector<Core::Level>& tests,
+    const std::vector<Core::Opcode>& ops,
+    unsigned long long step_limit
+) {
+    Core::ContentHash h;
+    h.add(ops.size());
+    for (Core::Opcode op : ops) h.add(op);
+    h.add(static_cast<std::uint32_t>(tests[0].vac_size_));
+    h.add(step_limit);
+    h.add(tests.size());
+    for (const Core::Level& t : tests) {
+        h.add(t.provided_seq_);
+        h.add(t.needed_seq_);
+    }
+    return h;
+}
+
+/**
+ * @program:     readCheckpoint
+ * @description: This function reads a checkpoint, a missing file is a search from the start
+ * @return:      FALSE when the file is broken
+ */
+static bool readCheckpoint(const std::filesystem::path& path, SynthCheckpoint& c) {
+    std::ifstream file(path);
+    if (!file.is_open()) return true;
+
+    std::string magic, key;
+    file >> magic >> key >> c.size_;
+    if (magic != "robox-synth-2" || key != "size" || !file) return false;
+    file >> key >> c.depth_;
+    if (key != "depth" || !file || c.depth_ > c.size_) return false;
+    file >> key >> std::hex >> c.search_.h_[0] >> c.search_.h_[1] >> std::dec;
+    if (key != "search" || !file) return false;
+    file >> key >> c.candidates_;
+    if (key != "candidates" || !file) return false;
+    file >> key;
+    if (key != "done") return false;
+    for (std::size_t task; file >> task; ) c.done_.push_back(task);
+    return file.eof() && (c.depth_ != 0 || c.done_.empty());
+}
+
+/**
+ * @program:     writeCheckpoint
+ * @description: This function writes the checkpoint to a temporary file and renames it,
+ *               so a search killed while writing still has the last checkpoint
+ * @done:        The flags of the tasks, the indices of the set ones are written
+ */
+static bool writeCheckpoint(
+    const std::filesystem::path& path,
+    const SynthCheckpoint& c,
+    const std::vector<unsigned char>& done
+) {
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp);
+        if (!file.is_open()) return false;
+        file << "robox-synth-2\nsize " << c.size_ << "\ndepth " << c.depth_
+             << "\nsearch " << std::hex << c.search_.h_[0] << ' ' << c.search_.h_[1] << std::dec
+             << "\ncandidates " << c.candidates_ << "\ndone";
+        for (std::size_t i = 0; i < done.size(); ++i) {
+            if (done[i]) file << ' ' << i;
+        }
+        file << '\n';
+        if (!file.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class TaskQueue {
+  public:
+    explicit TaskQueue(unsigned int threads) : queue_(threads), lock_(threads) {}
+
+    void push(unsigned int thread, std::size_t task) {
+        queue_[thread].push_back(task);
+    }
+
+    /**
+     * @program:     TaskQueue::pop
+     * @description: This function takes the first task of the own queue, or steals the last
+     *               task of another queue, so the early tasks are done first everywhere
+     */
+    bool pop(unsigned int thread, std::size_t& task) {
+        {
+            std::lock_guard<std::mutex> guard(lock_[thread]);
+            if (!queue_[thread].empty()) {
+                task = queue_[thread].front();
+                queue_[thread].pop_front();
+                return true;
+            }
+        }
+        for (unsigned int i = 1; i < queue_.size(); ++i) {
+            const unsigned int victim = (thread + i) % queue_.size();
+            std::lock_guard<std::mutex> guard(lock_[victim]);
+            if (!queue_[victim].empty()) {
+                task = queue_[victim].back();
+                queue_[victim].pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    std::vector<std::deque<std::size_t>> queue_;
+    std::vector<std::mutex> lock_;
+};
+
+/**
+ * @program:     Core::synthesize
+ * @description: This function searches the shortest command list which succeeds on every
+ *               test, see `synth.h`. The lists of every size are searched in the same order,
+ *               and the first solution in that order is returned, whatever the threads are
+ * @tests:       The levels, they must have the same available commands and vacant size
+ * @options:     The bound of search, the threads and the checkpoint
+ * @return:      The result, or the reason when the tests or the checkpoint are bad
+ */
+std::expected<Core::SynthResult, std::string> Core::synthesize(
+    const std::vector<Core::Level>& tests,
+    const Core::SynthOptions& options
+) {
+    if (tests.empty()) return std::unexpected("No test is given");
+    for (const Core::Level& t : tests) {
+        if (t.available_cmd_ != tests[0].available_cmd_ || t.vac_size_ != tests[0].vac_size_) {
+            return std::unexpected("The tests have different commands or vacant size");
+        }
+    }
+    if (tests[0].vac_size_ > Core::kDenseVacant) {
+        return std::unexpected("The vacant of tests is too large to search");
+    }
+
+    std::vector<Core::Opcode> ops;
+    for (const std::string& name : tests[0].available_cmd_) {
+        auto it = std::find(Core::Command::kAllCmd.begin(), Core::Command::kAllCmd.end(), name);
+        if (it == Core::Command::kAllCmd.end()) return std::unexpected("Unknown command " + name);
+        auto op = static_cast<Core::Opcode>(it - Core::Command::kAllCmd.begin());
+        if (std::find(ops.begin(), ops.end(), op) == ops.end()) ops.push_back(op);
+    }
+    std::sort(ops.begin(), ops.end());
+
+    unsigned int threads = options.threads_ != 0 ? options.threads_ : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1U);
+
+    Core::SynthResult result;
+    SynthCheckpoint resumed;
+    const Core::ContentHash search = searchHash(tests, ops, options.step_limit_);
+    resumed.search_ = search;
+    if (!options.checkpoint_.empty()) {
+        if (!readCheckpoint(options.checkpoint_, resumed)) {
+            return std::unexpected("Broken checkpoint " + options.checkpoint_.string());
+        }
+        if (resumed.search_.h_[0] != search.h_[0] || resumed.search_.h_[1] != search.h_[1]) {
+            return std::unexpected("The checkpoint " + options.checkpoint_.string() + " is of another search");
+        }
+        resumed.size_ = std::max(resumed.size_, 1U);
+        result.candidates_ = resumed.candidates_;
+    }
+
+    for (unsigned int size = resumed.size_; size <= options.max_size_; ++size) {
+        SynthSearch s;
+        s.tests_ = &tests;
+        s.size_ = size;
+        s.vac_size_ = std::max(tests[0].vac_size_, 0);
+        s.step_limit_ = options.step_limit_;
+        for (Core::Opcode op : ops) {
+            if (op <= Core::Opcode::kOutbox) {
+                s.alphabet_.push_back({ op, Core::Command::SingleCommand::kNullVacant });
+            } else if (op <= Core::Opcode::kCopyfrom) {
+                for (int x = 0; x < s.vac_size_; ++x) s.alphabet_.push_back({ op, x });
+            } else {
+                for (int x = 1; x <= static_cast<int>(size); ++x) s.alphabet_.push_back({ op, x });
+            }
+        }
+        result.size_ = size;
+
+        // The tasks are the open prefixes of depth lines, enough of them to keep every
+        // thread busy. They are found in the same order as the search, so the index of
+        // a task is the order of its solutions. A resumed size keeps the depth of the
+        // checkpoint, whatever the threads are now
+
+        unsigned int depth = 1;
+        unsigned long long estimate = s.alphabet_.size();
+        while (depth < size && estimate < 64ULL * threads) {
+            depth++;
+            estimate *= s.alphabet_.size();
+        }
+        if (size == resumed.size_ && resumed.depth_ != 0) depth = resumed.depth_;
+        std::vector<std::vector<Core::Instruction>> tasks;
+        std::optional<std::vector<Core::Instruction>> solved;
+        {
+            std::vector<Core::Instruction> code(size);
+            Core::Machine m;
+            auto never = []() { return false; };
+            extend(s, code, 0, 0, depth, m, never, [&](const std::vector<Core::Instruction>& c) {
+                if (depth == size) {
+                    solved = c;
+                    return true;
+                }
+                tasks.push_back(c);
+                return false;
+            });
+        }
+
+        std::vector<unsigned char> done(tasks.size(), false);
+        for (std::size_t task : resumed.done_) {
+            if (task >= done.size()) return std::unexpected("The checkpoint doesn't match the tests");
+            done[task] = true;
+        }
+        resumed.done_.clear();
+
+        // Every task keeps its first solution, a task after the earliest solved one can't
+        // change the result, so it's skipped
+
+        std::vector<std::optional<std::vector<Core::Instruction>>> found(tasks.size());
+        std::atomic<std::size_t> earliest = tasks.size();
+        std::mutex done_lock;
+        std::condition_variable finished;
+        unsigned int running = threads;
+        TaskQueue queue(threads);
+        for (std::size_t i = 0, n = 0; i < tasks.size(); ++i) {
+            if (!done[i]) queue.push(n++ % threads, i);
+        }
+
+        auto work = [&](unsigned int thread) {
+            std::vector<Core::Instruction> code;
+            Core::Machine m;
+            std::size_t task;
+            while (queue.pop(thread, task)) {
+                auto later = [&earliest, task]() { return earliest.load(std::memory_order_relaxed) < task; };
+                if (later()) continue;
+                code = tasks[task];
+                int vacants = 0;
+                for (unsigned int line = 0; line < depth; ++line) vacants = vacantsAfter(code[line], vacants);
+                extend(s, code, depth, vacants, size, m, later, [&](const std::vector<Core::Instruction>& c) {
+                    found[task] = c;
+                    return true;
+                });
+                if (later()) continue;
+
+                // A solved task isn't done for the checkpoint, the solution is found again
+                // after resuming
+
+                std::lock_guard<std::mutex> guard(done_lock);
+                if (!found[task]) {
+                    done[task] = true;
+                    continue;
+                }
+                std::size_t e = earliest.load();
+                while (task < e && !earliest.compare_exchange_weak(e, task)) {}
+            }
+            std::lock_guard<std::mutex> guard(done_lock);
+            running--;
+            finished.notify_all();
+        };
+
+        if (!solved) {
+            std::vector<std::thread> pool;
+            for (unsigned int t = 0; t < threads; ++t) pool.emplace_back(work, t);
+            {
+                std::unique_lock<std::mutex> guard(done_lock);
+                const auto period = std::chrono::seconds(std::max(options.checkpoint_seconds_, 1U));
+                while (!finished.wait_for(guard, period, [&running]() { return running == 0; })) {
+                    if (options.checkpoint_.empty()) continue;
+                    SynthCheckpoint c{ size, depth, search, result.candidates_ + s.candidates_, {} };
+                    writeCheckpoint(options.checkpoint_, c, done);
+                }
+            }
+            for (auto& t : pool) t.join();
+            if (earliest < tasks.size()) solved = found[earliest];
+        }
+        result.candidates_ += s.candidates_;
+
+        if (solved) {
+            result.program_ = Core::encodeProgram(*solved);
+            break;
+        }
+        if (!options.checkpoint_.empty()) {
+            SynthCheckpoint c{ size + 1, 0, search, result.candidates_, {} };
+            writeCheckpoint(options.checkpoint_, c, {});
+        }
+    }
+
+    // Every solution is checked by the decoded engine, the search only runs the subset of
+    // the semantics which its commands can reach
+
+    if (result.program_) {
+        for (const Core::Level& t : tests) {
+            auto run = Core::runEngine(Core::EngineKind::kDecodedEngine, t, *result.program_, options.step_limit_);
+            if (!run.verdict_ || *run.verdict_ != Core::Verdict::kSuccess) {
+                return std::unexpected("The solution found fails a test, it's a bug of the search");
+            }
+        }
+    }
+    return result;
+}
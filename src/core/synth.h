@@ -0,0 +1,58 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include "engine.h"
+
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+// Superoptimization of the size score. The command lists over the available commands of a
+// level are enumerated in increasing size, line by line, and a partial list is run on every
+// test before the rest is chosen : a run which fails, puts a wrong box to the output or
+// ends before reaching an unchosen line is decided already, so the lists with that prefix
+// are skipped. Besides, lists which only differ in the names of vacants, and `jump` to the
+// next line or to itself, are never chosen.
+//
+// The prefixes of a few lines are the tasks of threads, which take them from their own
+// queue and steal from the others when it's empty. The finished tasks of the current size
+// can be saved to a checkpoint file, so a long search resumes where it stopped. The file
+// keeps the length of the prefixes and a hash of the search, so it's resumed with any count
+// of threads, and never by the search of another puzzle.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SynthOptions {
+  public:
+    unsigned int max_size_ = 8;
+    unsigned long long step_limit_ = 10000;     // A longer run is an error
+    unsigned int threads_ = 0;                  // 0 means one per core
+    std::filesystem::path checkpoint_;          // Empty means no checkpoint
+    unsigned int checkpoint_seconds_ = 10;
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class SynthResult {
+  public:
+    std::optional<CommandList> program_;        // The first shortest program, if any
+    unsigned int size_ = 0;                     // The last size searched
+    unsigned long long candidates_ = 0;         // Partial and complete lists which were run
+};
+
+std::expected<SynthResult, std::string> synthesize(
+    const std::vector<Level>& tests,
+    const SynthOptions& options
+);
+
+}
+
+#endif
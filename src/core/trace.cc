@@ -0,0 +1,133 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file `trace.h`  //
+//======================================================//
+
+#include "trace.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name_;
+    const char* category_;
+    double ts_us_;      // Microseconds since startTrace
+    double dur_us_;
+};
+
+// Every thread appends to its own buffer, the lock is only taken against stopTrace,
+// so it's never contended while the trace is running
+
+struct ThreadBuffer {
+    int tid_;
+    std::mutex mutex_;
+    std::vector<TraceEvent> events_;
+};
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+std::filesystem::path trace_path;
+int next_tid = 1;
+
+// The start of trace is read by every thread which records a span, and written by
+// startTrace while they may still record, so it's atomic, in ticks of steady_clock
+
+std::atomic<std::chrono::steady_clock::rep> trace_begin = 0;
+
+ThreadBuffer& threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto b = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        b->tid_ = next_tid++;
+        registry.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+}
+
+/**
+ * @program:     Core::startTrace
+ * @description: This function starts recording spans, the old events are dropped
+ * @path:        The JSON file which stopTrace writes
+ */
+void Core::startTrace(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& b : registry) {
+        std::lock_guard<std::mutex> buffer_lock(b->mutex_);
+        b->events_.clear();
+    }
+    trace_path = path;
+    trace_begin.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    Core::trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @program:     Core::recordSpan
+ * @description: This function appends a complete event to the buffer of current thread
+ */
+void Core::recordSpan(
+    const char* name,
+    const char* category,
+    std::chrono::steady_clock::time_point begin,
+    std::chrono::steady_clock::time_point end
+) {
+    const std::chrono::steady_clock::time_point start{
+        std::chrono::steady_clock::duration(trace_begin.load(std::memory_order_relaxed))
+    };
+    ThreadBuffer& b = threadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex_);
+    b.events_.push_back({
+        name,
+        category,
+        std::chrono::duration<double, std::micro>(begin - start).count(),
+        std::chrono::duration<double, std::micro>(end - begin).count()
+    });
+}
+
+/**
+ * @program:     Core::stopTrace
+ * @description: This function stops recording and writes all the events as Chrome
+ *               trace-event JSON, every thread is a track named by its trace ID
+ */
+bool Core::stopTrace() {
+    Core::trace_enabled.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::ofstream file(trace_path);
+    if (!file.is_open()) return false;
+
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    auto separator = [&first, &file]() {
+        file << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    for (auto& b : registry) {
+        std::lock_guard<std::mutex> buffer_lock(b->mutex_);
+        separator();
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << b->tid_
+             << ", \"args\": {\"name\": \"thread " << b->tid_ << "\"}}";
+        for (const auto& e : b->events_) {
+            separator();
+            file << "{\"name\": \"" << e.name_ << "\", \"cat\": \"" << e.category_
+                 << "\", \"ph\": \"X\", \"ts\": " << e.ts_us_ << ", \"dur\": " << e.dur_us_
+                 << ", \"pid\": 1, \"tid\": " << b->tid_ << "}";
+        }
+        b->events_.clear();
+    }
+    file << "\n]}\n";
+    return file.good();
+}
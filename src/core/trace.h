@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+namespace Core {
+
+// Timeline of load, run, verify, log and render, written as Chrome trace-event JSON which
+// can be opened by Perfetto (ui.perfetto.dev) or chrome://tracing. When the trace is not
+// started, a TraceSpan is one relaxed load of `trace_enabled`.
+
+inline std::atomic<bool> trace_enabled = false;
+
+void startTrace(const std::filesystem::path& path);
+bool stopTrace();   // Writes the file, FALSE when it can't be written
+
+void recordSpan(
+    const char* name,
+    const char* category,
+    std::chrono::steady_clock::time_point begin,
+    std::chrono::steady_clock::time_point end
+);
+
+/**
+ * TraceSpan records the time between its construction and destruction. The name and
+ * category must be string literals, they are kept as pointers until stopTrace.
+ *
+ * @author: AshGrey
+ * @date:   2024-12-25
+ */
+class TraceSpan {
+  public:
+    TraceSpan(const char* name, const char* category)
+        : name_( name )
+        , category_( category )
+        , enabled_( trace_enabled.load(std::memory_order_relaxed) ) {
+        if (enabled_) begin_ = std::chrono::steady_clock::now();
+    }
+
+    ~TraceSpan() {
+        if (enabled_) recordSpan(name_, category_, begin_, std::chrono::steady_clock::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* name_;
+    const char* category_;
+    bool enabled_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
+}
+
+#endif
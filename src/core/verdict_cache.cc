@@ -0,0 +1,317 @@
+//======================================================//
+// Copyright (c) 2024 AshGrey. All rights reserved.     //
+// Released under MIT license as described in the file  //
+// LICENSE.                                             //
+// Author: AshGrey (Grey He)                            //
+//                                                      //
+// This file is the implement of header file            //
+// `verdict_cache.h`                                    //
+//======================================================//
+
+#include "verdict_cache.h"
+#include "content_hash.h"
+#include "metrics.h"
+#include "program_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kFileMagic[8] = { 'R', 'B', 'X', 'V', 'C', '0', '1', '\0' };
+
+/**
+ * FileHeader is the start of the cache file, the slots follow it
+ */
+struct FileHeader {
+    char magic_[8];
+    std::uint64_t slots_;
+};
+
+/**
+ * FileSlot is one entry of the cache file, kind_ is 0 for an empty slot, and 1 + Verdict
+ * or 3 for an error
+ */
+struct FileSlot {
+    std::uint64_t key_[2];
+    std::uint32_t kind_;
+    std::uint32_t code_;
+    std::uint32_t instruction_;
+    std::int32_t operand_;
+    std::uint64_t steps_;
+    std::uint64_t check_;
+};
+
+std::uint64_t slotCheck(const FileSlot& s) {
+    Core::ContentHash h;
+    h.add(s.key_[0]);
+    h.add(s.key_[1]);
+    h.add((static_cast<std::uint64_t>(s.code_) << 32) | s.kind_);
+    h.add((static_cast<std::uint64_t>(static_cast<std::uint32_t>(s.operand_)) << 32) | s.instruction_);
+    h.add(s.steps_);
+    return h.h_[0] | 1;
+}
+
+}
+
+/**
+ * @program:     Core::verdictKey
+ * @description: This function hashes everything which decides the verdict. The available
+ *               commands are sorted, their order doesn't matter
+ * @p:           The decoded program
+ * @level:       The level
+ * @step_limit:  The step limit of run
+ */
+Core::VerdictKey Core::verdictKey(
+    const Core::Program& p,
+    const Core::Level& level,
+    unsigned long long step_limit
+) {
+    Core::ContentHash h;
+    h.add(p.code_.size());
+    for (const Core::Instruction& ins : p.code_) {
+        h.add((static_cast<std::uint64_t>(ins.op_) << 32) | static_cast<std::uint32_t>(ins.operand_));
+    }
+
+    std::vector<std::string> available = level.available_cmd_;
+    std::sort(available.begin(), available.end());
+    h.add(available.size());
+    for (const std::string& name : available) h.add(name);
+    h.add(level.provided_seq_);
+    h.add(level.needed_seq_);
+    h.add((static_cast<std::uint64_t>(level.value_kind_) << 32) | static_cast<std::uint32_t>(level.vac_size_));
+
+    // kValue32 is 0, so the keys of levels without a value type didn't change
+
+    h.add(step_limit);
+    return Core::VerdictKey{ { h.h_[0], h.h_[1] } };
+}
+
+Core::VerdictCache::VerdictCache(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+/**
+ * @program:     Core::VerdictCache::find
+ * @description: This function looks up the memory and then the file, a hit in the file is
+ *               remembered in memory too
+ */
+std::optional<Core::CachedVerdict> Core::VerdictCache::find(const Core::VerdictKey& key) {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        Core::addMetric(Core::MetricCounter::kMetricCacheHit);
+        return it->second->second;
+    }
+
+    if (map_ != nullptr) {
+        FileSlot slot;
+        std::memcpy(&slot, map_ + sizeof(FileHeader) + key.hash_[0] % slots_ * sizeof(FileSlot), sizeof(slot));
+        const bool same = slot.key_[0] == key.hash_[0] && slot.key_[1] == key.hash_[1];
+        if (same && slot.kind_ != 0 && slot.check_ == slotCheck(slot)) {
+            Core::CachedVerdict value;
+            if (slot.kind_ == 3) {
+                value.verdict_ = std::unexpected(Core::Diagnostic{
+                    static_cast<Core::DiagnosticCode>(slot.code_), slot.instruction_, slot.operand_
+                });
+            } else {
+                value.verdict_ = static_cast<Core::Verdict>(slot.kind_ - 1);
+            }
+            value.steps_ = slot.steps_;
+            remember(key, value);
+            Core::addMetric(Core::MetricCounter::kMetricCacheHit);
+            return value;
+        }
+    }
+    Core::addMetric(Core::MetricCounter::kMetricCacheMiss);
+    return std::nullopt;
+}
+
+/**
+ * @program:     Core::VerdictCache::insert
+ * @description: This function puts the verdict to the memory and the file
+ */
+void Core::VerdictCache::insert(const Core::VerdictKey& key, const Core::CachedVerdict& value) {
+    std::lock_guard<std::mutex> guard(lock_);
+    remember(key, value);
+    if (map_ == nullptr) return;
+
+    FileSlot slot = {};
+    slot.key_[0] = key.hash_[0];
+    slot.key_[1] = key.hash_[1];
+    if (value.verdict_) {
+        slot.kind_ = 1 + *value.verdict_;
+    } else {
+        slot.kind_ = 3;
+        slot.code_ = value.verdict_.error().code_;
+        slot.instruction_ = value.verdict_.error().instruction_;
+        slot.operand_ = value.verdict_.error().operand_;
+    }
+    slot.steps_ = value.steps_;
+    slot.check_ = slotCheck(slot);
+    std::memcpy(map_ + sizeof(FileHeader) + key.hash_[0] % slots_ * sizeof(FileSlot), &slot, sizeof(slot));
+}
+
+std::size_t Core::VerdictCache::size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return lru_.size();
+}
+
+/**
+ * @program:     Core::VerdictCache::remember
+ * @description: This function puts the verdict to the front of the LRU list and drops the
+ *               last one when it's full, the lock must be held
+ */
+void Core::VerdictCache::remember(const Core::VerdictKey& key, const Core::CachedVerdict& value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = value;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(key, value);
+    index_[key] = lru_.begin();
+    if (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+#ifdef __linux__
+
+Core::VerdictCache::~VerdictCache() {
+    if (map_ != nullptr) munmap(map_, map_size_);
+    if (fd_ >= 0) close(fd_);
+}
+
+/**
+ * @program:     createFile
+ * @description: This function builds an empty cache file under a temporary name and then
+ *               renames it to path, so the other processes never see it half written and
+ *               the ones which still map the old file keep it until they close it. When two
+ *               processes create it at once the last rename wins, the other one keeps a
+ *               file of its own until it opens the cache again
+ * @return:      The open file, or -1
+ */
+static int createFile(const std::filesystem::path& path, std::size_t slots) {
+    std::filesystem::path tmp = path;
+    tmp += "." + std::to_string(getpid()) + "." + std::to_string(std::random_device()()) + ".tmp";
+    int fd = open(tmp.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) return -1;
+
+    // The file grows with zeros, which are empty slots
+
+    FileHeader header = {};
+    std::memcpy(header.magic_, kFileMagic, sizeof(kFileMagic));
+    header.slots_ = slots;
+    if (ftruncate(fd, sizeof(FileHeader) + slots * sizeof(FileSlot)) != 0
+     || pwrite(fd, &header, sizeof(header), 0) != sizeof(header)
+     || rename(tmp.c_str(), path.c_str()) != 0) {
+        close(fd);
+        unlink(tmp.c_str());
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @program:     Core::VerdictCache::openFile
+ * @description: This function maps the cache file. A file with a valid header is used as
+ *               it is, with its own count of slots, because other judges may map it. A
+ *               missing or broken file is replaced by an empty one, see createFile, and a
+ *               file in use is never truncated
+ * @path:        The cache file
+ * @slots:       Count of slots when the file is created
+ * @return:      FALSE when the file can't be mapped, the memory tier still works
+ */
+bool Core::VerdictCache::openFile(const std::filesystem::path& path, std::size_t slots) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (map_ != nullptr || slots == 0) return false;
+
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd >= 0) {
+        struct stat st;
+        FileHeader header = {};
+        const bool valid = fstat(fd, &st) == 0
+                        && pread(fd, &header, sizeof(header), 0) == sizeof(header)
+                        && std::memcmp(header.magic_, kFileMagic, sizeof(kFileMagic)) == 0
+                        && header.slots_ != 0
+                        && header.slots_ <= (static_cast<std::uint64_t>(st.st_size) - sizeof(FileHeader)) / sizeof(FileSlot)
+                        && static_cast<std::uint64_t>(st.st_size) == sizeof(FileHeader) + header.slots_ * sizeof(FileSlot);
+        if (valid) {
+            slots = header.slots_;
+        } else {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) fd = createFile(path, slots);
+    if (fd < 0) return false;
+
+    const std::size_t size = sizeof(FileHeader) + slots * sizeof(FileSlot);
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    map_ = static_cast<unsigned char*>(map);
+    map_size_ = size;
+    slots_ = slots;
+    return true;
+}
+
+#else
+
+Core::VerdictCache::~VerdictCache() {}
+
+bool Core::VerdictCache::openFile(const std::filesystem::path& path, std::size_t slots) {
+    return false;
+}
+
+#endif
+
+/**
+ * @program:     Core::runCached
+ * @description: This function returns the verdict of the cache, or runs the commands with
+ *               the engine and caches the verdict. A program which can't be decoded isn't
+ *               cached, its error is found without running
+ * @cache:       The cache
+ * @kind:        The engine, all of them give the same verdict
+ * @level:       The level
+ * @cmd:         Commands, they are the pair of command name and vacant index
+ * @step_limit:  The game stops with kStepLimitExceeded after so many steps, 0 means no limit
+ * @compiled:    cmd compiled by Core::ProgramCache, it's not decoded again
+ */
+Core::CachedVerdict Core::runCached(
+    Core::VerdictCache& cache,
+    Core::EngineKind kind,
+    const Core::Level& level,
+    const Core::CommandList& cmd,
+    unsigned long long step_limit,
+    const Core::CompiledProgram* compiled
+) {
+    std::expected<Core::Program, Core::Diagnostic> p;
+    if (compiled == nullptr) {
+        p = Core::decodeProgram(cmd, level.available_cmd_);
+        if (!p) return Core::CachedVerdict{ std::unexpected(p.error()), 0 };
+    }
+
+    const Core::Program& program = compiled != nullptr ? compiled->program_ : *p;
+    const Core::VerdictKey key = Core::verdictKey(program, level, step_limit);
+    if (auto hit = cache.find(key)) return *hit;
+
+    Core::RunResult r = Core::runEngine(kind, level, cmd, step_limit, compiled);
+    Core::CachedVerdict value{ r.verdict_, r.state_.steps_ };
+    cache.insert(key, value);
+    return value;
+}
@@ -0,0 +1,98 @@
+#ifndef VERDICT_CACHE_H
+#define VERDICT_CACHE_H
+
+#include "engine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace Core {
+
+// Cache of verdicts for resubmitted programs. The key is a 128-bit hash of the decoded
+// program, the test data of the level (available commands, input, needed output, vacant
+// size) and the step limit, so a program that only differs in spaces or comments hits the
+// same entry. When a level changes, its old entries are never looked up again and they age
+// out, so nothing has to be invalidated by hand.
+//
+// The first tier is an LRU list in memory. The second tier is optional: a file mapped with
+// mmap, shared by the judge processes and kept across restarts. It's a direct-mapped table,
+// a new entry replaces the old one in its slot, and every slot has a checksum, so a slot
+// torn by a concurrent writer is a miss and not a wrong verdict.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class VerdictKey {
+  public:
+    std::uint64_t hash_[2] = { 0, 0 };
+
+    bool operator==(const VerdictKey& k) const = default;
+};
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class CachedVerdict {
+  public:
+    std::expected<Verdict, Diagnostic> verdict_ = Verdict::kFail;
+    unsigned long long steps_ = 0;
+};
+
+VerdictKey verdictKey(const Program& p, const Level& level, unsigned long long step_limit);
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class VerdictCache {
+  public:
+    explicit VerdictCache(std::size_t capacity = 1 << 12);
+    ~VerdictCache();
+    VerdictCache(const VerdictCache&) = delete;
+    VerdictCache& operator=(const VerdictCache&) = delete;
+
+    bool openFile(const std::filesystem::path& path, std::size_t slots = 1 << 16);
+    std::optional<CachedVerdict> find(const VerdictKey& key);
+    void insert(const VerdictKey& key, const CachedVerdict& value);
+    std::size_t size() const;
+
+  private:
+    class KeyHash {
+      public:
+        std::size_t operator()(const VerdictKey& k) const { return k.hash_[0]; }
+    };
+    using Entry = std::pair<VerdictKey, CachedVerdict>;
+
+    void remember(const VerdictKey& key, const CachedVerdict& value);
+
+    std::size_t capacity_;
+    std::list<Entry> lru_;      // The most recently used first
+    std::unordered_map<VerdictKey, std::list<Entry>::iterator, KeyHash> index_;
+    mutable std::mutex lock_;
+
+    int fd_ = -1;
+    unsigned char* map_ = nullptr;
+    std::size_t map_size_ = 0;
+    std::size_t slots_ = 0;
+};
+
+CachedVerdict runCached(
+    VerdictCache& cache,
+    EngineKind kind,
+    const Level& level,
+    const CommandList& cmd,
+    unsigned long long step_limit,
+    const CompiledProgram* compiled = nullptr
+);
+
+}
+
+#endif
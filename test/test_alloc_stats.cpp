@@ -0,0 +1,45 @@
+#include <core/alloc_stats.h>
+#include <core/core.h>
+#include <core/engine.h>
+
+#include "test_util.h"
+
+// Built with ROBOX_ALLOC_STATS, checks the allocation-free hot paths stay allocation-free
+
+int main() {
+    Test::Checker expect;
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "copyto", "add", "jump" };
+    level.provided_seq_ = { 0 };
+    level.vac_size_ = 1;
+    Core::CommandList cmd = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "add", 0 },
+        { "jump", 3 }
+    };
+
+    // A loop without `outbox`, it runs until the step limit
+
+    Core::RunResult ref = Core::runEngine(Core::EngineKind::kReferenceEngine, level, cmd, 10000);
+    expect(ref.stats_.count_[Core::AllocPhase::kPhaseLoad] > 0, "reference engine allocates on loading");
+    expect(ref.stats_.count_[Core::AllocPhase::kPhaseLog] == 0, "no log allocation when the log is off");
+
+    Core::RunResult decoded = Core::runEngine(Core::EngineKind::kDecodedEngine, level, cmd, 10000);
+    expect(decoded.state_.steps_ == 10000, "decoded engine runs until the step limit");
+    expect(decoded.stats_.count_[Core::AllocPhase::kPhaseRun] == 0, "decoded engine doesn't allocate in the run loop");
+
+    Core::Game game;
+    auto a = level.available_cmd_;
+    std::vector<int> ps(level.provided_seq_.begin(), level.provided_seq_.end());
+    std::vector<int> ns(level.needed_seq_.begin(), level.needed_seq_.end());
+    auto c = cmd;
+    game.setStepLimit(100);
+    game.initialize(a, ps, ns, c, level.vac_size_);
+    game.runAll();
+    expect(game.stats().count_[Core::AllocPhase::kPhaseLoad] > 0, "Game::stats counts loading");
+    expect(Core::processAllocStats().totalCount() >= game.stats().totalCount(), "process counts include the game");
+
+    return expect.failures();
+}
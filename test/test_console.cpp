@@ -16,6 +16,7 @@ int main() {
                     needed_sequence,
                     command,
                     0);
+    game.setProfiling(true);
     game.runAll();
     Cli::GamePanel tui(&game);
     tui.run();
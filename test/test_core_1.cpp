@@ -1,5 +1,7 @@
 #include <core/core.h>
 
+#include <iostream>
+
 int main() {
     Core::Game game;
     std::vector<std::string> available_command = { "inbox", "outbox" };
@@ -15,6 +17,15 @@ int main() {
                     needed_sequence,
                     command,
                     0);
-    game.runAll();
+    auto verdict = game.runAll();
+
+    // Core doesn't print anything, the test renders the result itself
+
+    if (!verdict) {
+        std::cout << "Error on instruction " << verdict.error().instruction_ << std::endl;
+        std::cout << Core::describeDiagnostic(verdict.error()) << std::endl;
+    } else {
+        std::cout << (*verdict == Core::Verdict::kSuccess ? "Success" : "Fail") << std::endl;
+    }
     return 0;
 }
\ No newline at end of file
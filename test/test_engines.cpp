@@ -0,0 +1,123 @@
+#include <core/accel.h>
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/hot_trace.h>
+#include <core/optimizer.h>
+
+#include <array>
+
+#include "test_util.h"
+
+// Checks the accelerated, tracing and optimized engines on the countdown loop : the exact
+// steps, the command where the step limit stops them in every line of a round, and the
+// line of an error after the loop is left
+
+int main() {
+    Test::Checker expect;
+    const int none = Core::Command::SingleCommand::kNullVacant;
+
+    // For every box n, output n, n - 1, ..., 0. A round of the loop from line 5 to line 11
+    // takes 7 steps, the round of 0 leaves after 4, and the inbox at the end of input is no
+    // step
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "add", "copyto", "copyfrom", "sub", "jump", "jumpifzero" };
+    level.vac_size_ = 3;
+    level.provided_seq_ = { 1, 300, 0, 25 };
+    for (int n : { 300, 0, 25 }) {
+        for (int v = n; v >= 0; --v) level.needed_seq_.push_back(v);
+    }
+    Core::CommandList countdown = {
+        { "inbox", none },
+        { "copyto", 1 },
+        { "inbox", none },
+        { "copyto", 0 },
+        { "copyfrom", 0 },
+        { "outbox", none },
+        { "copyfrom", 0 },
+        { "jumpifzero", 3 },
+        { "sub", 1 },
+        { "copyto", 0 },
+        { "jump", 5 }
+    };
+    auto steps = [](std::initializer_list<int> boxes) {
+        unsigned long long total = 2;
+        for (int n : boxes) total += 2 + 7ULL * n + 4;
+        return total;
+    };
+
+    auto p = Core::decodeProgram(countdown, level.available_cmd_);
+    if (!expect(p.has_value(), "countdown is decoded")) return expect.failures();
+
+    // What every engine builds for the loop
+
+    Core::LoopAccelerator accel(*p, level.vac_size_);
+    expect(accel.size() == 1 && accel.loopAt(10) == 0 && accel.loopAt(7) == -1, "accelerator finds the counting loop");
+
+    Core::TraceCache traces(*p, level.vac_size_);
+    Core::Machine m;
+    m.reset(level.vac_size_);
+    auto traced = Core::runDecoded(*p, level, m, 0, nullptr, nullptr, &traces);
+    expect(traced && *traced == Core::Verdict::kSuccess && traces.size() == 1, "hot loop is compiled to one trace");
+
+    Core::OptimizedProgram o = Core::optimizeProgram(*p);
+    expect(o.threaded_ == 1 && o.code_.size() == 10 && o.size_ == 11, "jump back is threaded and dropped");
+
+    const std::array<Core::EngineKind, 4> engines = {
+        Core::EngineKind::kDecodedEngine, Core::EngineKind::kAcceleratedEngine,
+        Core::EngineKind::kTracingEngine, Core::EngineKind::kOptimizedEngine
+    };
+    const Core::RunResult reference = Core::runEngine(Core::EngineKind::kReferenceEngine, level, countdown, 0);
+    const unsigned long long total = steps({ 300, 0, 25 });
+    expect(reference.verdict_ && *reference.verdict_ == Core::Verdict::kSuccess && reference.state_.steps_ == total,
+           "reference takes " + std::to_string(total) + " steps");
+
+    for (Core::EngineKind kind : engines) {
+        const std::string name = Core::engineName(kind);
+        Core::RunResult r = Core::runEngine(kind, level, countdown, 0);
+        expect(r.verdict_ == reference.verdict_ && r.state_ == reference.state_, name + " takes the steps of the reference");
+
+        // The limit stops the run before the command of the next step, in the rounds before
+        // and after the loop is hot, and in the round which leaves it
+
+        bool stopped = true;
+        for (unsigned int round : { 0U, 1U, 20U, 150U, 299U, 300U }) {
+            for (unsigned int line = 0; line < 7; ++line) {
+                const unsigned long long limit = 4 + 7ULL * round + line;
+                if (round == 300 && line >= 4) continue;
+                r = Core::runEngine(kind, level, countdown, limit);
+                const unsigned int id = (round == 300 && line == 3) ? 8 : 5 + line;
+                const unsigned int outputs = round + (line >= 2);
+                stopped &= !r.verdict_ && r.verdict_.error().code_ == Core::DiagnosticCode::kStepLimitExceeded &&
+                           r.verdict_.error().instruction_ == id && r.state_.steps_ == limit &&
+                           r.state_.output_.size() == outputs;
+            }
+        }
+        expect(stopped, name + " stops at the command of the step limit");
+
+        // Leaving the loop to a vacant which is empty is an error of that line, after all the
+        // rounds of the first box
+
+        Core::CommandList broken = countdown;
+        broken[7] = { "jumpifzero", 12 };
+        broken.push_back({ "add", 2 });
+        r = Core::runEngine(kind, level, broken, 0);
+        expect(!r.verdict_ && r.verdict_.error() == Core::Diagnostic{ Core::DiagnosticCode::kVacantEmpty, 12, 2 } &&
+               r.state_.steps_ == 4 + 7 * 300 + 4 && r.state_.output_.size() == 301,
+               name + " reports the empty vacant at line 12");
+    }
+
+    // A wrong box in the middle of the outputs of a round fails where the reference fails
+
+    Core::Level wrong = level;
+    wrong.needed_seq_[200] = -1;
+    const Core::RunResult failed = Core::runEngine(Core::EngineKind::kReferenceEngine, wrong, countdown, 0);
+    expect(failed.verdict_ && *failed.verdict_ == Core::Verdict::kFail, "wrong box fails the reference");
+    for (Core::EngineKind kind : engines) {
+        Core::RunResult r = Core::runEngine(kind, wrong, countdown, 0);
+        expect(r.verdict_ == failed.verdict_ && r.state_.steps_ == failed.state_.steps_,
+               Core::engineName(kind) + " fails at the step of the reference");
+    }
+
+    return expect.failures();
+}
@@ -0,0 +1,103 @@
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/equivalence.h>
+
+#include "test_util.h"
+
+// Checks that Core::checkEquivalence proves the programs equal in the bound, that the
+// counterexample is an input of the bound on which they differ, and that the threads give
+// the same result
+
+int main() {
+    Test::Checker expect;
+    const int none = Core::Command::SingleCommand::kNullVacant;
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "jump", "jumpifzero" };
+    Core::CommandList exterminator = {
+        { "inbox", none },
+        { "jumpifzero", 1 },
+        { "outbox", none },
+        { "jump", 1 }
+    };
+
+    // The loop rotated at the jump back, and the loop unrolled twice, which tests the third
+    // box no more
+
+    Core::CommandList rotated = {
+        { "inbox", none }, { "jumpifzero", 1 }, { "outbox", none },
+        { "inbox", none }, { "jumpifzero", 1 }, { "jump", 3 }
+    };
+    Core::CommandList unrolled = {
+        { "inbox", none }, { "jumpifzero", 1 }, { "outbox", none },
+        { "inbox", none }, { "jumpifzero", 1 }, { "outbox", none },
+        { "inbox", none }, { "outbox", none }, { "jump", 1 }
+    };
+    Core::CommandList echo = {
+        { "inbox", none },
+        { "outbox", none },
+        { "jump", 1 }
+    };
+
+    // The outputs of both programs on an input, the error ends the output
+
+    auto differ = [&level](const Core::CommandList& a, const Core::CommandList& b, const std::vector<int>& input) {
+        Core::Level l = level;
+        l.provided_seq_.assign(input.begin(), input.end());
+        Core::RunResult x = Core::runEngine(Core::EngineKind::kDecodedEngine, l, a, 10000);
+        Core::RunResult y = Core::runEngine(Core::EngineKind::kDecodedEngine, l, b, 10000);
+        return x.state_.output_ != y.state_.output_ || x.verdict_.has_value() != y.verdict_.has_value();
+    };
+
+    for (unsigned int threads : { 1U, 4U }) {
+        const std::string on = " on " + std::to_string(threads) + " threads";
+        Core::EquivalenceBound bound;
+        bound.threads_ = threads;
+
+        auto same = Core::checkEquivalence(level, rotated, exterminator, bound);
+        expect(same && same->equivalent_ && same->complete_ && same->counterexample_.empty(),
+               "rotated loop is proven equal" + on);
+
+        // Only the zero tells the echo apart, it's the shortest counterexample
+
+        auto zero = Core::checkEquivalence(level, echo, exterminator, bound);
+        expect(zero && !zero->equivalent_ && zero->complete_ && zero->counterexample_ == std::vector<int>{ 0 },
+               "echo differs on the input 0" + on);
+        bound.min_value_ = 1;
+        auto positive = Core::checkEquivalence(level, echo, exterminator, bound);
+        expect(positive && positive->equivalent_, "echo is proven equal on positive boxes" + on);
+        bound.min_value_ = -9;
+
+        // The unrolled loop only differs on a zero in the third box
+
+        auto third = Core::checkEquivalence(level, unrolled, exterminator, bound);
+        expect(third && !third->equivalent_ && third->counterexample_.size() == 3 &&
+               third->counterexample_[2] == 0 && differ(unrolled, exterminator, third->counterexample_),
+               "unrolled loop differs on a zero in the third box" + on);
+        bound.max_length_ = 2;
+        auto short_inputs = Core::checkEquivalence(level, unrolled, exterminator, bound);
+        expect(short_inputs && short_inputs->equivalent_, "unrolled loop is proven equal on 2 boxes" + on);
+    }
+
+    // The threads search the same states and find the same counterexample
+
+    Core::EquivalenceBound single, parallel;
+    single.threads_ = 1;
+    parallel.threads_ = 4;
+    auto a = Core::checkEquivalence(level, unrolled, exterminator, single);
+    auto b = Core::checkEquivalence(level, unrolled, exterminator, parallel);
+    expect(a && b && a->counterexample_ == b->counterexample_ && a->states_ == b->states_,
+           "4 threads give the counterexample of 1 thread");
+    a = Core::checkEquivalence(level, rotated, exterminator, single);
+    b = Core::checkEquivalence(level, rotated, exterminator, parallel);
+    expect(a && b && a->states_ == b->states_, "4 threads search the states of 1 thread");
+
+    single.max_states_ = 2;
+    auto partial = Core::checkEquivalence(level, rotated, exterminator, single);
+    expect(partial && !partial->complete_ && !partial->equivalent_, "search gives up after max_states_");
+
+    Core::CommandList unavailable = { { "add", 0 } };
+    expect(!Core::checkEquivalence(level, unavailable, exterminator, single), "program which can't be decoded is an error");
+
+    return expect.failures();
+}
@@ -0,0 +1,137 @@
+#include <core/core.h>
+#include <core/generator.h>
+#include <core/loader.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "test_util.h"
+
+// Checks the spec files, that Core::generateTests gives the same tests for a seed
+// whatever the count of threads, and the tests of levels whose boxes need int64
+
+int main() {
+    Test::Checker expect;
+
+    auto parse = [](const std::string& text) {
+        std::stringstream ss(text);
+        return Core::parseGeneratorSpec(ss);
+    };
+    auto spec = parse("structure pairs   # two boxes\nvalue -5 20\n\nlength 2 6\n");
+    if (!expect(spec.has_value(), "spec is read")) return expect.failures();
+    expect(spec->structure_ == Core::InputStructure::kPairInput && spec->min_value_ == -5 && spec->max_value_ == 20
+           && spec->min_length_ == 2 && spec->max_length_ == 6, "spec has the ranges of file");
+    auto bad = parse("value 1 2\nlength 3 1\n");
+    expect(!bad && bad.error().starts_with("Line 2 :"), "illegal range is reported with its line");
+    expect(!parse("structure trees\n"), "unknown structure is refused");
+    expect(!parse("structure strings\nvalue 0 0\n"), "strings of only 0 are refused");
+
+    // The doubler outputs every box added to itself, so needed is twice the input
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "copyto", "add", "jump" };
+    level.vac_size_ = 1;
+    Core::CommandList doubler = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "add", 0 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+
+    Core::GeneratorOptions options;
+    options.count_ = 64;
+    options.seed_ = 42;
+    options.threads_ = 1;
+    auto single = Core::generateTests(level, doubler, *spec, options);
+    if (!expect(single && single->size() == 64, "tests are generated on one thread")) return expect.failures();
+
+    bool shaped = true;
+    for (const Core::Level& test : *single) {
+        const std::size_t n = test.provided_seq_.size();
+        shaped &= n % 2 == 0 && n >= 4 && n <= 12 && test.needed_seq_.size() == n;
+        for (std::size_t i = 0; i < n && i < test.needed_seq_.size(); ++i) {
+            shaped &= test.provided_seq_[i] >= -5 && test.provided_seq_[i] <= 20;
+            shaped &= test.needed_seq_[i] == 2 * test.provided_seq_[i];
+        }
+    }
+    expect(shaped, "inputs have the shape of spec and needed is the output of reference");
+
+    auto same = [](const std::vector<Core::Level>& a, const std::vector<Core::Level>& b, std::size_t n) {
+        if (a.size() < n || b.size() < n) return false;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (a[i].provided_seq_ != b[i].provided_seq_ || a[i].needed_seq_ != b[i].needed_seq_) return false;
+        }
+        return true;
+    };
+
+    for (unsigned int threads : { 2U, 4U, 0U }) {
+        options.threads_ = threads;
+        auto parallel = Core::generateTests(level, doubler, *spec, options);
+        expect(parallel && same(*parallel, *single, 64),
+               "tests on " + std::to_string(threads) + " threads are the tests on one thread");
+    }
+
+    options.count_ = 16;
+    auto fewer = Core::generateTests(level, doubler, *spec, options);
+    expect(fewer && fewer->size() == 16 && same(*fewer, *single, 16), "test i doesn't change with the count");
+    options.seed_ = 43;
+    auto other = Core::generateTests(level, doubler, *spec, options);
+    expect(other && !same(*other, *single, 16), "another seed gives other tests");
+
+    // Every string ends with 0, which is in no string
+
+    Core::GeneratorSpec strings;
+    strings.structure_ = Core::InputStructure::kStringInput;
+    strings.min_value_ = -1;
+    strings.max_value_ = 1;
+    strings.min_length_ = 3;
+    strings.max_length_ = 3;
+    Core::SplitMix rng(7);
+    std::vector<std::int64_t> input = Core::generateInput(strings, rng);
+    expect(!input.empty() && input.back() == 0 && std::count(input.begin(), input.end(), 0) == 3,
+           "strings end with 0 and have no 0 in them");
+
+    // The first failed test is reported whatever the count of threads
+
+    Core::CommandList failing = { { "add", 0 } };
+    options.seed_ = 42;
+    options.threads_ = 4;
+    auto error = Core::generateTests(level, failing, *spec, options);
+    expect(!error && error.error().starts_with("The reference fails on test 0 :"), "first failed test is reported");
+
+    // An int64 level keeps boxes which don't fit int in its file, its input and its needed
+    // sequence, and the engines of `int` boxes refuse its input
+
+    std::stringstream wide_file("vacant 1\navailable inbox outbox copyto add jump\ninput 4000000000\nneeded 8000000000\nvalue int64\n");
+    auto wide = Core::parseLevel(wide_file);
+    if (!expect(wide && wide->provided_seq_[0] == 4000000000LL, "int64 level keeps a box which doesn't fit int")) {
+        return expect.failures();
+    }
+    std::stringstream narrow_file("input 4000000000\n");
+    expect(!Core::parseLevel(narrow_file), "int32 level refuses a box which doesn't fit int");
+
+    Core::RunResult typed = Core::runEngine(Core::EngineKind::kDecodedEngine, *wide, doubler, 100);
+    expect(typed.verdict_ && *typed.verdict_ == Core::Verdict::kSuccess && typed.narrowed_ &&
+           typed.wide_state_.output_ == std::vector<std::int64_t>{ 8000000000LL },
+           "int64 level succeeds and keeps the wide output");
+    Core::RunResult reference = Core::runEngine(Core::EngineKind::kReferenceEngine, *wide, doubler, 100);
+    expect(!reference.verdict_ && reference.verdict_.error() == Core::Diagnostic{ Core::DiagnosticCode::kValueOverflow, 0, 0 },
+           "reference refuses an input box which doesn't fit int");
+
+    Core::GeneratorSpec large;
+    large.min_value_ = std::int64_t(1) << 40;
+    large.max_value_ = std::int64_t(1) << 41;
+    options.count_ = 8;
+    auto wide_tests = Core::generateTests(*wide, doubler, large, options);
+    bool doubled = wide_tests.has_value();
+    for (const Core::Level& test : wide_tests ? *wide_tests : std::vector<Core::Level>{}) {
+        for (std::size_t i = 0; i < test.provided_seq_.size(); ++i) {
+            doubled &= test.provided_seq_[i] >= large.min_value_ && test.needed_seq_[i] == 2 * test.provided_seq_[i];
+        }
+    }
+    expect(doubled, "tests of an int64 level need boxes which don't fit int");
+    expect(!Core::generateTests(level, doubler, large, options), "int32 level refuses a range which doesn't fit int");
+
+    return expect.failures();
+}
@@ -0,0 +1,163 @@
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/expected_output.h>
+#include <core/input_source.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "test_util.h"
+
+// Checks the handoff of chunks in Core::InputConveyor, with and without the prefetching
+// thread, the boxes of Core::TextInput and a conveyor stopped on a pipe which stays open
+
+int main() {
+    Test::Checker expect;
+
+    auto drain = [](Core::InputConveyor& input) {
+        std::vector<int> boxes;
+        int box;
+        while (input.next(box)) boxes.push_back(box);
+        return boxes;
+    };
+
+    std::vector<std::int64_t> seq;
+    for (int i = 0; i < 10007; ++i) seq.push_back(i * 7 - 3000);
+
+    // Chunks of one box are handed over for every box, a chunk longer than the input once
+
+    for (std::size_t chunk : { 1, 3, 64, 4096, 1 << 16 }) {
+        for (bool prefetch : { true, false }) {
+            Core::InputConveyor input(std::make_unique<Core::SequenceInput>(seq), chunk, prefetch);
+            std::vector<int> boxes = drain(input);
+            int box = 12345;
+            const bool ended = !input.next(box) && !input.next(box) && box == 12345;
+            expect(std::ranges::equal(boxes, seq) && ended && input.error().empty(),
+                   "chunks of " + std::to_string(chunk) + (prefetch ? " prefetched" : " read on demand") +
+                   " give the sequence");
+        }
+    }
+
+    std::vector<std::int64_t> empty;
+    Core::InputConveyor none(std::make_unique<Core::SequenceInput>(empty), 4);
+    expect(drain(none).empty(), "empty input has no box");
+
+    // The streamed engine runs int, so the input of an int64 level ends at a box which doesn't fit
+
+    std::vector<std::int64_t> wide = { 1, 2, std::int64_t(1) << 40, 3 };
+    Core::InputConveyor too_wide(std::make_unique<Core::SequenceInput>(wide), 2);
+    expect(drain(too_wide) == std::vector<int>{ 1, 2 } && too_wide.error() == "The box 1099511627776 doesn't fit int.",
+           "box which doesn't fit int ends the sequence");
+
+    int count = 0;
+    Core::InputConveyor generated(std::make_unique<Core::GeneratorInput>([&count](int& box) {
+        if (count == 1000) return false;
+        box = count++;
+        return true;
+    }), 7);
+    std::vector<int> boxes = drain(generated);
+    expect(boxes.size() == 1000 && boxes.front() == 0 && boxes.back() == 999, "generator gives its boxes once");
+
+    // A conveyor destroyed before its input ends stops the thread
+
+    {
+        Core::InputConveyor partial(std::make_unique<Core::SequenceInput>(seq), 16);
+        int box;
+        expect(partial.next(box) && box == seq[0], "conveyor left early gives the first box");
+    }
+
+    // The text is longer than the bytes read at once, so boxes are split between reads
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "robox-test-input-conveyor.txt";
+    {
+        std::ofstream file(path);
+        for (int i = 0; i < 20000; ++i) file << (i % 2 ? "+" : "") << seq[i % seq.size()] << (i % 7 ? " " : "\n\t");
+    }
+    auto text = Core::TextInput::open(path);
+    expect(text.has_value(), "text input is opened");
+    if (text) {
+        Core::InputConveyor input(std::move(*text), 100);
+        boxes = drain(input);
+        bool same = boxes.size() == 20000;
+        for (std::size_t i = 0; same && i < boxes.size(); ++i) same = boxes[i] == seq[i % seq.size()];
+        expect(same && input.error().empty(), "text boxes are read across the reads");
+    }
+
+    {
+        std::ofstream file(path);
+        file << "1 2 3x 4";
+    }
+    text = Core::TextInput::open(path);
+    if (text) {
+        Core::InputConveyor input(std::move(*text), 2);
+        boxes = drain(input);
+        expect(boxes == std::vector<int>{ 1, 2 } && input.error() == "Illegal box `3x`.", "illegal box ends the input");
+    }
+    std::filesystem::remove(path);
+    expect(!Core::TextInput::open(path), "missing text file is an error");
+
+#ifdef __linux__
+
+    // A conveyor destroyed while its thread waits for a pipe which is still open cancels the
+    // read. The writer is closed after the wait, so a read which isn't cancelled ends too
+
+    int pipe_fd[2];
+    if (expect(pipe(pipe_fd) == 0, "pipe is created")) {
+        const char boxes_text[] = "1 2 3 ";
+        expect(write(pipe_fd[1], boxes_text, sizeof(boxes_text) - 1) == sizeof(boxes_text) - 1, "boxes are written to the pipe");
+        auto piped = Core::TextInput::open("/dev/fd/" + std::to_string(pipe_fd[0]));
+        close(pipe_fd[0]);
+        if (expect(piped.has_value(), "pipe is opened as text input")) {
+            auto input = std::make_unique<Core::InputConveyor>(std::move(*piped), 2);
+            int box;
+            expect(input->next(box) && box == 1, "first box of the pipe is taken");
+            std::atomic<bool> stopped = false;
+            std::thread stopper([&]() {
+                input.reset();
+                stopped = true;
+            });
+            for (int i = 0; i < 500 && !stopped; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            expect(stopped, "conveyor left early doesn't wait for the open pipe");
+            close(pipe_fd[1]);
+            stopper.join();
+        }
+    }
+
+#endif
+
+    // The streamed run on tiny chunks is the run of the decoded engine
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "copyto", "add", "jump" };
+    level.provided_seq_ = seq;
+    level.vac_size_ = 1;
+    for (int box : seq) level.needed_seq_.push_back(2 * box);
+    Core::CommandList cmd = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "add", 0 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+    auto p = Core::decodeProgram(cmd, level.available_cmd_);
+    if (!expect(p.has_value(), "doubler is decoded")) return expect.failures();
+
+    Core::RunResult decoded = Core::runEngine(Core::EngineKind::kDecodedEngine, level, cmd, 0);
+    Core::InputConveyor input(std::make_unique<Core::SequenceInput>(level.provided_seq_), 3);
+    Core::ExpectedOutput expected = Core::ExpectedOutput::fromSequence(level.needed_seq_);
+    Core::Machine m;
+    m.reset(level.vac_size_);
+    auto verdict = Core::runStreamed(*p, level, input, &expected, m, 0, nullptr);
+    expect(verdict && *verdict == Core::Verdict::kSuccess, "streamed doubler succeeds");
+    expect(m.steps_ == decoded.state_.steps_, "streamed steps are the steps of the decoded engine");
+
+    return expect.failures();
+}
@@ -0,0 +1,149 @@
+#include <core/content_hash.h>
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/program_cache.h>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+#include "test_util.h"
+
+// Checks the memory and directory tiers of Core::ProgramCache and the traces it keeps
+
+int main() {
+    Test::Checker expect;
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "copyto", "add", "jump" };
+    level.provided_seq_ = { 1, 2, 3 };
+    level.needed_seq_ = { 2, 4, 6 };
+    level.vac_size_ = 1;
+    Core::CommandList cmd = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "add", 0 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+
+    auto sameCode = [](const Core::Program& a, const Core::Program& b) {
+        if (a.code_.size() != b.code_.size()) return false;
+        for (std::size_t i = 0; i < a.code_.size(); ++i) {
+            if (a.code_[i].op_ != b.code_[i].op_ || a.code_[i].operand_ != b.code_[i].operand_) return false;
+        }
+        return true;
+    };
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "robox-test-program-cache";
+    std::filesystem::remove_all(dir);
+
+    // The second compile is the program in memory
+
+    Core::ProgramCache cache(dir);
+    auto first = cache.compile(cmd, level.available_cmd_);
+    if (!expect(first.has_value(), "doubler is compiled")) return expect.failures();
+    auto second = cache.compile(cmd, level.available_cmd_);
+    expect(second && *second == *first, "second compile is the program in memory");
+    expect(cache.compiled() == 1 && cache.loaded() == 0, "doubler is compiled once");
+
+    auto p = Core::decodeProgram(cmd, level.available_cmd_);
+    expect(p && sameCode((*first)->program_, *p), "compiled program is the decoded program");
+
+    Core::RunResult plain = Core::runEngine(Core::EngineKind::kOptimizedEngine, level, cmd, 1000);
+    Core::RunResult compiled = Core::runEngine(Core::EngineKind::kOptimizedEngine, level, cmd, 1000, first->get());
+    expect(compiled.verdict_ == plain.verdict_ && compiled.state_ == plain.state_, "compiled program runs as the commands");
+
+    Core::CommandList wrong = { { "sub", 0 } };
+    expect(!cache.compile(wrong, level.available_cmd_), "program which can't be decoded is an error");
+
+    // Another cache on the same directory loads the program instead of compiling it
+
+    Core::ProgramCache restarted(dir);
+    auto loaded = restarted.compile(cmd, level.available_cmd_);
+    expect(loaded && sameCode((*loaded)->program_, (*first)->program_), "loaded program is the compiled program");
+    expect(restarted.compiled() == 0 && restarted.loaded() == 1, "program is loaded from the directory");
+    Core::RunResult reloaded = Core::runEngine(Core::EngineKind::kOptimizedEngine, level, cmd, 1000, loaded->get());
+    expect(reloaded.verdict_ == plain.verdict_ && reloaded.state_ == plain.state_, "loaded program runs as the commands");
+
+    std::vector<std::string> shuffled = { "jump", "add", "copyto", "outbox", "inbox" };
+    restarted.compile(cmd, shuffled);
+    expect(restarted.loaded() == 1 && restarted.compiled() == 0, "order of available commands doesn't change the key");
+
+    // A broken file is compiled again and replaced
+
+    std::size_t files = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+        if (!entry.is_regular_file()) continue;
+        files++;
+        std::filesystem::resize_file(entry.path(), entry.file_size() - 1);
+    }
+    expect(files == 1, "one file for the program, none for the error");
+
+    Core::ProgramCache broken(dir);
+    auto again = broken.compile(cmd, level.available_cmd_);
+    expect(again && sameCode((*again)->program_, *p), "broken file is compiled again");
+    expect(broken.compiled() == 1 && broken.loaded() == 0, "broken file isn't loaded");
+    Core::ProgramCache repaired(dir);
+    repaired.compile(cmd, level.available_cmd_);
+    expect(repaired.loaded() == 1, "broken file is replaced");
+
+    // A file with a valid checksum but an index out of the programs is compiled again. The
+    // payload follows the header of 6 words of 64 bits, its checksum is the last of them
+
+    auto forge = [&dir](auto patch) {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+            if (!entry.is_regular_file()) continue;
+            std::fstream file(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+            std::uint64_t header[6];
+            file.read(reinterpret_cast<char*>(header), sizeof(header));
+            std::vector<std::uint32_t> words(header[4]);
+            file.read(reinterpret_cast<char*>(words.data()), words.size() * sizeof(std::uint32_t));
+            patch(words);
+            Core::ContentHash h;
+            h.add(words.size());
+            for (std::uint32_t w : words) h.add(w);
+            header[5] = h.h_[0];
+            file.seekp(0);
+            file.write(reinterpret_cast<const char*>(header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(std::uint32_t));
+        }
+    };
+
+    // The words are the size of program, its commands, the entry edge, and then the size,
+    // the no-ops and the count of the optimized program, whose commands are 9 words each
+
+    const std::size_t entry = 1 + 2 * p->code_.size();
+    const std::size_t first_line = entry + 3 + 3 + 2;
+    const std::vector<std::pair<std::string, std::function<void(std::vector<std::uint32_t>&)>>> forged = {
+        { "entry edge out of the optimized program", [entry](auto& w) { w[entry] = 1000; } },
+        { "line out of the program", [first_line](auto& w) { w[first_line] = 1000; } },
+        { "walk of no-ops out of the program", [entry](auto& w) { w[entry + 1] = 1; w[entry + 2] = 1000; } },
+        { "size other than the program", [entry](auto& w) { w[entry + 3]++; } }
+    };
+    for (const auto& [what, patch] : forged) {
+        forge(patch);
+        Core::ProgramCache forgery(dir);
+        auto recompiled = forgery.compile(cmd, level.available_cmd_);
+        expect(recompiled && forgery.loaded() == 0 && forgery.compiled() == 1, what + " is compiled again");
+    }
+    Core::ProgramCache replaced(dir);
+    replaced.compile(cmd, level.available_cmd_);
+    expect(replaced.loaded() == 1, "forged file is replaced");
+
+    // The traces of a run are kept for the next run on the same vacant size
+
+    const Core::CompiledProgram& program = **first;
+    auto traces = program.takeTraces(level.vac_size_);
+    const Core::TraceCache* kept = traces.get();
+    program.keepTraces(std::move(traces));
+    traces = program.takeTraces(level.vac_size_);
+    expect(traces.get() == kept, "kept traces are taken again");
+    program.keepTraces(std::move(traces));
+    auto other = program.takeTraces(level.vac_size_ + 1);
+    expect(other.get() != kept && other->vacSize() == level.vac_size_ + 1, "traces of another vacant size aren't taken");
+
+    std::filesystem::remove_all(dir);
+
+    return expect.failures();
+}
@@ -0,0 +1,142 @@
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/rewrite.h>
+
+#include <algorithm>
+
+#include "test_util.h"
+
+// Checks the rewrites of Core::reduceSteps one round at a time, that the rewritten program
+// keeps the verdict and the output on the tests, and that the steps reported are its steps
+
+int main() {
+    Test::Checker expect;
+    const int none = Core::Command::SingleCommand::kNullVacant;
+
+    Core::RewriteOptions options;
+    options.threads_ = 1;
+    options.bound_.max_length_ = 3;
+    options.bound_.min_value_ = -2;
+    options.bound_.max_value_ = 2;
+
+    // Every kept program succeeds on the tests, and the average steps of the result are
+    // the steps the decoded engine takes
+
+    auto check = [&](const std::string& name, const Core::Level& level, const Core::CommandList& cmd,
+                     double before, double after) {
+        auto r = Core::reduceSteps({ level }, cmd, options);
+        if (!expect(r.has_value(), name + " is rewritten")) return r;
+        Core::RunResult run = Core::runEngine(Core::EngineKind::kDecodedEngine, level, r->program_, 0);
+        expect(run.verdict_ && *run.verdict_ == Core::Verdict::kSuccess && std::ranges::equal(run.state_.output_, level.needed_seq_),
+               name + " keeps the verdict and the output");
+        expect(r->steps_before_ == before && r->steps_after_ == after &&
+               static_cast<double>(run.state_.steps_) == after,
+               name + " takes " + std::to_string(static_cast<int>(after)) + " steps instead of " +
+               std::to_string(static_cast<int>(before)));
+        return r;
+    };
+
+    // Loop rotation : the test at the head of the loop is copied to the jump back, which
+    // then skips it
+
+    Core::Level zeros;
+    zeros.available_cmd_ = { "inbox", "outbox", "jump", "jumpifzero" };
+    zeros.provided_seq_ = { 8, 0, -4, 0, 0, 3, 0, 1, -9, 0, 0, 5, 0, 2 };
+    zeros.needed_seq_ = { 8, -4, 3, 1, -9, 5, 2 };
+    Core::CommandList exterminator = {
+        { "inbox", none },
+        { "jumpifzero", 1 },
+        { "outbox", none },
+        { "jump", 1 }
+    };
+    options.max_rounds_ = 1;
+    auto rotated = check("rotated loop", zeros, exterminator, 42, 36);
+    if (rotated) {
+        const Core::CommandList program = {
+            { "inbox", none }, { "jumpifzero", 1 }, { "outbox", none },
+            { "inbox", none }, { "jumpifzero", 1 }, { "jump", 3 }
+        };
+        expect(rotated->applied_ == std::vector<std::string>{ "inline 2 lines at line 4" } &&
+               rotated->program_ == program, "loop is rotated at the jump back");
+    }
+
+    // Hoisting : the countdown reads the vacant at the head of the loop, but the hand holds
+    // it already when the loop jumps back
+
+    Core::Level countdown;
+    countdown.available_cmd_ = { "inbox", "outbox", "copyto", "copyfrom", "sub", "jump", "jumpifzero" };
+    countdown.provided_seq_ = { 4, 1, 6, 2, 0, 3, 9, 3 };
+    countdown.needed_seq_ = { 0, 0, 0, 0 };
+    countdown.vac_size_ = 2;
+    Core::CommandList divider = {
+        { "inbox", none },
+        { "copyto", 0 },
+        { "inbox", none },
+        { "copyto", 1 },
+        { "copyfrom", 0 },
+        { "jumpifzero", 10 },
+        { "sub", 1 },
+        { "copyto", 0 },
+        { "jump", 5 },
+        { "outbox", none },
+        { "jump", 1 }
+    };
+    auto hoisted = check("hoisted copyfrom", countdown, divider, 82, 72);
+    if (hoisted) {
+        Core::CommandList program = divider;
+        program[8] = { "jump", 6 };
+        expect(hoisted->applied_ == std::vector<std::string>{ "hoist line 5 before line 5" } &&
+               hoisted->program_ == program, "loop jumps back after the copyfrom");
+    }
+
+    // A jump to the next line is replaced by the lines it falls into
+
+    Core::Level echo;
+    echo.available_cmd_ = { "inbox", "outbox", "jump" };
+    echo.provided_seq_ = { 1, 2, 3, 4 };
+    echo.needed_seq_ = { 1, 2, 3, 4 };
+    Core::CommandList fall = {
+        { "inbox", none },
+        { "jump", 3 },
+        { "outbox", none },
+        { "jump", 1 }
+    };
+    auto fallen = check("fall-through jump", echo, fall, 16, 12);
+    if (fallen) {
+        expect(fallen->applied_ == std::vector<std::string>{ "inline 2 lines at line 2" } &&
+               fallen->program_[1] == Core::CommandList::value_type{ "outbox", none },
+               "jump to the next line is replaced");
+    }
+
+    // Without zeros in the tests, deleting the test of zero succeeds on them, but the input
+    // 0 is in the bound, so the rewrite isn't kept. An empty bound can't tell them apart
+
+    Core::Level nonzero = zeros;
+    nonzero.provided_seq_ = { 8, -4, 3, 1 };
+    nonzero.needed_seq_ = { 8, -4, 3, 1 };
+    options.max_rounds_ = 64;
+    options.max_inline_ = 0;
+    auto kept = check("rewrite out of the tests", nonzero, exterminator, 16, 16);
+    expect(kept && kept->applied_.empty() && kept->program_ == exterminator && kept->candidates_ > 0,
+           "rewrite which differs in the bound is rejected");
+    options.bound_.max_length_ = 0;
+    auto deleted = check("rewrite in an empty bound", nonzero, exterminator, 16, 12);
+    expect(deleted && !deleted->applied_.empty() && deleted->applied_[0] == "delete line 2",
+           "rewrite which only differs out of the bound is kept");
+    options.bound_.max_length_ = 3;
+    options.max_inline_ = 8;
+
+    // The threads don't change the rewrites kept
+
+    auto single = Core::reduceSteps({ zeros }, exterminator, options);
+    options.threads_ = 4;
+    auto parallel = Core::reduceSteps({ zeros }, exterminator, options);
+    expect(single && parallel && single->applied_ == parallel->applied_ && single->program_ == parallel->program_ &&
+           single->steps_after_ == parallel->steps_after_, "4 threads keep the rewrites of 1 thread");
+
+    Core::CommandList wrong = exterminator;
+    wrong[1] = { "jumpifzero", 3 };
+    expect(!Core::reduceSteps({ zeros }, wrong, options), "submission which fails is an error");
+
+    return expect.failures();
+}
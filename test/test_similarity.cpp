@@ -0,0 +1,80 @@
+#include <core/core.h>
+#include <core/similarity.h>
+
+#include <filesystem>
+
+#include "test_util.h"
+
+// Checks the normalization, the near-duplicate queries and the file of Core::SimilarityIndex
+
+int main() {
+    Test::Checker expect;
+
+    // Programs of 40 commands drawn from a seed, the jumps go back into the program
+
+    auto program = [](std::uint32_t seed) {
+        Core::CommandList cmd;
+        for (int i = 0; i < 40; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            const std::string& name = Core::Command::kAllCmd[(seed >> 24) % Core::Command::kAllCmd.size()];
+            if (name == "inbox" || name == "outbox") {
+                cmd.emplace_back(name, Core::Command::SingleCommand::kNullVacant);
+            } else if (name == "jump" || name == "jumpifzero") {
+                cmd.emplace_back(name, 1 + (seed >> 8) % (i + 1));
+            } else {
+                cmd.emplace_back(name, (seed >> 8) % 6);
+            }
+        }
+        return cmd;
+    };
+
+    // Renaming the vacants doesn't hide a copy
+
+    Core::CommandList original = program(7);
+    Core::CommandList renamed = original;
+    for (auto& [name, index] : renamed) {
+        if (index != Core::Command::SingleCommand::kNullVacant && name != "jump" && name != "jumpifzero") index += 10;
+    }
+    expect(Core::normalizeProgram(renamed) == Core::normalizeProgram(original), "renamed vacants normalize the same");
+    expect(Core::minHash(renamed) == Core::minHash(original), "renamed vacants have the same signature");
+    expect(!(Core::minHash(program(8)) == Core::minHash(original)), "another program has another signature");
+
+    Core::CommandList edited = renamed;
+    edited[20] = { "outbox", Core::Command::SingleCommand::kNullVacant };
+    edited.push_back({ "inbox", Core::Command::SingleCommand::kNullVacant });
+
+    std::vector<std::pair<std::uint32_t, Core::CommandList>> programs;
+    for (std::uint32_t id = 1; id <= 200; ++id) programs.emplace_back(id, id == 100 ? original : program(1000 + id));
+
+    Core::SimilarityIndex index;
+    for (const auto& [id, cmd] : programs) index.add(id, cmd);
+    expect(index.size() == 200 && index.contains(100) && !index.contains(201), "every program is indexed");
+
+    auto copy = index.query(renamed, 0.9);
+    expect(copy.size() == 1 && copy[0].first == 100 && copy[0].second == 1.0, "renamed copy is found exactly");
+    auto near = index.query(edited, 0.6);
+    expect(!near.empty() && near[0].first == 100, "edited copy is the most similar");
+    auto far = index.query(program(5), 0.9);
+    expect(far.empty(), "unrelated program has no near duplicate");
+
+    // The parallel signatures are the signatures of add
+
+    Core::SimilarityIndex parallel;
+    parallel.addAll(programs, 4);
+    expect(parallel.size() == index.size(), "every program is indexed in parallel");
+    expect(parallel.query(edited, 0.3) == index.query(edited, 0.3), "parallel index answers as the index");
+
+    // The file keeps the signatures, the buckets are built again
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "robox-test-similarity.bin";
+    expect(index.save(path), "index is saved");
+    Core::SimilarityIndex loaded;
+    loaded.add(500, program(500));
+    expect(loaded.load(path), "index is loaded");
+    expect(loaded.size() == 201 && loaded.contains(500), "loaded signatures are added to the index");
+    expect(loaded.query(edited, 0.3) == index.query(edited, 0.3), "loaded index answers as the index");
+    std::filesystem::remove(path);
+    expect(!loaded.load(path) && loaded.size() == 201, "missing file doesn't change the index");
+
+    return expect.failures();
+}
@@ -0,0 +1,132 @@
+#include <core/analysis.h>
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/sparse_vacant.h>
+
+#include <algorithm>
+
+#include "test_util.h"
+
+// Checks the table of Core::SparseVacant, the threshold of BasicMachine::reset at
+// kDenseVacant, and that the engines and the static analysis run the sparse vacant as
+// the reference
+
+int main() {
+    Test::Checker expect;
+
+    Core::SparseVacant<int> v;
+    expect(v.find(0) == nullptr && v.size() == 0, "new vacant is empty");
+    v.reset(1 << 20);
+
+    // The tiles are far apart and put out of order, the table grows many times
+
+    std::vector<std::pair<int, int>> tiles;
+    for (int i = 0; i < 1000; ++i) tiles.emplace_back(static_cast<int>((i * 7919LL) % (1 << 20)), i - 500);
+    for (const auto& [x, box] : tiles) v.put(x, box);
+    bool found = v.size() == tiles.size();
+    for (const auto& [x, box] : tiles) found &= v.find(x) != nullptr && *v.find(x) == box;
+    expect(found, "every tile put is found");
+    expect(v.find(1) == nullptr && v.find((1 << 20) - 1) == nullptr, "tile not put is empty");
+
+    v.put(tiles[10].first, 12345);
+    expect(v.size() == tiles.size() && *v.find(tiles[10].first) == 12345, "put again replaces the box");
+    tiles[10].second = 12345;
+
+    std::vector<std::pair<int, int>> sorted = tiles;
+    std::sort(sorted.begin(), sorted.end());
+    expect(v.sorted() == sorted, "sorted lists the tiles in order");
+
+    // The layout depends on the order, operator== doesn't
+
+    Core::SparseVacant<int> w;
+    w.reset(1 << 20);
+    for (auto it = tiles.rbegin(); it != tiles.rend(); ++it) w.put(it->first, it->second);
+    expect(v == w, "same tiles put in another order are equal");
+    w.put(tiles[0].first, tiles[0].second + 1);
+    expect(!(v == w), "another box isn't equal");
+    w.put(tiles[0].first, tiles[0].second);
+    w.reset(1 << 19);
+    for (const auto& [x, box] : tiles) w.put(x, box);
+    expect(!(v == w), "another declared size isn't equal");
+
+    v.reset(100);
+    expect(v.size() == 0 && v.tiles() == 100 && v.sorted().empty(), "reset empties the vacant");
+    bool cleared = true;
+    for (const auto& [x, box] : tiles) cleared &= v.find(x) == nullptr;
+    expect(cleared, "reset clears every tile put");
+    v.put(7, 1);
+    expect(v.size() == 1 && *v.find(7) == 1, "vacant is used again after reset");
+
+    Core::SparseVacant<std::int64_t> wide;
+    wide.reset(1 << 20);
+    wide.put(3, std::int64_t(1) << 40);
+    expect(*wide.find(3) == std::int64_t(1) << 40, "int64 vacant keeps its boxes");
+
+    // The vacant is dense up to kDenseVacant tiles and sparse above
+
+    Core::Machine m;
+    m.reset(Core::kDenseVacant);
+    expect(!m.sparse() && m.vacant_.size() == static_cast<std::size_t>(Core::kDenseVacant), "kDenseVacant tiles are dense");
+    m.reset(Core::kDenseVacant + 1);
+    expect(m.sparse() && m.vacant_.empty() && m.sparse_.tiles() == Core::kDenseVacant + 1, "kDenseVacant + 1 tiles are sparse");
+    m.sparse_.put(5, 5);
+    m.reset(Core::kDenseVacant + 1);
+    expect(m.sparse_.size() == 0, "reset clears the sparse vacant");
+    m.sparse_.put(5, 5);
+    m.reset(2);
+    expect(!m.sparse() && m.vacant_.size() == 2 && m.sparse_.size() == 0, "a small level after a large one is dense");
+
+    // A far tile is copied to and read back, and an empty far tile is an error
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "copyto", "copyfrom", "add", "jump" };
+    level.provided_seq_ = { 3, 4, 5 };
+    level.needed_seq_ = { 6, 8, 10 };
+    level.vac_size_ = Core::kDenseVacant + 100;
+    const int far = Core::kDenseVacant + 50;
+    Core::CommandList cmd = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", far },
+        { "add", far },
+        { "copyto", 7 },
+        { "copyfrom", 7 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+    Core::CommandList empty_tile = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyfrom", far },
+        { "outbox", Core::Command::SingleCommand::kNullVacant }
+    };
+
+    for (const Core::CommandList* c : { &cmd, &empty_tile }) {
+        Core::RunResult ref = Core::runEngine(Core::EngineKind::kReferenceEngine, level, *c, 1000);
+        for (auto kind : Core::kAllEngine) {
+            if (kind == Core::EngineKind::kReferenceEngine) continue;
+            Core::RunResult r = Core::runEngine(kind, level, *c, 1000);
+            expect(r.verdict_ == ref.verdict_ && r.state_ == ref.state_,
+                   Core::engineName(kind) + (c == &cmd ? " runs the far tiles" : " fails on the empty far tile") +
+                   " as the reference");
+        }
+        if (c == &cmd) {
+            expect(ref.verdict_ && *ref.verdict_ == Core::Verdict::kSuccess, "doubler on far tiles succeeds");
+            expect(ref.state_.sparse_.size() == 2 && *ref.state_.sparse_.find(far) == 5, "far tile keeps the last box");
+        } else {
+            expect(!ref.verdict_, "empty far tile is an error");
+            auto fault = Core::staticVerdict(level, *c, 1000);
+            expect(fault && *fault == ref.verdict_.error(), "static analysis finds the empty far tile");
+        }
+    }
+
+    // The analysis only tracks the named tiles, so a vacant of millions of tiles is proven
+    // as the small one, and agrees with the engines on the sparse vacant
+
+    Core::Level huge = level;
+    huge.vac_size_ = 1 << 22;
+    Core::RunResult decoded = Core::runEngine(Core::EngineKind::kDecodedEngine, huge, empty_tile, 1000);
+    auto fault = Core::staticVerdict(huge, empty_tile, 1000);
+    expect(!decoded.verdict_ && fault && *fault == decoded.verdict_.error(),
+           "static analysis of a huge vacant gives the error of the engines");
+
+    return expect.failures();
+}
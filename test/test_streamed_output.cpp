@@ -0,0 +1,101 @@
+#include <core/accel.h>
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/expected_output.h>
+#include <core/input_source.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#include "test_util.h"
+
+// Checks an accelerated counting loop against an expected output longer than the drain
+// size of Core::runStreamed, the output is compared in batches instead of kept whole, and
+// both binary formats of expected output files
+
+int main() {
+    Test::Checker expect;
+
+    constexpr int kCount = 20000;
+    constexpr std::size_t kDrainSize = 1 << 12;     // CheckSink::kDrainSize of engine.cc
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "copyto", "copyfrom", "sub", "jump", "jumpifzero" };
+    level.provided_seq_ = { 1, kCount };
+    level.vac_size_ = 2;
+    Core::CommandList cmd = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 1 },
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "copyfrom", 0 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyfrom", 0 },
+        { "jumpifzero", 3 },
+        { "sub", 1 },
+        { "copyto", 0 },
+        { "jump", 5 }
+    };
+
+    // Counts down from kCount to 0, the loop from line 5 is a counting loop
+
+    std::vector<std::int64_t> needed;
+    for (int i = kCount; i >= 0; --i) needed.push_back(i);
+
+    auto p = Core::decodeProgram(cmd, level.available_cmd_);
+    if (!expect(p.has_value(), "countdown is decoded")) return expect.failures();
+    Core::LoopAccelerator accel(*p, level.vac_size_);
+    expect(accel.size() == 1, "countdown has a counting loop");
+
+    auto run = [&](const std::vector<std::int64_t>& seq, Core::Machine& m) {
+        Core::InputConveyor input(std::make_unique<Core::SequenceInput>(level.provided_seq_));
+        Core::ExpectedOutput expected = Core::ExpectedOutput::fromSequence(seq);
+        m.reset(level.vac_size_);
+        auto verdict = Core::runStreamed(*p, level, input, &expected, m, 0, nullptr, &accel);
+        return std::make_pair(verdict, expected.mismatch());
+    };
+
+    Core::Machine m;
+    auto [verdict, mismatch] = run(needed, m);
+    expect(verdict && *verdict == Core::Verdict::kSuccess, "accelerated countdown matches the expected output");
+    expect(m.output_.capacity() <= 2 * kDrainSize, "the output never holds much more than the drain size");
+
+    Core::RunResult decoded = Core::runEngine(Core::EngineKind::kDecodedEngine, level, cmd, 0);
+    expect(m.steps_ == decoded.state_.steps_, "accelerated steps are the steps of the decoded engine");
+
+    std::vector<std::int64_t> wrong = needed;
+    wrong[kCount / 2]++;
+    Core::Machine n;
+    auto [wrong_verdict, wrong_at] = run(wrong, n);
+    expect(wrong_verdict && *wrong_verdict == Core::Verdict::kFail, "a wrong box in the middle fails");
+    expect(wrong_at && *wrong_at == kCount / 2, "the mismatch is at the wrong box");
+
+    // A file of 32-bit boxes and one of 64-bit boxes are read the same, and a box which
+    // doesn't fit int is never matched by the output
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "robox-test-expected-output.bin";
+    auto runFile = [&](const char* magic, auto box_type, std::int64_t last) {
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(magic, 8);
+            for (std::size_t i = 0; i < needed.size(); ++i) {
+                decltype(box_type) box = static_cast<decltype(box_type)>(i + 1 == needed.size() ? last : needed[i]);
+                file.write(reinterpret_cast<const char*>(&box), sizeof(box));
+            }
+        }
+        auto expected = Core::ExpectedOutput::open(path);
+        if (!expected) return false;
+        Core::InputConveyor input(std::make_unique<Core::SequenceInput>(level.provided_seq_));
+        Core::Machine f;
+        f.reset(level.vac_size_);
+        auto verdict = Core::runStreamed(*p, level, input, &*expected, f, 0, nullptr, &accel);
+        return verdict && *verdict == Core::Verdict::kSuccess;
+    };
+    expect(runFile("RBXOUT01", std::int32_t(), 0), "file of 32-bit boxes matches");
+    expect(runFile("RBXOUT64", std::int64_t(), 0), "file of 64-bit boxes matches");
+    expect(!runFile("RBXOUT64", std::int64_t(), std::int64_t(1) << 32), "box which doesn't fit int isn't matched");
+    std::filesystem::remove(path);
+
+    return expect.failures();
+}
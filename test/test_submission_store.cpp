@@ -0,0 +1,102 @@
+#include <core/core.h>
+#include <core/submission_store.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "test_util.h"
+
+// Checks the encoding, the shared prefixes and the queries of Core::SubmissionStore
+
+int main() {
+    Test::Checker expect;
+
+    // A command is 4 bytes, the operand is signed and kNullVacant survives
+
+    for (const std::string& name : Core::Command::kAllCmd) {
+        for (int index : { Core::Command::SingleCommand::kNullVacant, 0, 7, (1 << 27) - 1, -(1 << 27) }) {
+            auto c = Core::encodeCommand(name, index);
+            if (!c || Core::decodeCommand(*c) != std::make_pair(name, index)) {
+                expect(false, name + " " + std::to_string(index) + " is encoded and decoded");
+            }
+        }
+    }
+    expect(!Core::encodeCommand("bump", 0), "unknown command can't be encoded");
+    expect(!Core::encodeCommand("copyto", 1 << 27), "operand of more than 28 bits can't be encoded");
+
+    Core::CommandList echo = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+    Core::CommandList doubler = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "add", 0 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+    Core::CommandList sum = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "copyto", 0 },
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "add", 0 },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+
+    // The programs share their prefixes, a program submitted again is the same node
+
+    Core::SubmissionStoreBuilder builder;
+    expect(builder.add("mail room", echo), "echo is added");
+    expect(builder.add("double", doubler), "doubler is added");
+    expect(builder.add("mail room", echo), "echo is added again");
+    expect(builder.add("sum", sum), "sum is added");
+    expect(builder.add("double", {}), "empty program is added");
+    expect(!builder.add("double", { { "copyto", 1 << 27 } }), "program which can't be encoded isn't added");
+    expect(builder.submissions() == 5, "every submission is kept");
+    expect(builder.nodes() == 1 + 3 + 4 + 4, "prefix of doubler and sum is shared");
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "robox-test-submission-store.bin";
+    expect(builder.save(path), "store is saved");
+
+    auto store = Core::SubmissionStore::open(path);
+    if (!expect(store.has_value(), "store is opened")) return expect.failures();
+    expect(store->submissions() == 5 && store->nodes() == builder.nodes(), "store has every submission and node");
+    expect(store->programs() == 4, "a program submitted twice is stored once");
+    expect(store->levels() == std::vector<std::string>{ "double", "mail room", "sum" }, "levels are sorted by name");
+
+    auto mail = store->byLevel("mail room");
+    expect(mail.size() == 2 && mail[0].node_ == mail[1].node_, "both submissions of echo are the same node");
+    expect(!mail.empty() && store->program(mail[0].node_) == echo, "echo is read back");
+    auto twice = store->byLevel("double");
+    expect(twice.size() == 2 && store->program(twice[0].node_) == doubler, "doubler is read back");
+    expect(twice.size() == 2 && twice[1].node_ == 0 && store->program(0).empty(), "empty program is the root");
+    expect(store->byLevel("triple").empty() && store->byLevel("").empty(), "missing level has no submission");
+
+    auto found = store->find(sum);
+    expect(found.size() == 1 && store->program(found[0]) == sum, "sum is found by its commands");
+    Core::CommandList prefix(sum.begin(), sum.begin() + 2);
+    expect(store->find(prefix).empty(), "a prefix which wasn't submitted isn't found");
+    expect(store->byHash(Core::programHash(echo)) == std::vector<std::uint32_t>{ mail[0].node_ }, "echo is found by its hash");
+    expect(store->programNodes().size() == 4, "every program is listed once");
+    expect(store->program(static_cast<std::uint32_t>(store->nodes())).empty(), "node out of the store is empty");
+
+    {
+        Core::SubmissionStore moved = std::move(*store);
+        expect(moved.find(echo).size() == 1, "moved store has the programs");
+        expect(store->submissions() == 0 && store->byLevel("mail room").empty(), "store moved from is empty");
+    }
+
+    // A file which isn't a store is refused
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a store";
+    }
+    expect(!Core::SubmissionStore::open(path), "file which isn't a store is refused");
+    std::filesystem::remove(path);
+    expect(!Core::SubmissionStore::open(path), "missing file is refused");
+
+    return expect.failures();
+}
@@ -0,0 +1,92 @@
+#include <core/core.h>
+#include <core/synth.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "test_util.h"
+
+// Checks that Core::synthesize finds the same shortest program for any count of threads,
+// and that a checkpoint is resumed at its own depth and only by its own search
+
+int main() {
+    Test::Checker expect;
+
+    // Output every box which is not zero, the shortest program has 4 commands
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "jump", "jumpifzero" };
+    level.provided_seq_ = { 8, 0, -4, 0, 0, 3, 0, 1, -9, 0, 0, 5, 0, 2 };
+    level.needed_seq_ = { 8, -4, 3, 1, -9, 5, 2 };
+    level.vac_size_ = 0;
+    const std::vector<Core::Level> tests = { level };
+
+    Core::SynthOptions options;
+    options.max_size_ = 5;
+    options.threads_ = 1;
+    auto fresh = Core::synthesize(tests, options);
+    if (!expect(fresh && fresh->program_, "zero exterminator is solved")) return expect.failures();
+    expect(fresh->program_->size() == 4 && fresh->size_ == 4, "solution has 4 commands");
+
+    for (unsigned int threads : { 2U, 8U }) {
+        options.threads_ = threads;
+        auto r = Core::synthesize(tests, options);
+        expect(r && r->program_ == fresh->program_,
+               std::to_string(threads) + " threads find the program of 1 thread");
+    }
+
+    // The search up to 3 commands leaves the checkpoint of size 4, the first tasks of 3
+    // lines are marked done, as a search on 8 threads would save them. A search on 1 thread
+    // splits size 4 at 2 lines, it must keep the 3 lines of the checkpoint
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "robox-test-synth.ckpt";
+    std::filesystem::remove(path);
+    options.checkpoint_ = path;
+    options.max_size_ = 3;
+    options.threads_ = 8;
+    auto partial = Core::synthesize(tests, options);
+    expect(partial && !partial->program_, "no program has 3 commands");
+
+    std::string saved;
+    {
+        std::ifstream file(path);
+        std::stringstream text;
+        text << file.rdbuf();
+        saved = text.str();
+    }
+    const std::size_t depth = saved.find("depth 0\n");
+    const std::size_t done = saved.rfind("done");
+    if (!expect(saved.rfind("robox-synth-2\nsize 4\n", 0) == 0 && depth != std::string::npos &&
+                done != std::string::npos, "checkpoint of the next size is saved")) {
+        return expect.failures();
+    }
+    std::string resumed = saved;
+    resumed.replace(done, std::string::npos, "done 0 1 2 3 4 5\n");
+    resumed.replace(depth, 8, "depth 3\n");
+
+    options.max_size_ = 5;
+    for (unsigned int threads : { 1U, 2U, 8U }) {
+        std::ofstream(path) << resumed;
+        options.threads_ = threads;
+        auto r = Core::synthesize(tests, options);
+        expect(r && r->program_ == fresh->program_,
+               "checkpoint resumed on " + std::to_string(threads) + " threads finds the program");
+    }
+
+    // A checkpoint of other tests or of another step limit is refused
+
+    std::ofstream(path) << resumed;
+    std::vector<Core::Level> other = tests;
+    other[0].needed_seq_.pop_back();
+    expect(!Core::synthesize(other, options), "checkpoint of other tests is refused");
+    options.step_limit_ = 500;
+    expect(!Core::synthesize(tests, options), "checkpoint of another step limit is refused");
+    options.step_limit_ = 10000;
+
+    std::ofstream(path) << "robox-synth-2\nsize 4\ndepth 0\n";
+    expect(!Core::synthesize(tests, options), "broken checkpoint is refused");
+    std::filesystem::remove(path);
+
+    return expect.failures();
+}
@@ -0,0 +1,42 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <core/core.h>
+
+#include <iostream>
+#include <string>
+
+namespace Test {
+
+// Harness of the tests which ctest runs. Every check prints one line, and main returns the
+// count of failed checks, so a test passes when it returns 0. The log file is off, the
+// tests run in the build directory.
+
+/**
+ * @author: AshGrey
+ * @date:   2024-12-29
+ */
+class Checker {
+  public:
+    Checker() { Core::setLogEnabled(false); }
+
+    /**
+     * @program:     Test::Checker::operator()
+     * @description: This function prints the check and counts it when it fails
+     * @return:      ok, so a check can guard the checks which need it
+     */
+    bool operator()(bool ok, const std::string& what) {
+        std::cout << (ok ? "OK    " : "FAIL  ") << what << std::endl;
+        if (!ok) failures_++;
+        return ok;
+    }
+
+    int failures() const { return failures_; }
+
+  private:
+    int failures_ = 0;
+};
+
+}
+
+#endif
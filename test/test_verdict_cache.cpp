@@ -0,0 +1,119 @@
+#include <core/core.h>
+#include <core/engine.h>
+#include <core/verdict_cache.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "test_util.h"
+
+// Checks the keys, the LRU tier and the file tier of Core::VerdictCache
+
+int main() {
+    Test::Checker expect;
+
+    Core::Level level;
+    level.available_cmd_ = { "inbox", "outbox", "jump" };
+    level.provided_seq_ = { 1, 2, 3 };
+    level.needed_seq_ = { 1, 2, 3 };
+    level.vac_size_ = 0;
+    Core::CommandList cmd = {
+        { "inbox", Core::Command::SingleCommand::kNullVacant },
+        { "outbox", Core::Command::SingleCommand::kNullVacant },
+        { "jump", 1 }
+    };
+
+    auto p = Core::decodeProgram(cmd, level.available_cmd_);
+    if (!expect(p.has_value(), "echo is decoded")) return expect.failures();
+
+    // Everything which decides the verdict is in the key, the order of available commands isn't
+
+    const Core::VerdictKey key = Core::verdictKey(*p, level, 100);
+    Core::Level shuffled = level;
+    shuffled.available_cmd_ = { "jump", "outbox", "inbox" };
+    expect(Core::verdictKey(*p, shuffled, 100) == key, "order of available commands doesn't change the key");
+    Core::Level other = level;
+    other.needed_seq_ = { 1, 2, 4 };
+    expect(!(Core::verdictKey(*p, other, 100) == key), "needed output changes the key");
+    expect(!(Core::verdictKey(*p, level, 101) == key), "step limit changes the key");
+    Core::Level typed = level;
+    typed.value_kind_ = Core::ValueKind::kValue64;
+    expect(!(Core::verdictKey(*p, typed, 100) == key), "value type changes the key");
+
+    // runCached runs once, then answers from the cache
+
+    Core::VerdictCache cache;
+    Core::CachedVerdict first = Core::runCached(cache, Core::EngineKind::kDecodedEngine, level, cmd, 100);
+    expect(first.verdict_ && *first.verdict_ == Core::Verdict::kSuccess, "echo succeeds");
+    expect(cache.size() == 1, "verdict is cached");
+    Core::CachedVerdict second = Core::runCached(cache, Core::EngineKind::kReferenceEngine, level, cmd, 100);
+    expect(second.verdict_ == first.verdict_ && second.steps_ == first.steps_, "second run is the cached verdict");
+    expect(cache.size() == 1, "a hit isn't cached again");
+
+    Core::CachedVerdict failed = Core::runCached(cache, Core::EngineKind::kDecodedEngine, other, cmd, 100);
+    expect(failed.verdict_ && *failed.verdict_ == Core::Verdict::kFail, "changed level is run, not hit");
+
+    Core::CommandList wrong = { { "add", 0 } };
+    Core::CachedVerdict undecoded = Core::runCached(cache, Core::EngineKind::kDecodedEngine, level, wrong, 100);
+    expect(!undecoded.verdict_, "program which can't be decoded is an error");
+    expect(cache.size() == 2, "program which can't be decoded isn't cached");
+
+    // The least recently used entry is dropped first
+
+    auto keyOf = [](std::uint64_t i) { return Core::VerdictKey{ { i, ~i } }; };
+    Core::VerdictCache small(2);
+    small.insert(keyOf(1), Core::CachedVerdict{ Core::Verdict::kSuccess, 1 });
+    small.insert(keyOf(2), Core::CachedVerdict{ Core::Verdict::kSuccess, 2 });
+    expect(small.find(keyOf(1)).has_value(), "first entry is found");
+    small.insert(keyOf(3), Core::CachedVerdict{ Core::Verdict::kSuccess, 3 });
+    expect(small.size() == 2, "capacity is kept");
+    expect(!small.find(keyOf(2)).has_value(), "least recently used entry is dropped");
+    expect(small.find(keyOf(1)).has_value() && small.find(keyOf(3)).has_value(), "recent entries are kept");
+
+    // The file tier keeps the verdicts for the next cache, errors included
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "robox-test-verdict-cache.bin";
+    std::filesystem::remove(path);
+    const Core::Diagnostic fault{ Core::DiagnosticCode::kStepLimitExceeded, 2, 0 };
+    {
+        Core::VerdictCache writer;
+        expect(writer.openFile(path, 64), "cache file is mapped");
+        writer.insert(keyOf(7), Core::CachedVerdict{ Core::Verdict::kSuccess, 42 });
+        writer.insert(keyOf(8), Core::CachedVerdict{ std::unexpected(fault), 100 });
+    }
+    {
+        Core::VerdictCache reader;
+        expect(reader.openFile(path, 64), "cache file is mapped again");
+        auto hit = reader.find(keyOf(7));
+        expect(hit && hit->verdict_ && *hit->verdict_ == Core::Verdict::kSuccess && hit->steps_ == 42,
+               "verdict is read from the file");
+        auto error = reader.find(keyOf(8));
+        expect(error && !error->verdict_ && error->verdict_.error() == fault && error->steps_ == 100,
+               "error is read from the file");
+        expect(!reader.find(keyOf(9)).has_value(), "missing key is a miss");
+        expect(reader.size() == 2, "hits in the file are remembered in memory");
+    }
+    {
+        Core::VerdictCache resized;
+        expect(resized.openFile(path, 32), "cache file is mapped with another count of slots");
+        expect(resized.find(keyOf(7)).has_value(), "cache file keeps its own count of slots");
+    }
+
+    // A broken file is replaced by a new one, a judge which maps the old one keeps it
+
+    {
+        Core::VerdictCache old;
+        expect(old.openFile(path, 64), "cache file is mapped before it breaks");
+        const auto old_size = std::filesystem::file_size(path);
+        std::fstream(path, std::ios::in | std::ios::out | std::ios::binary).write("broken", 6);
+        Core::VerdictCache rebuilt;
+        expect(rebuilt.openFile(path, 16), "broken cache file is mapped");
+        expect(!rebuilt.find(keyOf(7)).has_value(), "broken cache file starts empty");
+        expect(std::filesystem::file_size(path) < old_size, "broken cache file gets the given count of slots");
+        old.insert(keyOf(9), Core::CachedVerdict{ Core::Verdict::kFail, 1 });
+        expect(!rebuilt.find(keyOf(9)).has_value(), "old file is still mapped and isn't the new one");
+    }
+    std::filesystem::remove(path);
+
+    return expect.failures();
+}